@@ -23,6 +23,37 @@ dedicated to Onika Tanya Maraj-Petty, who taught me how to code, how to love, an
 #ifndef AVL_H
 #define AVL_H
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 202002L
+#include <compare>
+#include <concepts>
+#define AVL_THREE_WAY_COMPARISON 1
+#else
+#define AVL_THREE_WAY_COMPARISON 0
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define AVL_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define AVL_PREFETCH(address) ((void)0)
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //// helper classes
 enum struct taskStatus {
@@ -31,53 +62,479 @@ enum struct taskStatus {
 	INVALID_INPUT    = 2,
 	FAILURE          = 3,
 };
+// The following class is used to support output with status code.
+// the answer is only constructed on success, so T does not have to be default constructible, a failure costs nothing,
+// and a big or move only answer can be moved out with std::move(output).ans(). ans() must not be called on a failure.
+template<typename T>
+class tupleOutput {
+private:
+	
+	taskStatus __status;
+	std::optional<T> __ans;
+
+public:
+	tupleOutput() : __status(taskStatus::SUCCESS), __ans(std::in_place) { }
+	tupleOutput(taskStatus status) : __status(status) { }
+	tupleOutput(const T &ans) : __status(taskStatus::SUCCESS), __ans(ans) { }
+	tupleOutput(T &&ans) : __status(taskStatus::SUCCESS), __ans(std::move(ans)) { }
+	
+	taskStatus status() const { return __status; }
+	const T& ans() const & { assert(__ans.has_value()); return *__ans; }
+	T ans() && { assert(__ans.has_value()); return std::move(*__ans); }
+};
+// The following classes are aggregate policies. a policy tells the tree how to keep a value for every subtree,
+// the same way it keeps the number of nodes in every subtree. a policy has:
+//     value_type                      the type of the value.
+//     identity()                      the value of an empty range.
+//     fromData(const T& data)         the value of a range with a single key.
+//     combine(left, right)            the value of two neighbouring ranges, left comes before right. must be associative.
+// the tree then answers aggregate(low, high) and aggregateRank(first, last) in O(logn).
 template<class T>
-class tupleOutput;
+class NoAggregate{
+    public:
+    struct value_type{};
+    static value_type identity() {return value_type();}
+    static value_type fromData(const T&) {return value_type();}
+    static value_type combine(const value_type&, const value_type&) {return value_type();}
+};
+
+template<class T>
+class SumAggregate{
+    public:
+    typedef T value_type;
+    static value_type identity() {return T();}
+    static value_type fromData(const T& data) {return data;}
+    static value_type combine(const value_type& left, const value_type& right) {return left + right;}
+};
+
+template<class T>
+class MinAggregate{
+    public:
+    typedef T value_type;
+    static value_type identity() {return std::numeric_limits<T>::max();}
+    static value_type fromData(const T& data) {return data;}
+    static value_type combine(const value_type& left, const value_type& right) {return right < left ? right : left;}
+};
+
+template<class T>
+class MaxAggregate{
+    public:
+    typedef T value_type;
+    static value_type identity() {return std::numeric_limits<T>::lowest();}
+    static value_type fromData(const T& data) {return data;}
+    static value_type combine(const value_type& left, const value_type& right) {return left < right ? right : left;}
+};
+
+// The following class stores the aggregate of a subtree in the root of the subtree.
+// when the value of the policy is an empty class (like NoAggregate), it takes no space in the node.
+template<class Aggregate, bool = std::is_empty<typename Aggregate::value_type>::value>
+class AggregateField{
+    private:
+    typename Aggregate::value_type aggregate_m = Aggregate::identity();
+
+    public:
+    const typename Aggregate::value_type& getAggregate() const {return aggregate_m;}
+    taskStatus setAggregate(const typename Aggregate::value_type& aggregate) {this->aggregate_m = aggregate; return taskStatus::SUCCESS;}
+};
+
+template<class Aggregate>
+class AggregateField<Aggregate, true>{
+    public:
+    typename Aggregate::value_type getAggregate() const {return Aggregate::identity();}
+    taskStatus setAggregate(const typename Aggregate::value_type&) {return taskStatus::SUCCESS;}
+};
+
+// The following class is what Tree::stats returns: the counters of the instrumentation policy (all zero without one),
+// and the shape of the tree. the histograms are only filled by stats(true), since they cost a walk over the whole tree.
+enum struct rotationKind {LL, RR, LR, RL};
+struct TreeStats{
+    std::uint64_t llRotations_m = 0;
+    std::uint64_t rrRotations_m = 0;
+    std::uint64_t lrRotations_m = 0;
+    std::uint64_t rlRotations_m = 0;
+    std::uint64_t comparisons_m = 0; // calls to compare_m (or to operator<=>)
+    std::uint64_t descents_m = 0; // searches from the root down
+    std::uint64_t descentSteps_m = 0; // the nodes all the descents passed, descentSteps_m / descents_m is the mean depth
+    int maxDescent_m = 0;
+    std::uint64_t rebalanceWalks_m = 0; // walks of rebalance and retrace up from a changed node
+    std::uint64_t rebalanceSteps_m = 0; // the nodes all those walks passed
+    int maxRebalanceWalk_m = 0;
+    std::uint64_t allocations_m = 0; // nodes taken from the pool
+    std::uint64_t deallocations_m = 0; // nodes given back to the pool, clear counts the whole tree
+
+    int size_m = 0;
+    int height_m = 0;
+    std::vector<int> depthHistogram_m; // depthHistogram_m[d] is the number of keys at depth d, the root is at depth 0
+    std::vector<int> sizeHistogram_m; // sizeHistogram_m[b] is the number of subtrees with 2^b to 2^(b+1)-1 nodes
+};
+
+// The following classes are instrumentation policies. the tree calls the hooks of the policy on its hot paths:
+//     rotation(kind)              the rebalancing made a rotation of kind (LR and RL count once, not as two rotations).
+//     comparison()                one call to compare_m (or to operator<=>).
+//     descent(depth)              a search from the root passed depth nodes. findMany and selectMany count their
+//                                 comparisons but not their depths, so the lanes stay as lean as they are.
+//     rebalanceWalk(length)       rebalance or retrace passed length nodes on the way up.
+//     allocation(count)           count nodes were taken from the pool.
+//     deallocation(count)         count nodes were given back to the pool.
+//     fill(stats)                 copies the counters into stats, which is a new TreeStats.
+//     reset()                     sets the counters to zero.
+// NoInstrumentation is the default: its hooks are empty and inline and it has no members, so the calls and the
+// counting on the way (like the depth of a descent) are optimized away, and the tree is the same as without hooks.
+// CountingInstrumentation keeps relaxed atomic counters: a set operation with a ThreadPool (AVLSetOperations.h) and
+// the parallel functions of AVLParallel.h work on the tree from several threads at once, and every call is still
+// counted. fill and reset are not atomic as a whole, call them when no operation runs.
+class NoInstrumentation{
+    public:
+    void rotation(rotationKind) {}
+    void comparison() {}
+    void descent(int) {}
+    void rebalanceWalk(int) {}
+    void allocation(int) {}
+    void deallocation(int) {}
+    void fill(TreeStats&) const {}
+    void reset() {}
+};
+
+class CountingInstrumentation{
+    private:
+    typedef std::atomic<std::uint64_t> counter_type;
+    counter_type rotations_m[4] = {}; // in the order of rotationKind
+    counter_type comparisons_m{0};
+    counter_type descents_m{0};
+    counter_type descentSteps_m{0};
+    std::atomic<int> maxDescent_m{0};
+    counter_type rebalanceWalks_m{0};
+    counter_type rebalanceSteps_m{0};
+    std::atomic<int> maxRebalanceWalk_m{0};
+    counter_type allocations_m{0};
+    counter_type deallocations_m{0};
+
+    static void add(counter_type& counter, std::uint64_t count) {counter.fetch_add(count, std::memory_order_relaxed);}
+    static void raise(std::atomic<int>& most, int value){
+        int seen = most.load(std::memory_order_relaxed);
+        while(seen < value && !most.compare_exchange_weak(seen, value, std::memory_order_relaxed)){
+        }
+    }
+    static std::uint64_t read(const counter_type& counter) {return counter.load(std::memory_order_relaxed);}
+
+    public:
+    void rotation(rotationKind kind) {add(rotations_m[static_cast<int>(kind)], 1);}
+    void comparison() {add(comparisons_m, 1);}
+    void descent(int depth){
+        add(descents_m, 1);
+        add(descentSteps_m, depth);
+        raise(maxDescent_m, depth);
+    }
+    void rebalanceWalk(int length){
+        add(rebalanceWalks_m, 1);
+        add(rebalanceSteps_m, length);
+        raise(maxRebalanceWalk_m, length);
+    }
+    void allocation(int count) {add(allocations_m, count);}
+    void deallocation(int count) {add(deallocations_m, count);}
+    void fill(TreeStats& stats) const{
+        stats.llRotations_m = read(rotations_m[static_cast<int>(rotationKind::LL)]);
+        stats.rrRotations_m = read(rotations_m[static_cast<int>(rotationKind::RR)]);
+        stats.lrRotations_m = read(rotations_m[static_cast<int>(rotationKind::LR)]);
+        stats.rlRotations_m = read(rotations_m[static_cast<int>(rotationKind::RL)]);
+        stats.comparisons_m = read(comparisons_m);
+        stats.descents_m = read(descents_m);
+        stats.descentSteps_m = read(descentSteps_m);
+        stats.maxDescent_m = maxDescent_m.load(std::memory_order_relaxed);
+        stats.rebalanceWalks_m = read(rebalanceWalks_m);
+        stats.rebalanceSteps_m = read(rebalanceSteps_m);
+        stats.maxRebalanceWalk_m = maxRebalanceWalk_m.load(std::memory_order_relaxed);
+        stats.allocations_m = read(allocations_m);
+        stats.deallocations_m = read(deallocations_m);
+    }
+    void reset(){
+        for(counter_type& counter : rotations_m){
+            counter.store(0, std::memory_order_relaxed);
+        }
+        for(counter_type* counter : {&comparisons_m, &descents_m, &descentSteps_m, &rebalanceWalks_m, &rebalanceSteps_m,
+                                     &allocations_m, &deallocations_m}){
+            counter->store(0, std::memory_order_relaxed);
+        }
+        maxDescent_m.store(0, std::memory_order_relaxed);
+        maxRebalanceWalk_m.store(0, std::memory_order_relaxed);
+    }
+};
+#if defined(__has_cpp_attribute)
+#if __has_cpp_attribute(no_unique_address)
+#define AVL_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+#endif
+#ifndef AVL_NO_UNIQUE_ADDRESS
+#define AVL_NO_UNIQUE_ADDRESS
+#endif
+
+// The following classes are the binary format of save and load, and of MappedTree in AVLMapped.h.
+// a file is a SnapshotHeader and then the nodes in breadth first order: the root is node 0, a child is given by its
+// index (nil if there is none), and the top levels of the tree are next to each other in the file.
+// the numbers and the keys are written in the byte order of the machine, so a file is read on the machine type that wrote it.
+struct SnapshotHeader{
+    char magic_m[8];
+    std::uint32_t version_m;
+    std::uint32_t dataSize_m; // sizeof(T)
+    std::uint32_t nodeSize_m; // sizeof(SnapshotNode<T>)
+    std::int32_t count_m;
+    unsigned char reserved_m[40]; // zeros, so the nodes start 64 bytes into the file
+
+    static constexpr std::uint32_t currentVersion = 1;
+    static constexpr std::uint32_t nil = 0xFFFFFFFF;
+    template<class Record>
+    static SnapshotHeader make(int count){
+        SnapshotHeader header = {};
+        std::memcpy(header.magic_m, "AVLRANK", 8);
+        header.version_m = currentVersion;
+        header.dataSize_m = sizeof(Record::data_m);
+        header.nodeSize_m = sizeof(Record);
+        header.count_m = count;
+        return header;
+    }
+    template<class Record>
+    bool matches() const{
+        return std::memcmp(magic_m, "AVLRANK", 8) == 0 && version_m == currentVersion && dataSize_m == sizeof(Record::data_m)
+               && nodeSize_m == sizeof(Record) && count_m >= 0;
+    }
+};
+static_assert(sizeof(SnapshotHeader) == 64, "the nodes of a snapshot start 64 bytes into the file");
+
 template<class T>
+struct SnapshotNode{
+    T data_m;
+    std::uint32_t left_m;
+    std::uint32_t right_m;
+    std::int32_t height_m;
+    std::int32_t nodesInSubtree_m;
+};
+
+// The following functions read and write a field of a node as one atomic access, with std::atomic_ref in c++20, with
+// the builtins of gcc and clang before it, and through a std::atomic of the same size on other compilers (msvc), which
+// keep the value of an atomic of a lock free size as a plain value. a link is stored with release order, so a reader that
+// loads it with acquire order sees the node behind it as it was when it was linked.
+template<class X>
+X loadField(const X& field, std::memory_order order){
+#if defined(__cpp_lib_atomic_ref)
+    return std::atomic_ref<X>(const_cast<X&>(field)).load(order);
+#elif defined(__GNUC__) || defined(__clang__)
+    union Copy{
+        X value_m;
+        Copy(){}
+    } copy;
+    __atomic_load(&field, &copy.value_m, static_cast<int>(order));
+    return copy.value_m;
+#else
+    static_assert(sizeof(std::atomic<X>) == sizeof(X) && alignof(std::atomic<X>) == alignof(X), "the field is read as a std::atomic");
+    return reinterpret_cast<const std::atomic<X>&>(field).load(order);
+#endif
+}
+
+template<class X>
+void storeField(X& field, X value, std::memory_order order){
+#if defined(__cpp_lib_atomic_ref)
+    std::atomic_ref<X>(field).store(value, order);
+#elif defined(__GNUC__) || defined(__clang__)
+    __atomic_store(&field, &value, static_cast<int>(order));
+#else
+    static_assert(sizeof(std::atomic<X>) == sizeof(X) && alignof(std::atomic<X>) == alignof(X), "the field is written as a std::atomic");
+    reinterpret_cast<std::atomic<X>&>(field).store(value, order);
+#endif
+}
+
+// The following policy is an aggregate policy for a tree whose links are loaded by other threads while it changes, the
+// tree of ConcurrentTree (AVLConcurrent.h). the aggregate is the one of Aggregate; what changes is that the setters of
+// the links and of the count of Node, and getRoot and setRoot, go through storeField and loadField. every other tree
+// keeps plain loads and stores.
+template<class Aggregate>
+class SharedLinks : public Aggregate{};
+
+template<class Aggregate>
+struct hasSharedLinks : std::false_type{};
+template<class Aggregate>
+struct hasSharedLinks<SharedLinks<Aggregate>> : std::true_type{};
+
+template<class Aggregate, class X>
+X loadNodeField(const X& field, std::memory_order order){
+    if constexpr (hasSharedLinks<Aggregate>::value){
+        return loadField(field, order);
+    }
+    else{
+        return field;
+    }
+}
+
+template<class Aggregate, class X>
+void storeNodeField(X& field, X value, std::memory_order order){
+    if constexpr (hasSharedLinks<Aggregate>::value){
+        storeField(field, value, order);
+    }
+    else{
+        field = value;
+    }
+}
+
+template<class T, class Aggregate = NoAggregate<T>>
 class Node;
+template<class N>
+class NodePool;
+template<class T, class Aggregate = NoAggregate<T>>
+class TreeIterator;
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-template<class T>
+template<class T, class Compare = std::less<T>, class Aggregate = NoAggregate<T>, class Instrumentation = NoInstrumentation>
 class Tree{
     private:
-    Node<T>* root_m;
+    typedef typename Aggregate::value_type aggregate_type;
+    static const bool hasAggregate = !std::is_empty<aggregate_type>::value;
+    static const int lookupLanes = 16; // the number of descents findMany and selectMany run side by side
+    static constexpr int snapshotChunk = 4096; // save and load move this many nodes to or from the file at a time
+
+    Node<T, Aggregate>* root_m;
+    std::shared_ptr<NodePool<Node<T, Aggregate>>> pool_m; // all the nodes of the tree live here, see NodePool below.
+    Compare compare_m; // the order of the keys, compare_m(a, b) is true if a comes before b, like std::less
+    AVL_NO_UNIQUE_ADDRESS mutable Instrumentation instrumentation_m; // the counters of stats, counted by const methods too
+
+    template<class First, class Second>
+    bool isBefore(const First& first, const Second& second) const {instrumentation_m.comparison(); return compare_m(first, second);}
+    // std::lower_bound of key in a sorted batch, through isBefore, so the comparisons of the batches are counted too.
+    template<class Iterator>
+    Iterator lowerBoundIn(Iterator first, Iterator last, const T& key) const{
+        return std::lower_bound(first, last, key, [this](const auto& element, const T& bound){return isBefore(element, bound);});
+    }
+
+    template<class Key>
+    static constexpr bool threeWayWith(); // true if a node can be compared with a Key by a single operator<=>
+    template<class Key>
+    int compareKeys(const Key& key, const T& data) const; // negative, zero or positive, like operator<=>
+    template<class Rank>
+    static bool isRank(const Rank& rank, int size); // 0 <= rank < size, checked before rank is cast to an int
+    template<class Key>
+    tupleOutput<Node<T, Aggregate>*> findKey(const Key& key);
+    template<class Key>
+    tupleOutput<int> rankKey(const Key& key);
+    template<class Key>
+    tupleOutput<Node<T, Aggregate>*> lowerBoundKey(const Key& key);
+    template<class Key>
+    tupleOutput<Node<T, Aggregate>*> upperBoundKey(const Key& key);
+
+    template<class Iterator>
+    Node<T, Aggregate>* buildBalanced(Iterator& it, int count, Node<T, Aggregate>* parent, Node<T, Aggregate>*& prev, taskStatus& status);
+    template<class Iterator>
+    Node<T, Aggregate>* insertBatchRecursive(Node<T, Aggregate>* node, Iterator first, Iterator last, Iterator begin, Node<T, Aggregate>** handles, taskStatus* statuses);
+    template<class Iterator>
+    Node<T, Aggregate>* eraseBatchRecursive(Node<T, Aggregate>* node, Iterator first, Iterator last, Iterator begin, taskStatus* statuses);
 
     public:
+    typedef TreeIterator<T, Aggregate> iterator;
+    typedef TreeIterator<T, Aggregate> const_iterator; // the keys can not be changed in place, so both iterators are the same
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<iterator> const_reverse_iterator;
+
     //basic methods
-    Tree():root_m(nullptr){}
-    ~Tree(); // we will use a recursive method to destroy the tree.
-    tupleOutput<Node<T>*> insert(const T& data); // complexity O(logn)
+    explicit Tree(const Compare& compare = Compare()):root_m(nullptr), pool_m(std::make_shared<NodePool<Node<T, Aggregate>>>()), compare_m(compare){}
+    template<class Iterator>
+    Tree(Iterator first, Iterator last, const Compare& compare = Compare()); // complexity O(n), the range must be sorted, see assign
+    Tree(const Tree&) = delete;
+    Tree& operator=(const Tree&) = delete;
+    ~Tree(); // complexity O(number of chunks) for trivially destructible T and a pool that is not shared, O(n) otherwise
+    template<class Iterator>
+    taskStatus assign(Iterator first, Iterator last); // complexity O(n)
+    void clear(); // complexity O(number of chunks) for trivially destructible T and a pool that is not shared, O(n) otherwise
+    tupleOutput<Node<T, Aggregate>*> insert(const T& data); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> insert(T&& data); // complexity O(logn)
+    template<class... Args>
+    tupleOutput<Node<T, Aggregate>*> emplace(Args&&... args); // complexity O(logn)
     taskStatus remove(const T& data); // complexity O(logn)
-    tupleOutput<Node<T>*> find(const T& data); // complexity O(logn)
-    void printTree(Node<T>* node); // complexity O(n)
+    taskStatus erase(Node<T, Aggregate>* node); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> find(const T& data) {return findKey(data);} // complexity O(logn)
+    template<class Key, class C = Compare, class = typename C::is_transparent>
+    tupleOutput<Node<T, Aggregate>*> find(const Key& key) {return findKey(key);} // complexity O(logn), only for a transparent Compare
+    void printTree(Node<T, Aggregate>* node); // complexity O(n)
 
     // advanced methods
-    Node<T>* findMin(Node<T>* node); // complexity O(logn)
-    Node<T>* findMax(Node<T>* node); // complexity O(logn)
-    Node<T>* findParent(Node<T>* node); // complexity O(1)
-    Node<T>* findSuccessor(Node<T>* node); // complexity O(logn)
-    Node<T>* findPredecessor(Node<T>* node); // complexity O(logn)
-    taskStatus inOrder(Node<T>* node, void (*func)(T,int*,void*), int* counter, void* array); // complexity O(n)
+    Node<T, Aggregate>* findMin(Node<T, Aggregate>* node); // complexity O(logn)
+    Node<T, Aggregate>* findMax(Node<T, Aggregate>* node); // complexity O(logn)
+    Node<T, Aggregate>* findParent(Node<T, Aggregate>* node); // complexity O(1)
+    Node<T, Aggregate>* findSuccessor(Node<T, Aggregate>* node); // complexity O(logn)
+    Node<T, Aggregate>* findPredecessor(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus inOrder(Node<T, Aggregate>* node, void (*func)(T,int*,void*), int* counter, void* array); // complexity O(n)
     taskStatus inOrderArray(void (*func)(T,int*,void*), void* array); // complexity O(n)
-    Node<T>* createTreeFromSortedArray(Node<T>** array, int start, int end,Node<T>* parent = nullptr); // complexity O(n)
-    tupleOutput<Node<T>*> findKthElement(int k); // complexity O(logn)
+    template<class Function>
+    taskStatus inOrder(Function&& func); // complexity O(n)
+    iterator begin() const; // complexity O(logn)
+    iterator end() const {return iterator(nullptr, &root_m);} // complexity O(1)
+    reverse_iterator rbegin() const {return reverse_iterator(end());} // complexity O(1)
+    reverse_iterator rend() const {return reverse_iterator(begin());} // complexity O(logn)
+    Node<T, Aggregate>* createTreeFromSortedArray(Node<T, Aggregate>** array, int start, int end,Node<T, Aggregate>* parent = nullptr); // complexity O(n)
+    tupleOutput<Node<T, Aggregate>*> findKthElement(int k); // complexity O(logn)
+    tupleOutput<int> rank(const T& data) {return rankKey(data);} // complexity O(logn)
+    template<class Key, class C = Compare, class = typename C::is_transparent>
+    tupleOutput<int> rank(const Key& key) {return rankKey(key);} // complexity O(logn), only for a transparent Compare
+    tupleOutput<int> rank(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus updateKey(Node<T, Aggregate>* node, T data); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> lowerBound(const T& data) {return lowerBoundKey(data);} // complexity O(logn)
+    template<class Key, class C = Compare, class = typename C::is_transparent>
+    tupleOutput<Node<T, Aggregate>*> lowerBound(const Key& key) {return lowerBoundKey(key);} // complexity O(logn), only for a transparent Compare
+    tupleOutput<Node<T, Aggregate>*> upperBound(const T& data) {return upperBoundKey(data);} // complexity O(logn)
+    template<class Key, class C = Compare, class = typename C::is_transparent>
+    tupleOutput<Node<T, Aggregate>*> upperBound(const Key& key) {return upperBoundKey(key);} // complexity O(logn), only for a transparent Compare
+    Compare getCompare() const {return compare_m;} // complexity O(1)
+    size_t memoryUsage() const; // complexity O(number of chunks)
+    double memoryPerNode() const; // complexity O(number of chunks)
+    int countRange(const T& low, const T& high); // complexity O(logn)
+    tupleOutput<typename Aggregate::value_type> aggregate(const T& low, const T& high); // complexity O(logn)
+    tupleOutput<typename Aggregate::value_type> aggregateRank(int first, int last); // complexity O(logn)
+    template<class Function>
+    taskStatus visitRange(const T& low, const T& high, Function&& func); // complexity O(logn + k)
+    template<class Iterator>
+    taskStatus insertBatch(Iterator first, Iterator last, Node<T, Aggregate>** handles = nullptr, taskStatus* statuses = nullptr); // complexity O(mlog(n/m+1))
+    template<class Iterator>
+    taskStatus eraseBatch(Iterator first, Iterator last, taskStatus* statuses = nullptr); // complexity O(mlog(n/m+1))
+    template<class Iterator>
+    taskStatus findMany(Iterator first, Iterator last, Node<T, Aggregate>** handles); // complexity O(mlogn)
+    template<class Iterator>
+    taskStatus selectMany(Iterator first, Iterator last, Node<T, Aggregate>** handles); // complexity O(mlogn)
+    taskStatus split(const T& key, Tree<T, Compare, Aggregate, Instrumentation>& right); // complexity O(logn)
+    taskStatus join(Tree<T, Compare, Aggregate, Instrumentation>& right); // complexity O(logn)
+    taskStatus save(const char* path) const; // complexity O(n)
+    taskStatus load(const char* path); // complexity O(n)
+    TreeStats stats(bool histograms = false) const; // complexity O(1), O(n) with the histograms
+    void resetStats() {instrumentation_m.reset();} // complexity O(1)
     
     
     
     // helper methods
-    Node<T>* getRoot() const {return root_m;} // we will use this method to get the root of the tree.
-    taskStatus setRoot(Node<T>* root) {this->root_m = root; return taskStatus::SUCCESS;} // we will use this method to set the root of the tree.
-    taskStatus RRrotation(Node<T>* node); // complexity O(1)
-    taskStatus LLrotation(Node<T>* node); // complexity O(1)
-    taskStatus RLrotation(Node<T>* node); // complexity O(1)
-    taskStatus LRrotation(Node<T>* node); // complexity O(1)
-    taskStatus rebalance(Node<T>* node); // complexity O(1)
-    taskStatus updateHeight(Node<T>* node); // complexity O(1)
-    taskStatus switchNodesLocation(Node<T>* node1, Node<T>* node2); // complexity O(1)
-    int getBalanceFactor(Node<T>* node); // complexity O(1)
-    int getBalance(Node<T>* node); // complexity O(1)
-    void DestroyRecursive(Node<T>* node); // complexity O(n)
-    taskStatus updateNodesInSubTree(Node<T> *node); // complexity O(1)
+    Node<T, Aggregate>* getRoot() const {return loadNodeField<Aggregate>(root_m, std::memory_order_acquire);} // we will use this method to get the root of the tree.
+    taskStatus setRoot(Node<T, Aggregate>* root) {storeNodeField<Aggregate>(root_m, root, std::memory_order_release); return taskStatus::SUCCESS;} // we will use this method to set the root of the tree.
+    taskStatus RRrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus LLrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus RLrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus LRrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus rebalance(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus retrace(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus linkNode(Node<T, Aggregate>* node, Node<T, Aggregate>* parent); // complexity O(logn)
+    taskStatus unlinkNode(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus updateHeight(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus switchNodesLocation(Node<T, Aggregate>* node1, Node<T, Aggregate>* node2); // complexity O(1)
+    int getBalanceFactor(Node<T, Aggregate>* node); // complexity O(1)
+    int getBalance(Node<T, Aggregate>* node); // complexity O(1)
+    void DestroyRecursive(Node<T, Aggregate>* node); // complexity O(n)
+    taskStatus updateNodesInSubTree(Node<T, Aggregate> *node); // complexity O(1)
+    template<class... Args>
+    Node<T, Aggregate>* allocateNode(Args&&... args); // complexity O(1) amortized
+    Node<T, Aggregate>* allocateNodes(int count); // complexity O(1)
+    taskStatus insertionPoint(const T& data, Node<T, Aggregate>*& parent); // complexity O(logn)
+    void deallocateNode(Node<T, Aggregate>* node); // complexity O(1)
+    Node<T, Aggregate>* rebalanceStep(Node<T, Aggregate>* node); // complexity O(1)
+    Node<T, Aggregate>* joinWithPivot(Node<T, Aggregate>* left, Node<T, Aggregate>* pivot, Node<T, Aggregate>* right); // complexity O(|height(left) - height(right)|)
+    Node<T, Aggregate>* joinSubtrees(Node<T, Aggregate>* left, Node<T, Aggregate>* right); // complexity O(logn)
+    Node<T, Aggregate>* splitSubtree(Node<T, Aggregate>* node, const T& key, Node<T, Aggregate>*& left, Node<T, Aggregate>*& right); // complexity O(logn)
+    void sharePoolWith(Tree<T, Compare, Aggregate, Instrumentation>& other); // complexity O(number of pools)
+    void detachPool(); // complexity O(1)
+    int countPools() const; // complexity O(number of pools)
+    int countSmaller(const T& data); // complexity O(logn)
+    static typename Aggregate::value_type getSubtreeAggregate(Node<T, Aggregate>* node); // complexity O(1)
     int getSize() const {
         if (root_m == nullptr){
             return 0;
@@ -91,162 +548,247 @@ class Tree{
 
 ////////////// basic methods //////////////
 /*
-Tree():root_m(nullptr){}
-    ~Tree(); // we will use a recursive method to destroy the tree.
-    tupleOutput<Node<T>*> insert(T data); // we will use this method to insert a new node to the tree.
+Tree(const Compare& compare = Compare()):root_m(nullptr), compare_m(compare){}
+    Tree(Iterator first, Iterator last, const Compare& compare = Compare()); // complexity O(n), the range must be sorted, see assign
+    ~Tree(); // complexity O(number of chunks) for trivially destructible T and a pool that is not shared, O(n) otherwise
+    taskStatus assign(Iterator first, Iterator last); // complexity O(n)
+    void clear(); // complexity O(number of chunks) for trivially destructible T and a pool that is not shared, O(n) otherwise
+    tupleOutput<Node<T, Aggregate>*> insert(T data); // we will use this method to insert a new node to the tree.
+    tupleOutput<Node<T, Aggregate>*> insert(T&& data); // the same, the data is moved into the node.
+    tupleOutput<Node<T, Aggregate>*> emplace(Args&&... args); // the same, the data is constructed in the node from args.
     taskStatus remove(T data); // we will use this method to remove a node from the tree.
-    tupleOutput<Node<T>*> find(T data); // we will use this method to find a node in the tree.
-    void printTree(Node<T>* node); // complexity O(n)
+    taskStatus erase(Node<T, Aggregate>* node); // we will use this method to remove a node we already hold, without searching for it.
+    tupleOutput<Node<T, Aggregate>*> find(T data); // we will use this method to find a node in the tree.
+    tupleOutput<Node<T, Aggregate>*> find(const Key& key); // the same, with a key of another type, only for a transparent Compare like std::less<>
+    void printTree(Node<T, Aggregate>* node); // complexity O(n)
 */
 
-template<class T>
-Tree<T>::~Tree(){
-    DestroyRecursive(root_m);
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+Tree<T, Compare, Aggregate, Instrumentation>::Tree(Iterator first, Iterator last, const Compare& compare):root_m(nullptr), pool_m(std::make_shared<NodePool<Node<T, Aggregate>>>()), compare_m(compare){
+    // a constructor can not return a status, if the range is not sorted the tree is left empty.
+    assign(first, last);
 }
 
-template<class T>
-tupleOutput<Node<T>*> Tree<T>::insert(const T& data){
-    Node<T>* newNode = new Node<T>(data);
-    newNode->NodesInSubtree_m = 1;
-    if(newNode == nullptr){
-        return tupleOutput<Node<T>*>(taskStatus::ALLOCATION_ERROR);
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Tree<T, Compare, Aggregate, Instrumentation>::~Tree(){
+    clear();
+}
+
+// replaces the content of the tree with the values in [first, last).
+// the values must be sorted in a strictly increasing order, otherwise the tree is left empty and INVALID_INPUT is returned.
+// the tree is built bottom up as a perfectly balanced tree, without any comparisons on the way down and without rotations,
+// and the nodes are taken one after the other from a single chunk, so they are contiguous in memory and in order.
+// to build a tree of move only values, pass std::make_move_iterator(first), std::make_move_iterator(last).
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::assign(Iterator first, Iterator last){
+    clear();
+    auto distance = std::distance(first, last);
+    if(distance <= 0){
+        return taskStatus::SUCCESS;
     }
-    if(root_m == nullptr){
-        root_m = newNode;
-        return tupleOutput<Node<T>*>(newNode);
+    int count = static_cast<int>(distance);
+    if(!pool_m->reserve(count)){
+        return taskStatus::ALLOCATION_ERROR;
     }
-    Node<T>* current = root_m;
-    Node<T>* parent = nullptr;
-    while(current != nullptr){
-        parent = current;
-        if(data < current->getData()){
-            current = current->getLeft();
+    Node<T, Aggregate>* prev = nullptr;
+    taskStatus status = taskStatus::SUCCESS;
+    root_m = buildBalanced(first, count, nullptr, prev, status);
+    if(status != taskStatus::SUCCESS){
+        clear();
+    }
+    return status;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::buildBalanced(Iterator& it, int count, Node<T, Aggregate>* parent, Node<T, Aggregate>*& prev, taskStatus& status){
+    if(count == 0){
+        return nullptr;
+    }
+    // the left subtree is built first, so the nodes are allocated in order.
+    int leftCount = (count - 1) / 2;
+    Node<T, Aggregate>* left = buildBalanced(it, leftCount, nullptr, prev, status);
+    // the pool was reserved by assign, so this allocation can not fail.
+    Node<T, Aggregate>* node = pool_m->allocate(std::in_place, *it);
+    instrumentation_m.allocation(1);
+    ++it;
+    if(prev != nullptr && !isBefore(prev->data_m, node->data_m)){
+        status = taskStatus::INVALID_INPUT;
+    }
+    prev = node;
+    node->setParent(parent);
+    node->setLeft(left);
+    if(left != nullptr){
+        left->setParent(node);
+    }
+    node->setRight(buildBalanced(it, count - 1 - leftCount, node, prev, status));
+    updateHeight(node);
+    updateNodesInSubTree(node);
+    return node;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void Tree<T, Compare, Aggregate, Instrumentation>::clear(){
+    // the pool frees its chunks all at once, so we only have to run the destructors of the data.
+    // for trivially destructible data (and aggregates) there is nothing to run, and we do not touch the nodes at all.
+    // a pool that is shared with another tree (after split or join) can not be released,
+    // so in that case every node is given back to the pool on its own.
+    bool shared = pool_m.use_count() > 1;
+    if(!shared){
+        instrumentation_m.deallocation(getSize());
+    }
+    if(std::is_trivially_destructible<T>::value && std::is_trivially_destructible<aggregate_type>::value && !shared){
+        root_m = nullptr;
+        pool_m->release();
+        return;
+    }
+    // iterative post order walk, so deep trees can not overflow the stack.
+    Node<T, Aggregate>* node = root_m;
+    while(node != nullptr){
+        if(node->getLeft() != nullptr){
+            node = node->getLeft();
         }
-        else if(data > current->getData()){
-            current = current->getRight();
+        else if(node->getRight() != nullptr){
+            node = node->getRight();
         }
         else{
-            delete newNode;
-            return tupleOutput<Node<T>*>(taskStatus::FAILURE);
+            Node<T, Aggregate>* parent = node->getParent();
+            if(parent != nullptr){
+                if(parent->getLeft() == node){
+                    parent->setLeft(nullptr);
+                }
+                else{
+                    parent->setRight(nullptr);
+                }
+            }
+            if(shared){
+                deallocateNode(node);
+            }
+            else{
+                node->~Node<T, Aggregate>();
+            }
+            node = parent;
         }
     }
-    newNode->setParent(parent);
-    
-    if(data < parent->getData()){
-        parent->setLeft(newNode);
+    root_m = nullptr;
+    if(!shared){
+        pool_m->release();
     }
-    else{
-        parent->setRight(newNode);
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+tupleOutput<Node<T, Aggregate>*> Tree<T, Compare, Aggregate, Instrumentation>::insert(const T& data){
+    Node<T, Aggregate>* parent = nullptr;
+    if(insertionPoint(data, parent) != taskStatus::SUCCESS){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
     }
-    while (parent != nullptr){
-        parent->setNodesInSubtree(parent->getNodesInSubtree() + 1);
-        parent = parent->getParent();
+    // we allocate only after the search, so a duplicate key costs no allocation.
+    Node<T, Aggregate>* newNode = allocateNode(data);
+    if(newNode == nullptr){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::ALLOCATION_ERROR);
     }
-    if (root_m != nullptr){
-        int rootNodesInSubtree=0;
-        if (root_m->getLeft() != nullptr){
-            rootNodesInSubtree += root_m->getLeft()->getNodesInSubtree();
-        }
-        if (root_m->getRight() != nullptr){
-            rootNodesInSubtree += root_m->getRight()->getNodesInSubtree();
-        }
-        root_m->setNodesInSubtree(rootNodesInSubtree + 1);
+    linkNode(newNode, parent);
+    return tupleOutput<Node<T, Aggregate>*>(newNode);
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+tupleOutput<Node<T, Aggregate>*> Tree<T, Compare, Aggregate, Instrumentation>::insert(T&& data){
+    Node<T, Aggregate>* parent = nullptr;
+    if(insertionPoint(data, parent) != taskStatus::SUCCESS){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
     }
-    taskStatus status = rebalance(newNode);
-    if (status != taskStatus::SUCCESS){
-        return tupleOutput<Node<T>*>(status);
+    Node<T, Aggregate>* newNode = allocateNode(std::move(data));
+    if(newNode == nullptr){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::ALLOCATION_ERROR);
     }
-    return tupleOutput<Node<T>*>(newNode);
+    linkNode(newNode, parent);
+    return tupleOutput<Node<T, Aggregate>*>(newNode);
 }
 
-template<class T>
-taskStatus Tree<T>::remove(const T& data){
-    tupleOutput<Node<T>*> output= find(data);
-    if (output.status() != taskStatus::SUCCESS){
-        return output.status();
+// the key is only known after it is constructed, so here the node is allocated before the search,
+// and freed again if the key is already in the tree.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class... Args>
+tupleOutput<Node<T, Aggregate>*> Tree<T, Compare, Aggregate, Instrumentation>::emplace(Args&&... args){
+    Node<T, Aggregate>* newNode = allocateNode(std::forward<Args>(args)...);
+    if(newNode == nullptr){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::ALLOCATION_ERROR);
     }
-    Node<T>* node = output.ans();
-    if(node == nullptr){
-        return taskStatus::FAILURE;
+    Node<T, Aggregate>* parent = nullptr;
+    if(insertionPoint(newNode->data_m, parent) != taskStatus::SUCCESS){
+        deallocateNode(newNode);
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
     }
-    Node<T>* parent = node->getParent();
-    if(node->getLeft() == nullptr && node->getRight() == nullptr){
-        if(parent == nullptr){
-            setRoot(nullptr);
-        }
-        else if(parent->getLeft() == node){
-            parent->setLeft(nullptr);
-            parent -> setNodesInSubtree(parent->getNodesInSubtree() - 1);
-        }
-        else{
-            parent->setRight(nullptr);
-            parent -> setNodesInSubtree(parent->getNodesInSubtree() - 1);
-        }
-        T temp = T();
-        temp = node->data_m;
-        delete node;
-        return rebalance(parent);
-    }
-    else if(node->getLeft() == nullptr || node->getRight() == nullptr){
-        Node<T>* child = node->getLeft() == nullptr ? node->getRight() : node->getLeft();
-        if(parent == nullptr){
-            setRoot(child);
-        }
-        else if(parent->getLeft() == node){
-            parent->setLeft(child);
-            parent -> setNodesInSubtree(parent->getNodesInSubtree() - 1);
-        }
-        else{
-            parent->setRight(child);
-            parent -> setNodesInSubtree(parent->getNodesInSubtree() - 1);
-        }
-        child->setParent(parent);
-        T temp;
-        temp = node->data_m;
-        
-        delete node;
-        return rebalance(parent);
+    linkNode(newNode, parent);
+    return tupleOutput<Node<T, Aggregate>*>(newNode);
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::remove(const T& data){
+    tupleOutput<Node<T, Aggregate>*> output= find(data);
+    if (output.status() != taskStatus::SUCCESS){
+        return output.status();
     }
-    else{
-        // if we got here, it means that the node has two children.
-        Node<T>* successor = node->getRight();
-        while(successor->getLeft() != nullptr){
-            successor = successor->getLeft();
-        }
-        T temp = T();
-        temp = successor->data_m;
-        switchNodesLocation(node, successor);
-        remove(temp);
-        T temp2 = T();
-        temp2 =temp;
-        successor->data_m = temp2;
-        return taskStatus::SUCCESS;
+    return erase(output.ans());
+}
 
+// removes a node we already hold, without searching for it and without any key comparisons.
+// node must be a node of this tree. the other nodes keep their addresses, including the successor of node,
+// which is moved into the place of node by relinking, not by copying the data.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::erase(Node<T, Aggregate>* node){
+    if(node == nullptr){
+        return taskStatus::INVALID_INPUT;
     }
+    unlinkNode(node);
+    deallocateNode(node);
+    return taskStatus::SUCCESS;
 }
 
-template<class T>
-tupleOutput<Node<T>*> Tree<T>::find(const T& data){
-    Node<T>* current = root_m;
-    while(current != nullptr){
-        if(current->data_m == data){
-            return tupleOutput<Node<T>*>(current);
-        }
-        if(current->data_m > data){
-            current = current->getLeft();
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Key>
+tupleOutput<Node<T, Aggregate>*> Tree<T, Compare, Aggregate, Instrumentation>::findKey(const Key& key){
+    Node<T, Aggregate>* current = root_m;
+    int depth = 0;
+    if constexpr (threeWayWith<Key>()){
+        while(current != nullptr){
+            depth++;
+            int order = compareKeys(key, current->data_m);
+            if(order == 0){
+                instrumentation_m.descent(depth);
+                return tupleOutput<Node<T, Aggregate>*>(current);
+            }
+            current = order < 0 ? current->getLeft() : current->getRight();
         }
-        else if(current->data_m < data ){
-            current = current->getRight();
+        instrumentation_m.descent(depth);
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
+    }
+    else{
+        // a single call to compare_m per node: we go all the way down and remember the last node that is not smaller
+        // than key, it is the only node that can be equal to key.
+        Node<T, Aggregate>* bound = nullptr;
+        while(current != nullptr){
+            depth++;
+            if(isBefore(current->data_m, key)){
+                current = current->getRight();
+            }
+            else{
+                bound = current;
+                current = current->getLeft();
+            }
         }
-        else{
-            return tupleOutput<Node<T>*>(current);
+        instrumentation_m.descent(depth);
+        if(bound == nullptr || isBefore(key, bound->data_m)){
+            return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
         }
+        return tupleOutput<Node<T, Aggregate>*>(bound);
     }
-    return tupleOutput<Node<T>*>(taskStatus::FAILURE);
 }
 
-template<class T>
-void Tree<T>::printTree(Node<T>* node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void Tree<T, Compare, Aggregate, Instrumentation>::printTree(Node<T, Aggregate>* node){
     if (node == nullptr){
         return;
     }
@@ -265,29 +807,60 @@ void Tree<T>::printTree(Node<T>* node){
 //////// advanced methods ////////
 /*
 // advanced methods
-    Node<T>* findMin(Node<T>* node); // complexity O(logn)
-    Node<T>* findMax(Node<T>* node); // complexity O(logn)
-    Node<T>* findParent(Node<T>* node); // complexity O(1)
-    Node<T>* findSuccessor(Node<T>* node); // complexity O(logn)
-    Node<T>* findPredecessor(Node<T>* node); // complexity O(logn)
-    taskStatus inOrder(Node<T>* node, void (*func)(T,int*,void*), int* counter, void* array); // complexity O(n)
+    Node<T, Aggregate>* findMin(Node<T, Aggregate>* node); // complexity O(logn)
+    Node<T, Aggregate>* findMax(Node<T, Aggregate>* node); // complexity O(logn)
+    Node<T, Aggregate>* findParent(Node<T, Aggregate>* node); // complexity O(1)
+    Node<T, Aggregate>* findSuccessor(Node<T, Aggregate>* node); // complexity O(logn)
+    Node<T, Aggregate>* findPredecessor(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus inOrder(Node<T, Aggregate>* node, void (*func)(T,int*,void*), int* counter, void* array); // complexity O(n)
     taskStatus inOrderArray(void (*func)(T,int*,void*), void* array); // complexity O(n)
-    Node<T>* createTreeFromSortedArray(Node<T>** array, int start, int end,Node<T>* parent = nullptr); // complexity O(n)
-    tupleOutput<Node<T>*> findKthElement(int k); // complexity O(logn)
+    taskStatus inOrder(Function&& func); // complexity O(n)
+    iterator begin() const; // complexity O(logn)
+    iterator end() const; // complexity O(1)
+    reverse_iterator rbegin() const; // complexity O(1)
+    reverse_iterator rend() const; // complexity O(logn)
+    Node<T, Aggregate>* createTreeFromSortedArray(Node<T, Aggregate>** array, int start, int end,Node<T, Aggregate>* parent = nullptr); // complexity O(n)
+    tupleOutput<Node<T, Aggregate>*> findKthElement(int k); // complexity O(logn)
+    tupleOutput<int> rank(const T& data); // complexity O(logn)
+    tupleOutput<int> rank(const Key& key); // complexity O(logn), only for a transparent Compare
+    tupleOutput<int> rank(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus updateKey(Node<T, Aggregate>* node, T data); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> lowerBound(const T& data); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> lowerBound(const Key& key); // complexity O(logn), only for a transparent Compare
+    tupleOutput<Node<T, Aggregate>*> upperBound(const T& data); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> upperBound(const Key& key); // complexity O(logn), only for a transparent Compare
+    Compare getCompare() const {return compare_m;} // complexity O(1)
+    size_t memoryUsage() const; // complexity O(number of chunks)
+    double memoryPerNode() const; // complexity O(number of chunks)
+    int countRange(const T& low, const T& high); // complexity O(logn)
+    tupleOutput<typename Aggregate::value_type> aggregate(const T& low, const T& high); // complexity O(logn)
+    tupleOutput<typename Aggregate::value_type> aggregateRank(int first, int last); // complexity O(logn)
+    template<class Function>
+    taskStatus visitRange(const T& low, const T& high, Function&& func); // complexity O(logn + k)
+    taskStatus insertBatch(Iterator first, Iterator last, Node<T, Aggregate>** handles = nullptr, taskStatus* statuses = nullptr); // complexity O(mlog(n/m+1))
+    taskStatus eraseBatch(Iterator first, Iterator last, taskStatus* statuses = nullptr); // complexity O(mlog(n/m+1))
+    taskStatus findMany(Iterator first, Iterator last, Node<T, Aggregate>** handles); // complexity O(mlogn), the keys do not have to be sorted
+    taskStatus selectMany(Iterator first, Iterator last, Node<T, Aggregate>** handles); // complexity O(mlogn), findKthElement for many k
+    taskStatus split(const T& key, Tree<T, Compare, Aggregate, Instrumentation>& right); // complexity O(logn)
+    taskStatus join(Tree<T, Compare, Aggregate, Instrumentation>& right); // complexity O(logn)
+    taskStatus save(const char* path) const; // complexity O(n), only for trivially copyable T
+    taskStatus load(const char* path); // complexity O(n), no comparisons and no rotations
+    TreeStats stats(bool histograms = false) const; // complexity O(1), O(n) with the histograms, the counters need an instrumentation policy
+    void resetStats(); // complexity O(1)
 */
 
-template<class T>
-Node<T>* Tree<T>::findMin(Node<T>* node){
-    Node<T>* curr = node;
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::findMin(Node<T, Aggregate>* node){
+    Node<T, Aggregate>* curr = node;
     while(curr->getLeft() != nullptr){
         curr = curr->getLeft();
     }
     return curr;
 }
 
-template<class T>
-Node<T>* Tree<T>::findMax(Node<T>* node){
-    Node<T>* curr = node;
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::findMax(Node<T, Aggregate>* node){
+    Node<T, Aggregate>* curr = node;
     if(curr == nullptr){
         return nullptr;
     }
@@ -297,23 +870,23 @@ Node<T>* Tree<T>::findMax(Node<T>* node){
     return curr;
 }
 
-template<class T>
-Node<T>* Tree<T>::findParent(Node<T>* node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::findParent(Node<T, Aggregate>* node){
         if(node == nullptr){
             return nullptr;
         }
         return node->getParent();
 }
 
-template<class T>
-Node<T>* Tree<T>::findSuccessor(Node<T>* node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::findSuccessor(Node<T, Aggregate>* node){
     if(node == nullptr){
         return nullptr;
     }
     if(node->getRight() != nullptr){
         return findMin(node->getRight());
     }
-    Node<T>* parent = node->getParent();
+    Node<T, Aggregate>* parent = node->getParent();
     while(parent != nullptr && node == parent->getRight()){
         node = parent;
         parent = parent->getParent();
@@ -321,8 +894,8 @@ Node<T>* Tree<T>::findSuccessor(Node<T>* node){
     return parent;
 }
 
-template<class T>
-Node<T>* Tree<T>::findPredecessor(Node<T>* node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::findPredecessor(Node<T, Aggregate>* node){
     if(node == nullptr){
         return nullptr;
     }
@@ -332,7 +905,7 @@ Node<T>* Tree<T>::findPredecessor(Node<T>* node){
         return findMax(node->getLeft());
     }
     
-    Node<T>* parent = node->getParent();
+    Node<T, Aggregate>* parent = node->getParent();
     
     while(parent != nullptr && node == parent->getLeft()){
         node = parent;
@@ -343,15 +916,20 @@ Node<T>* Tree<T>::findPredecessor(Node<T>* node){
     return parent;
 }
 
-template<class T>
-Node<T>* findNext(Node<T>* node){
+// the following two functions do not need the tree, so they can be used by the iterators.
+template<class T, class Aggregate>
+Node<T, Aggregate>* findNext(Node<T, Aggregate>* node){
     if(node == nullptr){
         return nullptr;
     }
     if(node->getRight() != nullptr){
-        return findMin(node->getRight());
+        node = node->getRight();
+        while(node->getLeft() != nullptr){
+            node = node->getLeft();
+        }
+        return node;
     }
-    Node<T>* parent = node->getParent();
+    Node<T, Aggregate>* parent = node->getParent();
     while(parent != nullptr && node == parent->getRight()){
         node = parent;
         parent = parent->getParent();
@@ -359,15 +937,19 @@ Node<T>* findNext(Node<T>* node){
     return parent;
 }
 
-template<class T>
-Node<T>* findPrev(Node<T>* node){
+template<class T, class Aggregate>
+Node<T, Aggregate>* findPrev(Node<T, Aggregate>* node){
     if(node == nullptr){
         return nullptr;
     }
     if(node->getLeft() != nullptr){
-        return findMax(node->getLeft());
+        node = node->getLeft();
+        while(node->getRight() != nullptr){
+            node = node->getRight();
+        }
+        return node;
     }
-    Node<T>* parent = node->getParent();
+    Node<T, Aggregate>* parent = node->getParent();
     while(parent != nullptr && node == parent->getLeft()){
         node = parent;
         parent = parent->getParent();
@@ -375,8 +957,8 @@ Node<T>* findPrev(Node<T>* node){
     return parent;
 }
 
-template<class T>
-taskStatus Tree<T>::inOrder(Node<T>* node, void (*func)(T,int*,void*), int* counter , void* array){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::inOrder(Node<T, Aggregate>* node, void (*func)(T,int*,void*), int* counter , void* array){
     if(node == nullptr){
         return taskStatus::SUCCESS;
     }
@@ -387,96 +969,984 @@ taskStatus Tree<T>::inOrder(Node<T>* node, void (*func)(T,int*,void*), int* coun
     return taskStatus::SUCCESS;
 }
 
-template<class T>
-taskStatus Tree<T>::inOrderArray(void (*func)(T,int*,void*), void* array){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::inOrderArray(void (*func)(T,int*,void*), void* array){
     int counter = 0;
     inOrder(root_m, func, &counter, array);
     return taskStatus::SUCCESS;
 }
 
-template<class T>
-Node<T>* Tree<T>::createTreeFromSortedArray(Node<T>** array, int start, int end, Node<T>* parent){
+// calls func(key) for every key in increasing order. func is taken by reference and can be any callable,
+// and if it returns bool, returning false stops the traversal.
+// we walk with the parent pointers instead of recursing, so the stack does not grow with the height.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Function>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::inOrder(Function&& func){
+    for(Node<T, Aggregate>* node = root_m == nullptr ? nullptr : findMin(root_m); node != nullptr; node = findNext(node)){
+        const T& data = node->data_m;
+        if constexpr (std::is_same<decltype(func(data)), bool>::value){
+            if(!func(data)){
+                break;
+            }
+        }
+        else{
+            func(data);
+        }
+    }
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+TreeIterator<T, Aggregate> Tree<T, Compare, Aggregate, Instrumentation>::begin() const{
+    if(root_m == nullptr){
+        return end();
+    }
+    Node<T, Aggregate>* node = root_m;
+    while(node->getLeft() != nullptr){
+        node = node->getLeft();
+    }
+    return iterator(node, &root_m);
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::createTreeFromSortedArray(Node<T, Aggregate>** array, int start, int end, Node<T, Aggregate>* parent){
     if(start > end || start < 0 || end < 0){
         return nullptr;
     }
     int mid = (start + end)/2;
-    Node<T>* node = array[mid];
+    Node<T, Aggregate>* node = array[mid];
     if (parent == nullptr){
         this->setRoot(node);
     }
-    else{
-        node->setParent(parent);
-    }
+    node->setParent(parent);
     node->setLeft(createTreeFromSortedArray(array, start, mid-1, node));
     node->setRight(createTreeFromSortedArray(array, mid+1, end, node));
     updateHeight(node);
+    updateNodesInSubTree(node);
     return node;
 }
 
-template<class T>
-tupleOutput<Node<T>*> Tree<T>::findKthElement(int k){
-    if(k < 0 || k >= this->root_m->getNodesInSubtree()){
-        return tupleOutput<Node<T>*>(taskStatus::INVALID_INPUT);
+template<class T, class Compare, class Aggregate, class Instrumentation>
+tupleOutput<Node<T, Aggregate>*> Tree<T, Compare, Aggregate, Instrumentation>::findKthElement(int k){
+    if(k < 0 || k >= getSize()){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::INVALID_INPUT);
     }
-    Node<T>* node = this->root_m;
+    Node<T, Aggregate>* node = this->root_m;
     // we will find the kth smallest element in the tree.
     // if k is 0, we will return the smallest element in the tree.
     // if k is 1, we will return the second smallest element in the tree.
     // and so on.
     // in each node, the field nodesInSubtree_m will hold the number of nodes in the subtree of the node, including the node itself.
     // for example, if the node has 2 leaves, the nodesInSubtree_m will be 3.
-
+    int depth = 0;
     while(node != nullptr){
+        depth++;
         if (node->left_m == nullptr){
             if (k == 0){
-                return tupleOutput<Node<T>*>( node);
+                instrumentation_m.descent(depth);
+                return tupleOutput<Node<T, Aggregate>*>( node);
             }
             k--;
             node = node->right_m;
         }
-        else{
-            if (node->left_m->getNodesInSubtree() == k){
-                return tupleOutput<Node<T>*>( node);
-            }
-            else if (node->left_m->getNodesInSubtree() > k){
-                node = node->left_m;
-            }
-            else{
-                k -= node->left_m->getNodesInSubtree() + 1;
-                node = node->right_m;
-            }
+        else{
+            if (node->left_m->getNodesInSubtree() == k){
+                instrumentation_m.descent(depth);
+                return tupleOutput<Node<T, Aggregate>*>( node);
+            }
+            else if (node->left_m->getNodesInSubtree() > k){
+                node = node->left_m;
+            }
+            else{
+                k -= node->left_m->getNodesInSubtree() + 1;
+                node = node->right_m;
+            }
+        }
+    }
+    return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
+}
+
+// the bytes of the tree and of its pool, including the slots of the pool that are not in use.
+// if the pool is shared with other trees (after split, join or a set operation), their nodes are counted too.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+size_t Tree<T, Compare, Aggregate, Instrumentation>::memoryUsage() const{
+    return sizeof(*this) + sizeof(*pool_m) + pool_m->getBytes();
+}
+
+// compare with CompactTree::memoryPerNode.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+double Tree<T, Compare, Aggregate, Instrumentation>::memoryPerNode() const{
+    if(getSize() == 0){
+        return 0;
+    }
+    return static_cast<double>(memoryUsage()) / getSize();
+}
+
+// changes the key of a node we already hold, the node keeps its address.
+// if the new key still falls between the keys of the neighbours of node, the key is just replaced in place.
+// otherwise the node is taken out of the tree and hung again at the place of the new key, which is found by one
+// descent that also tells if the new key is already in the tree. in that case FAILURE is returned and the node is
+// hung back with its old key: the keys and the handles stay the same, only the shape of the tree may change.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::updateKey(Node<T, Aggregate>* node, T data){
+    if(node == nullptr){
+        return taskStatus::INVALID_INPUT;
+    }
+    Node<T, Aggregate>* prev = findPrev(node);
+    Node<T, Aggregate>* next = findNext(node);
+    if((prev == nullptr || isBefore(prev->data_m, data)) && (next == nullptr || isBefore(data, next->data_m))){
+        node->data_m = std::move(data);
+        if constexpr (hasAggregate){
+            for(Node<T, Aggregate>* current = node; current != nullptr; current = current->getParent()){
+                updateNodesInSubTree(current);
+            }
+        }
+        return taskStatus::SUCCESS;
+    }
+    unlinkNode(node);
+    Node<T, Aggregate>* parent = nullptr;
+    if(insertionPoint(data, parent) != taskStatus::SUCCESS){
+        insertionPoint(node->data_m, parent);
+        linkNode(node, parent);
+        return taskStatus::FAILURE;
+    }
+    node->data_m = std::move(data);
+    updateNodesInSubTree(node);
+    return linkNode(node, parent);
+}
+
+// the inverse of findKthElement: returns the number of keys in the tree that are smaller than data,
+// so the smallest key has rank 0. if data is not in the tree, FAILURE is returned.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Key>
+tupleOutput<int> Tree<T, Compare, Aggregate, Instrumentation>::rankKey(const Key& key){
+    Node<T, Aggregate>* current = root_m;
+    int smaller = 0;
+    int depth = 0;
+    if constexpr (threeWayWith<Key>()){
+        while(current != nullptr){
+            depth++;
+            int order = compareKeys(key, current->data_m);
+            if(order < 0){
+                current = current->getLeft();
+            }
+            else if(order > 0){
+                // the node and all of its left subtree are smaller than data.
+                smaller += 1;
+                if(current->getLeft() != nullptr){
+                    smaller += current->getLeft()->getNodesInSubtree();
+                }
+                current = current->getRight();
+            }
+            else{
+                if(current->getLeft() != nullptr){
+                    smaller += current->getLeft()->getNodesInSubtree();
+                }
+                instrumentation_m.descent(depth);
+                return tupleOutput<int>(smaller);
+            }
+        }
+        instrumentation_m.descent(depth);
+        return tupleOutput<int>(taskStatus::FAILURE);
+    }
+    else{
+        // a single call to compare_m per node, like findKey: the last node that is not smaller than key is the only one
+        // that can be equal to it, and the keys smaller than it are counted on the way.
+        Node<T, Aggregate>* bound = nullptr;
+        int boundRank = 0;
+        while(current != nullptr){
+            depth++;
+            int leftNodes = current->getLeft() == nullptr ? 0 : current->getLeft()->getNodesInSubtree();
+            if(isBefore(current->data_m, key)){
+                smaller += leftNodes + 1;
+                current = current->getRight();
+            }
+            else{
+                bound = current;
+                boundRank = smaller + leftNodes;
+                current = current->getLeft();
+            }
+        }
+        instrumentation_m.descent(depth);
+        if(bound == nullptr || isBefore(key, bound->data_m)){
+            return tupleOutput<int>(taskStatus::FAILURE);
+        }
+        return tupleOutput<int>(boundRank);
+    }
+}
+
+// same as rank(data), but starts from a node we already hold, and walks up to the root without any comparisons.
+// every time we come up from a right child, the parent and its left subtree are smaller than node.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+tupleOutput<int> Tree<T, Compare, Aggregate, Instrumentation>::rank(Node<T, Aggregate>* node){
+    if(node == nullptr){
+        return tupleOutput<int>(taskStatus::INVALID_INPUT);
+    }
+    int smaller = node->getLeft() == nullptr ? 0 : node->getLeft()->getNodesInSubtree();
+    Node<T, Aggregate>* parent = node->getParent();
+    while(parent != nullptr){
+        if(parent->getRight() == node){
+            smaller += 1;
+            if(parent->getLeft() != nullptr){
+                smaller += parent->getLeft()->getNodesInSubtree();
+            }
+        }
+        node = parent;
+        parent = parent->getParent();
+    }
+    return tupleOutput<int>(smaller);
+}
+
+// returns the node of the smallest key that is not smaller than data, FAILURE if there is no such key.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Key>
+tupleOutput<Node<T, Aggregate>*> Tree<T, Compare, Aggregate, Instrumentation>::lowerBoundKey(const Key& key){
+    Node<T, Aggregate>* current = root_m;
+    Node<T, Aggregate>* bound = nullptr;
+    int depth = 0;
+    while(current != nullptr){
+        depth++;
+        if(isBefore(current->data_m, key)){
+            current = current->getRight();
+        }
+        else{
+            bound = current;
+            current = current->getLeft();
+        }
+    }
+    instrumentation_m.descent(depth);
+    if(bound == nullptr){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
+    }
+    return tupleOutput<Node<T, Aggregate>*>(bound);
+}
+
+// returns the node of the smallest key that is bigger than data, FAILURE if there is no such key.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Key>
+tupleOutput<Node<T, Aggregate>*> Tree<T, Compare, Aggregate, Instrumentation>::upperBoundKey(const Key& key){
+    Node<T, Aggregate>* current = root_m;
+    Node<T, Aggregate>* bound = nullptr;
+    int depth = 0;
+    while(current != nullptr){
+        depth++;
+        if(isBefore(key, current->data_m)){
+            bound = current;
+            current = current->getLeft();
+        }
+        else{
+            current = current->getRight();
+        }
+    }
+    instrumentation_m.descent(depth);
+    if(bound == nullptr){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::FAILURE);
+    }
+    return tupleOutput<Node<T, Aggregate>*>(bound);
+}
+
+// returns the number of keys in [low, high), using two descents and the subtree counts.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+int Tree<T, Compare, Aggregate, Instrumentation>::countRange(const T& low, const T& high){
+    if(!isBefore(low, high)){
+        return 0;
+    }
+    return countSmaller(high) - countSmaller(low);
+}
+
+// returns the aggregate of all the keys in [low, high), in O(logn) and without inverting the aggregate.
+// we go down to the first node inside the range (all the nodes of the range are in its subtree),
+// and from it we go down twice more: towards low, collecting the nodes and right subtrees that are not smaller than low,
+// and towards high, collecting the nodes and left subtrees that are smaller than high.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+tupleOutput<typename Aggregate::value_type> Tree<T, Compare, Aggregate, Instrumentation>::aggregate(const T& low, const T& high){
+    Node<T, Aggregate>* split = root_m;
+    while(split != nullptr){
+        if(isBefore(split->data_m, low)){
+            split = split->getRight();
+        }
+        else if(!isBefore(split->data_m, high)){
+            split = split->getLeft();
+        }
+        else{
+            break;
+        }
+    }
+    if(split == nullptr || !isBefore(low, high)){
+        return tupleOutput<aggregate_type>(Aggregate::identity());
+    }
+    aggregate_type suffix = Aggregate::identity();
+    for(Node<T, Aggregate>* current = split->getLeft(); current != nullptr;){
+        if(isBefore(current->data_m, low)){
+            current = current->getRight();
+        }
+        else{
+            suffix = Aggregate::combine(Aggregate::combine(Aggregate::fromData(current->data_m), getSubtreeAggregate(current->getRight())), suffix);
+            current = current->getLeft();
+        }
+    }
+    aggregate_type prefix = Aggregate::identity();
+    for(Node<T, Aggregate>* current = split->getRight(); current != nullptr;){
+        if(isBefore(current->data_m, high)){
+            prefix = Aggregate::combine(prefix, Aggregate::combine(getSubtreeAggregate(current->getLeft()), Aggregate::fromData(current->data_m)));
+            current = current->getRight();
+        }
+        else{
+            current = current->getLeft();
+        }
+    }
+    return tupleOutput<aggregate_type>(Aggregate::combine(Aggregate::combine(suffix, Aggregate::fromData(split->data_m)), prefix));
+}
+
+// same as aggregate(low, high), but for the keys whose ranks are in [first, last).
+// the ranks are found with the subtree counts, the same way findKthElement does.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+tupleOutput<typename Aggregate::value_type> Tree<T, Compare, Aggregate, Instrumentation>::aggregateRank(int first, int last){
+    if(first < 0 || last > getSize() || first > last){
+        return tupleOutput<aggregate_type>(taskStatus::INVALID_INPUT);
+    }
+    if(first == last){
+        return tupleOutput<aggregate_type>(Aggregate::identity());
+    }
+    // offset is the rank of the smallest key in the subtree we are in.
+    Node<T, Aggregate>* split = root_m;
+    int offset = 0;
+    int splitRank = 0;
+    while(true){
+        splitRank = offset + (split->getLeft() == nullptr ? 0 : split->getLeft()->getNodesInSubtree());
+        if(splitRank < first){
+            offset = splitRank + 1;
+            split = split->getRight();
+        }
+        else if(splitRank >= last){
+            split = split->getLeft();
+        }
+        else{
+            break;
+        }
+    }
+    aggregate_type suffix = Aggregate::identity();
+    offset = splitRank - (split->getLeft() == nullptr ? 0 : split->getLeft()->getNodesInSubtree());
+    for(Node<T, Aggregate>* current = split->getLeft(); current != nullptr;){
+        int currentRank = offset + (current->getLeft() == nullptr ? 0 : current->getLeft()->getNodesInSubtree());
+        if(currentRank < first){
+            offset = currentRank + 1;
+            current = current->getRight();
+        }
+        else{
+            suffix = Aggregate::combine(Aggregate::combine(Aggregate::fromData(current->data_m), getSubtreeAggregate(current->getRight())), suffix);
+            current = current->getLeft();
+        }
+    }
+    aggregate_type prefix = Aggregate::identity();
+    offset = splitRank + 1;
+    for(Node<T, Aggregate>* current = split->getRight(); current != nullptr;){
+        int currentRank = offset + (current->getLeft() == nullptr ? 0 : current->getLeft()->getNodesInSubtree());
+        if(currentRank < last){
+            prefix = Aggregate::combine(prefix, Aggregate::combine(getSubtreeAggregate(current->getLeft()), Aggregate::fromData(current->data_m)));
+            offset = currentRank + 1;
+            current = current->getRight();
+        }
+        else{
+            current = current->getLeft();
+        }
+    }
+    return tupleOutput<aggregate_type>(Aggregate::combine(Aggregate::combine(suffix, Aggregate::fromData(split->data_m)), prefix));
+}
+
+// calls func(key) for every key in [low, high) in increasing order.
+// we find the first key with one descent and then follow the successors, and we stop at the first key
+// that is not smaller than high, so the cost is O(logn) plus the number of keys in the range.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Function>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::visitRange(const T& low, const T& high, Function&& func){
+    if(!isBefore(low, high)){
+        return taskStatus::SUCCESS;
+    }
+    tupleOutput<Node<T, Aggregate>*> first = lowerBound(low);
+    if(first.status() != taskStatus::SUCCESS){
+        return taskStatus::SUCCESS;
+    }
+    for(Node<T, Aggregate>* node = first.ans(); node != nullptr && isBefore(node->data_m, high); node = findSuccessor(node)){
+        func(node->data_m);
+    }
+    return taskStatus::SUCCESS;
+}
+
+// inserts a whole batch of m keys, that must be sorted in a strictly increasing order, in one pass over the tree.
+// the batch is split by the key of each node we visit, so neighbouring keys share the descent, and every subtree
+// that gets no keys is not touched at all. the two sides are then joined back around the node, which fixes the heights
+// and the counts of every touched node exactly once. for m close to n this is a linear merge.
+// if handles is given, handles[i] is the node that holds the i-th key (the old node if the key was already in the tree),
+// and if statuses is given, statuses[i] is SUCCESS for a new key and FAILURE for a key that was already in the tree.
+// the iterators must be random access, the existing nodes are not moved.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::insertBatch(Iterator first, Iterator last, Node<T, Aggregate>** handles, taskStatus* statuses){
+    if(first == last){
+        return taskStatus::SUCCESS;
+    }
+    for(Iterator it = first + 1; it != last; ++it){
+        if(!isBefore(*(it - 1), *it)){
+            return taskStatus::INVALID_INPUT;
+        }
+    }
+    // after the reserve, the allocations inside the recursion can not fail.
+    if(!pool_m->reserve(static_cast<int>(last - first))){
+        return taskStatus::ALLOCATION_ERROR;
+    }
+    root_m = insertBatchRecursive(root_m, first, last, first, handles, statuses);
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::insertBatchRecursive(Node<T, Aggregate>* node, Iterator first, Iterator last, Iterator begin, Node<T, Aggregate>** handles, taskStatus* statuses){
+    if(first == last){
+        return node;
+    }
+    if(node == nullptr){
+        // an empty subtree gets a balanced subtree of the new keys, the middle key becomes the root.
+        Iterator mid = first + (last - first) / 2;
+        Node<T, Aggregate>* left = insertBatchRecursive(nullptr, first, mid, begin, handles, statuses);
+        Node<T, Aggregate>* right = insertBatchRecursive(nullptr, mid + 1, last, begin, handles, statuses);
+        Node<T, Aggregate>* newNode = pool_m->allocate(std::in_place, *mid);
+        instrumentation_m.allocation(1);
+        if(handles != nullptr){
+            handles[mid - begin] = newNode;
+        }
+        if(statuses != nullptr){
+            statuses[mid - begin] = taskStatus::SUCCESS;
+        }
+        return joinWithPivot(left, newNode, right);
+    }
+    Node<T, Aggregate>* left = node->getLeft();
+    Node<T, Aggregate>* right = node->getRight();
+    Iterator split = lowerBoundIn(first, last, node->data_m);
+    Iterator rightFirst = split;
+    if(split != last && !isBefore(node->data_m, *split)){
+        // the key is already in the tree.
+        if(handles != nullptr){
+            handles[split - begin] = node;
+        }
+        if(statuses != nullptr){
+            statuses[split - begin] = taskStatus::FAILURE;
+        }
+        ++rightFirst;
+    }
+    left = insertBatchRecursive(left, first, split, begin, handles, statuses);
+    right = insertBatchRecursive(right, rightFirst, last, begin, handles, statuses);
+    return joinWithPivot(left, node, right);
+}
+
+// removes a whole batch of m keys, that must be sorted in a strictly increasing order, in one pass over the tree.
+// works like insertBatch: the batch is split by the key of each node we visit, and a removed node is replaced by
+// joining its two (already updated) subtrees. if statuses is given, statuses[i] is SUCCESS if the i-th key was removed
+// and FAILURE if it was not in the tree. the iterators must be random access.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::eraseBatch(Iterator first, Iterator last, taskStatus* statuses){
+    if(first == last){
+        return taskStatus::SUCCESS;
+    }
+    for(Iterator it = first + 1; it != last; ++it){
+        if(!isBefore(*(it - 1), *it)){
+            return taskStatus::INVALID_INPUT;
+        }
+    }
+    root_m = eraseBatchRecursive(root_m, first, last, first, statuses);
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::eraseBatchRecursive(Node<T, Aggregate>* node, Iterator first, Iterator last, Iterator begin, taskStatus* statuses){
+    if(first == last){
+        return node;
+    }
+    if(node == nullptr){
+        if(statuses != nullptr){
+            for(Iterator it = first; it != last; ++it){
+                statuses[it - begin] = taskStatus::FAILURE;
+            }
+        }
+        return nullptr;
+    }
+    Node<T, Aggregate>* left = node->getLeft();
+    Node<T, Aggregate>* right = node->getRight();
+    Iterator split = lowerBoundIn(first, last, node->data_m);
+    bool found = split != last && !isBefore(node->data_m, *split);
+    left = eraseBatchRecursive(left, first, split, begin, statuses);
+    right = eraseBatchRecursive(right, found ? split + 1 : split, last, begin, statuses);
+    if(!found){
+        return joinWithPivot(left, node, right);
+    }
+    if(statuses != nullptr){
+        statuses[split - begin] = taskStatus::SUCCESS;
+    }
+    deallocateNode(node);
+    return joinSubtrees(left, right);
+}
+
+// finds many keys at once. a single find waits for a cache miss on every level of a big tree, so here
+// lookupLanes descents run side by side: each step of a descent prefetches the next node, and moves on to the
+// other descents while it loads. a descent that ends takes the next key, the keys can come in any order.
+// handles[i] is the node of the i-th key, or nullptr if it is not in the tree. the iterators must be random access.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::findMany(Iterator first, Iterator last, Node<T, Aggregate>** handles){
+    if(handles == nullptr && first != last){
+        return taskStatus::INVALID_INPUT;
+    }
+    const std::ptrdiff_t count = last - first;
+    if(root_m == nullptr){
+        std::fill(handles, handles + count, nullptr);
+        return taskStatus::SUCCESS;
+    }
+    typedef typename std::iterator_traits<Iterator>::value_type key_type;
+    std::ptrdiff_t lane[lookupLanes];
+    Node<T, Aggregate>* current[lookupLanes];
+    Node<T, Aggregate>* bound[lookupLanes]; // the last node of the descent that is not smaller than its key
+    std::ptrdiff_t next = 0;
+    int active = 0;
+    for(int i = 0; i < lookupLanes; i++){
+        current[i] = nullptr;
+        bound[i] = nullptr;
+        if(next < count){
+            lane[i] = next++;
+            current[i] = root_m;
+            active++;
+        }
+    }
+    while(active > 0){
+        for(int i = 0; i < lookupLanes; i++){
+            Node<T, Aggregate>* node = current[i];
+            if(node == nullptr){
+                continue;
+            }
+            if constexpr (threeWayWith<key_type>()){
+                int order = compareKeys(first[lane[i]], node->data_m);
+                Node<T, Aggregate>* child = order < 0 ? node->left_m : node->right_m;
+                if(order != 0 && child != nullptr){
+                    AVL_PREFETCH(child);
+                    current[i] = child;
+                    continue;
+                }
+                handles[lane[i]] = order == 0 ? node : nullptr;
+            }
+            else{
+                // one call to compare_m per node, like findKey: the descent goes to the bottom, and only the last node
+                // that is not smaller than the key can be equal to it.
+                bool smaller = isBefore(node->data_m, first[lane[i]]);
+                if(!smaller){
+                    bound[i] = node;
+                }
+                Node<T, Aggregate>* child = smaller ? node->right_m : node->left_m;
+                if(child != nullptr){
+                    AVL_PREFETCH(child);
+                    current[i] = child;
+                    continue;
+                }
+                Node<T, Aggregate>* found = bound[i];
+                handles[lane[i]] = found != nullptr && !isBefore(first[lane[i]], found->data_m) ? found : nullptr;
+                bound[i] = nullptr;
+            }
+            if(next < count){
+                lane[i] = next++;
+                current[i] = root_m;
+            }
+            else{
+                current[i] = nullptr;
+                active--;
+            }
+        }
+    }
+    return taskStatus::SUCCESS;
+}
+
+// findKthElement for many k at once, interleaved like findMany. to choose a side a descent needs the count of the
+// left child, so it takes two rounds per level: one to prefetch the left child of its node, and one to move on.
+// handles[i] is the node of rank first[i] (0 based), or nullptr if there is no such rank. the iterators must be random access.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::selectMany(Iterator first, Iterator last, Node<T, Aggregate>** handles){
+    if(handles == nullptr && first != last){
+        return taskStatus::INVALID_INPUT;
+    }
+    const std::ptrdiff_t count = last - first;
+    const int size = getSize();
+    std::ptrdiff_t lane[lookupLanes];
+    Node<T, Aggregate>* current[lookupLanes];
+    int left[lookupLanes]; // the rank that is still looked for in the subtree of current
+    bool fetched[lookupLanes]; // the left child of current was prefetched in the last round
+    std::ptrdiff_t next = 0;
+    // gives lane i the next rank, the ranks that are out of the tree are answered right away.
+    auto start = [&](int i){
+        while(next < count){
+            std::ptrdiff_t index = next++;
+            if(!isRank(first[index], size)){
+                handles[index] = nullptr;
+                continue;
+            }
+            lane[i] = index;
+            left[i] = static_cast<int>(first[index]);
+            current[i] = root_m;
+            fetched[i] = false;
+            return true;
+        }
+        current[i] = nullptr;
+        return false;
+    };
+    int active = 0;
+    for(int i = 0; i < lookupLanes; i++){
+        active += start(i);
+    }
+    while(active > 0){
+        for(int i = 0; i < lookupLanes; i++){
+            Node<T, Aggregate>* node = current[i];
+            if(node == nullptr){
+                continue;
+            }
+            if(!fetched[i]){
+                AVL_PREFETCH(node->left_m);
+                fetched[i] = true;
+                continue;
+            }
+            int leftNodes = node->left_m == nullptr ? 0 : node->left_m->NodesInSubtree_m;
+            if(left[i] == leftNodes){
+                handles[lane[i]] = node;
+                active -= !start(i);
+                continue;
+            }
+            if(left[i] < leftNodes){
+                current[i] = node->left_m;
+            }
+            else{
+                left[i] -= leftNodes + 1;
+                current[i] = node->right_m;
+                AVL_PREFETCH(current[i]);
+            }
+            fetched[i] = false;
+        }
+    }
+    return taskStatus::SUCCESS;
+}
+
+// moves all the keys that are not smaller than key into right, which must be an empty tree.
+// the tree is cut along the search path of key, and the pieces on each side are joined back together,
+// the joins cost the differences between the heights of the pieces, which add up to O(logn).
+// the nodes are not moved, so saved handles stay valid, they just belong to the tree that holds their key.
+// both trees share the pool of the nodes from now on.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::split(const T& key, Tree<T, Compare, Aggregate, Instrumentation>& right){
+    if(&right == this || right.root_m != nullptr){
+        return taskStatus::INVALID_INPUT;
+    }
+    Node<T, Aggregate>* leftRoot = nullptr;
+    Node<T, Aggregate>* rightRoot = nullptr;
+    Node<T, Aggregate>* found = splitSubtree(root_m, key, leftRoot, rightRoot);
+    if(found != nullptr){
+        // the node of key itself is the smallest node of the right side.
+        rightRoot = joinWithPivot(nullptr, found, rightRoot);
+    }
+    root_m = leftRoot;
+    right.sharePoolWith(*this);
+    right.root_m = rightRoot;
+    return taskStatus::SUCCESS;
+}
+
+// appends all the keys of right to this tree, right is left empty.
+// all the keys of right must be bigger than all the keys of this tree, otherwise INVALID_INPUT is returned.
+// the nodes are not moved, so saved handles into right stay valid and now belong to this tree.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::join(Tree<T, Compare, Aggregate, Instrumentation>& right){
+    if(&right == this){
+        return taskStatus::INVALID_INPUT;
+    }
+    if(right.root_m == nullptr){
+        return taskStatus::SUCCESS;
+    }
+    if(root_m != nullptr && !isBefore(findMax(root_m)->data_m, right.findMin(right.root_m)->data_m)){
+        return taskStatus::INVALID_INPUT;
+    }
+    sharePoolWith(right);
+    root_m = joinSubtrees(root_m, right.root_m);
+    right.root_m = nullptr;
+    return taskStatus::SUCCESS;
+}
+
+// writes the tree to the file at path, in the format of SnapshotHeader: the nodes in breadth first order with their
+// heights and counts, so load rebuilds the very same tree. the keys are written as bytes, so T must be trivially copyable.
+// FAILURE if the file can not be written.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::save(const char* path) const{
+    static_assert(std::is_trivially_copyable<T>::value, "save writes the keys as bytes");
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr){
+        return taskStatus::FAILURE;
+    }
+    SnapshotHeader header = SnapshotHeader::make<SnapshotNode<T>>(getSize());
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    // the queue of the breadth first walk is also the order of the nodes in the file,
+    // so the index of a child is the size of the queue when it is added.
+    std::vector<const Node<T, Aggregate>*> order;
+    order.reserve(static_cast<size_t>(getSize()));
+    if(root_m != nullptr){
+        order.push_back(root_m);
+    }
+    std::vector<SnapshotNode<T>> chunk(static_cast<size_t>(std::min(getSize(), snapshotChunk)));
+    size_t filled = 0;
+    for(size_t i = 0; i < order.size() && written; i++){
+        const Node<T, Aggregate>* node = order[i];
+        SnapshotNode<T>& record = chunk[filled++];
+        record.data_m = node->data_m;
+        record.left_m = SnapshotHeader::nil;
+        record.right_m = SnapshotHeader::nil;
+        if(node->left_m != nullptr){
+            record.left_m = static_cast<std::uint32_t>(order.size());
+            order.push_back(node->left_m);
+        }
+        if(node->right_m != nullptr){
+            record.right_m = static_cast<std::uint32_t>(order.size());
+            order.push_back(node->right_m);
+        }
+        record.height_m = node->height_m;
+        record.nodesInSubtree_m = node->NodesInSubtree_m;
+        if(filled == chunk.size() || i + 1 == order.size()){
+            written = std::fwrite(chunk.data(), sizeof(SnapshotNode<T>), filled, file) == filled;
+            filled = 0;
+        }
+    }
+    if(std::fclose(file) != 0){
+        written = false;
+    }
+    return written ? taskStatus::SUCCESS : taskStatus::FAILURE;
+}
+
+// replaces the tree with the one saved in the file at path, in O(n): the nodes are linked as they were saved,
+// with no comparison and no rotation. the shape of the tree, the heights and the counts are checked on the way,
+// the order of the keys is not (that would cost the comparisons).
+// FAILURE if the file can not be opened, INVALID_INPUT if it is not a snapshot of this type of tree. on any error the tree is left empty.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::load(const char* path){
+    static_assert(std::is_trivially_copyable<T>::value, "load reads the keys as bytes");
+    std::FILE* file = std::fopen(path, "rb");
+    if(file == nullptr){
+        return taskStatus::FAILURE;
+    }
+    clear();
+    SnapshotHeader header;
+    if(std::fread(&header, sizeof(header), 1, file) != 1 || !header.matches<SnapshotNode<T>>()){
+        std::fclose(file);
+        return taskStatus::INVALID_INPUT;
+    }
+    const int count = header.count_m;
+    // a broken header must not make us allocate more nodes than the file has.
+    long end = std::fseek(file, 0, SEEK_END) == 0 ? std::ftell(file) : -1;
+    if(end < 0 || static_cast<unsigned long>(end) < sizeof(header) + static_cast<unsigned long>(count) * sizeof(SnapshotNode<T>)
+       || std::fseek(file, sizeof(header), SEEK_SET) != 0){
+        std::fclose(file);
+        return taskStatus::INVALID_INPUT;
+    }
+    if(!pool_m->reserve(count)){
+        std::fclose(file);
+        return taskStatus::ALLOCATION_ERROR;
+    }
+    std::vector<Node<T, Aggregate>*> nodes;
+    nodes.reserve(static_cast<size_t>(count));
+    std::vector<std::uint32_t> children; // the left and the right child of every node
+    children.reserve(2 * static_cast<size_t>(count));
+    std::vector<SnapshotNode<T>> chunk(static_cast<size_t>(std::min(count, snapshotChunk)));
+    taskStatus status = taskStatus::SUCCESS;
+    // in breadth first order the children are numbered one after the other from 1, which also rules out cycles.
+    std::uint32_t nextChild = 1;
+    while(static_cast<int>(nodes.size()) < count && status == taskStatus::SUCCESS){
+        size_t size = std::min(chunk.size(), static_cast<size_t>(count) - nodes.size());
+        if(std::fread(chunk.data(), sizeof(SnapshotNode<T>), size, file) != size){
+            status = taskStatus::INVALID_INPUT;
+            break;
+        }
+        for(size_t i = 0; i < size; i++){
+            const SnapshotNode<T>& record = chunk[i];
+            for(std::uint32_t child : {record.left_m, record.right_m}){
+                if(child != SnapshotHeader::nil && child != nextChild++){
+                    status = taskStatus::INVALID_INPUT;
+                }
+            }
+            Node<T, Aggregate>* node = allocateNode(record.data_m);
+            if(node == nullptr){
+                status = taskStatus::ALLOCATION_ERROR;
+                break;
+            }
+            node->height_m = record.height_m;
+            node->NodesInSubtree_m = record.nodesInSubtree_m;
+            nodes.push_back(node);
+            children.push_back(record.left_m);
+            children.push_back(record.right_m);
+        }
+    }
+    std::fclose(file);
+    if(status == taskStatus::SUCCESS && count > 0 && nextChild != static_cast<std::uint32_t>(count)){
+        status = taskStatus::INVALID_INPUT;
+    }
+    // the children come after their parents, so going backwards every node is checked after its children.
+    for(int i = count - 1; i >= 0 && status == taskStatus::SUCCESS; i--){
+        Node<T, Aggregate>* node = nodes[i];
+        node->left_m = children[2 * i] == SnapshotHeader::nil ? nullptr : nodes[children[2 * i]];
+        node->right_m = children[2 * i + 1] == SnapshotHeader::nil ? nullptr : nodes[children[2 * i + 1]];
+        int leftHeight = node->left_m == nullptr ? 0 : node->left_m->height_m;
+        int rightHeight = node->right_m == nullptr ? 0 : node->right_m->height_m;
+        int leftNodes = node->left_m == nullptr ? 0 : node->left_m->NodesInSubtree_m;
+        int rightNodes = node->right_m == nullptr ? 0 : node->right_m->NodesInSubtree_m;
+        if(node->height_m != std::max(leftHeight, rightHeight) + 1 || leftHeight - rightHeight > 1 || rightHeight - leftHeight > 1
+           || node->NodesInSubtree_m != leftNodes + rightNodes + 1){
+            status = taskStatus::INVALID_INPUT;
+            break;
+        }
+        if(node->left_m != nullptr){
+            node->left_m->parent_m = node;
+        }
+        if(node->right_m != nullptr){
+            node->right_m->parent_m = node;
+        }
+        if constexpr (hasAggregate){
+            updateNodesInSubTree(node);
+        }
+    }
+    if(status != taskStatus::SUCCESS){
+        for(Node<T, Aggregate>* node : nodes){
+            deallocateNode(node);
+        }
+        return status;
+    }
+    root_m = count == 0 ? nullptr : nodes[0];
+    return taskStatus::SUCCESS;
+}
+
+// a snapshot of the counters of the instrumentation policy (zeros with NoInstrumentation), the size and the height.
+// with histograms the whole tree is walked for the histograms of the depths and of the subtree sizes: keys that
+// sit much deeper than log2 of the size, or many rotations per allocation, point at a bad pattern of keys.
+// the walk keeps its own stack, so deep trees can not overflow the stack.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+TreeStats Tree<T, Compare, Aggregate, Instrumentation>::stats(bool histograms) const{
+    TreeStats stats;
+    instrumentation_m.fill(stats);
+    stats.size_m = getSize();
+    stats.height_m = root_m == nullptr ? 0 : root_m->getHeight();
+    if(!histograms || root_m == nullptr){
+        return stats;
+    }
+    stats.depthHistogram_m.assign(stats.height_m, 0);
+    std::vector<std::pair<const Node<T, Aggregate>*, int>> stack;
+    stack.reserve(stats.height_m + 1);
+    stack.emplace_back(root_m, 0);
+    while(!stack.empty()){
+        const Node<T, Aggregate>* node = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+        stats.depthHistogram_m[depth]++;
+        int bucket = 0;
+        for(int nodes = node->NodesInSubtree_m; nodes > 1; nodes >>= 1){
+            bucket++;
+        }
+        if(static_cast<int>(stats.sizeHistogram_m.size()) <= bucket){
+            stats.sizeHistogram_m.resize(bucket + 1, 0);
+        }
+        stats.sizeHistogram_m[bucket]++;
+        if(node->right_m != nullptr){
+            stack.emplace_back(node->right_m, depth + 1);
+        }
+        if(node->left_m != nullptr){
+            stack.emplace_back(node->left_m, depth + 1);
         }
     }
-    return tupleOutput<Node<T>*>(taskStatus::FAILURE);
+    return stats;
+}
+
+// makes sure that our pool keeps the memory of the nodes of other alive,
+// this must be called before nodes of other are linked into this tree.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void Tree<T, Compare, Aggregate, Instrumentation>::sharePoolWith(Tree<T, Compare, Aggregate, Instrumentation>& other){
+    if(pool_m == other.pool_m){
+        return;
+    }
+    if(root_m == nullptr){
+        // we hold no nodes, so we can simply use the pool of other.
+        pool_m = other.pool_m;
+    }
+    else if(other.pool_m->keepsAlive(pool_m.get())){
+        // the pool of other already keeps our pool alive, so we move to it instead of making a cycle.
+        pool_m = other.pool_m;
+    }
+    else{
+        pool_m->adopt(other.pool_m);
+    }
+}
+
+// gives the tree a new pool of its own for the nodes it allocates from now on, and the new pool keeps the old one
+// alive, so the nodes the tree holds stay where they are. after split the two trees share a pool, and this is what
+// lets them allocate on two threads at once (ShardedTree in AVLSharded.h does that).
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void Tree<T, Compare, Aggregate, Instrumentation>::detachPool(){
+    std::shared_ptr<NodePool<Node<T, Aggregate>>> pool = std::make_shared<NodePool<Node<T, Aggregate>>>();
+    if(root_m != nullptr){
+        pool->adopt(pool_m);
+    }
+    pool_m = std::move(pool);
+}
+
+// the number of pools the nodes of the tree may come from: its own pool and the pools it keeps alive.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+int Tree<T, Compare, Aggregate, Instrumentation>::countPools() const{
+    return pool_m->countPools();
 }
 
 
 //// helper methods ////
 /*
-    Node<T>* getRoot() const {return root_m;} // we will use this method to get the root of the tree.
-    taskStatus setRoot(Node<T>* root) {this->root_m = root; return taskStatus::SUCCESS;} // we will use this method to set the root of the tree.
-    taskStatus RRrotation(Node<T>* node); // complexity O(1)
-    taskStatus LLrotation(Node<T>* node); // complexity O(1)
-    taskStatus RLrotation(Node<T>* node); // complexity O(1)
-    taskStatus LRrotation(Node<T>* node); // complexity O(1)
-    taskStatus rebalance(Node<T>* node); // complexity O(1)
-    taskStatus updateHeight(Node<T>* node); // complexity O(1)
-    taskStatus switchNodesLocation(Node<T>* node1, Node<T>* node2); // complexity O(1)
-    int getBalanceFactor(Node<T>* node); // complexity O(1)
-    int getBalance(Node<T>* node); // complexity O(1)
-    void DestroyRecursive(Node<T>* node); // complexity O(n)
-    taskStatus updateNodesInSubTree(Node<T> *node); // complexity O(1)
+    Node<T, Aggregate>* getRoot() const {return loadNodeField<Aggregate>(root_m, std::memory_order_acquire);} // we will use this method to get the root of the tree.
+    taskStatus setRoot(Node<T, Aggregate>* root) {storeNodeField<Aggregate>(root_m, root, std::memory_order_release); return taskStatus::SUCCESS;} // we will use this method to set the root of the tree.
+    taskStatus RRrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus LLrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus RLrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus LRrotation(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus rebalance(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus retrace(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus linkNode(Node<T, Aggregate>* node, Node<T, Aggregate>* parent); // complexity O(logn)
+    taskStatus unlinkNode(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus updateHeight(Node<T, Aggregate>* node); // complexity O(1)
+    taskStatus switchNodesLocation(Node<T, Aggregate>* node1, Node<T, Aggregate>* node2); // complexity O(1)
+    int getBalanceFactor(Node<T, Aggregate>* node); // complexity O(1)
+    int getBalance(Node<T, Aggregate>* node); // complexity O(1)
+    void DestroyRecursive(Node<T, Aggregate>* node); // complexity O(n)
+    taskStatus updateNodesInSubTree(Node<T, Aggregate> *node); // complexity O(1)
+    Node<T, Aggregate>* allocateNode(Args&&... args); // complexity O(1) amortized
+    Node<T, Aggregate>* allocateNodes(int count); // complexity O(1)
+    taskStatus insertionPoint(const T& data, Node<T, Aggregate>*& parent); // complexity O(logn)
+    void deallocateNode(Node<T, Aggregate>* node); // complexity O(1)
+    Node<T, Aggregate>* rebalanceStep(Node<T, Aggregate>* node); // complexity O(1)
+    Node<T, Aggregate>* joinWithPivot(Node<T, Aggregate>* left, Node<T, Aggregate>* pivot, Node<T, Aggregate>* right); // complexity O(|height(left) - height(right)|)
+    Node<T, Aggregate>* joinSubtrees(Node<T, Aggregate>* left, Node<T, Aggregate>* right); // complexity O(logn)
+    Node<T, Aggregate>* splitSubtree(Node<T, Aggregate>* node, const T& key, Node<T, Aggregate>*& left, Node<T, Aggregate>*& right); // complexity O(logn)
+    void sharePoolWith(Tree<T, Compare, Aggregate, Instrumentation>& other); // complexity O(number of pools)
+    void detachPool(); // complexity O(1)
+    int countPools() const; // complexity O(number of pools)
+    int countSmaller(const T& data); // complexity O(logn)
+    static typename Aggregate::value_type getSubtreeAggregate(Node<T, Aggregate>* node); // complexity O(1)
 */
 
 
-template<class T>
-taskStatus Tree<T>::RRrotation(Node<T>* node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::RRrotation(Node<T, Aggregate>* node){
     // we need to remember to update the nodesInSubTree field
-    Node<T>* parent = node->getParent();
-    Node<T>* right = node->getRight();
-    Node<T>* rightLeft = right->getLeft();
+    Node<T, Aggregate>* parent = node->getParent();
+    Node<T, Aggregate>* right = node->getRight();
+    Node<T, Aggregate>* rightLeft = right->getLeft();
     if(parent == nullptr){
-        setRoot(right);
+        // a detached subtree (see joinWithPivot) has no parent either, but it is not the root of the tree.
+        if(root_m == node){
+            setRoot(right);
+        }
     }
     else if(parent->getLeft() == node){
         parent->setLeft(right);
@@ -507,13 +1977,15 @@ taskStatus Tree<T>::RRrotation(Node<T>* node){
 }
 // the time complexity of the RRrotation function is O(1).
 
-template<class T>
-taskStatus Tree<T>::LLrotation(Node<T>* node){
-    Node<T>* parent = node->getParent();
-    Node<T>* left = node->getLeft();
-    Node<T>* leftRight = left->getRight();
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::LLrotation(Node<T, Aggregate>* node){
+    Node<T, Aggregate>* parent = node->getParent();
+    Node<T, Aggregate>* left = node->getLeft();
+    Node<T, Aggregate>* leftRight = left->getRight();
     if(parent == nullptr){
-        setRoot(left);
+        if(root_m == node){
+            setRoot(left);
+        }
     }
     else if(parent->getLeft() == node){
         parent->setLeft(left);
@@ -539,56 +2011,173 @@ taskStatus Tree<T>::LLrotation(Node<T>* node){
 }
 // the time complexity of the LLrotation function is O(1).
 
-template<class T>
-taskStatus Tree<T>::LRrotation(Node<T>* node){
-    Node<T>* left = node->getLeft();
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::LRrotation(Node<T, Aggregate>* node){
+    Node<T, Aggregate>* left = node->getLeft();
     RRrotation(left);
     LLrotation(node);
     return taskStatus::SUCCESS;
 }
 // the time complexity of the LRrotation function is O(1).
 
-template<class T>
-taskStatus Tree<T>::RLrotation(Node<T>* node){
-    Node<T>* right = node->getRight();
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::RLrotation(Node<T, Aggregate>* node){
+    Node<T, Aggregate>* right = node->getRight();
     LLrotation(right);
     RRrotation(node);
     return taskStatus::SUCCESS;
 }
 // the time complexity of the RLrotation function is O(1).
 
-template<class T>
-taskStatus Tree<T>::rebalance(Node<T>* node){
-    if(node == nullptr){
-        return taskStatus::SUCCESS;
-    }
-    int balance = getBalance(node);
-    if(balance > 1){
-        if(getBalance(node->getLeft()) >= 0){
-            LLrotation(node);
+// finds the node a new node with data will hang from (nullptr for an empty tree). if data is already in the tree,
+// FAILURE is returned and parent is the node with the equal key.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::insertionPoint(const T& data, Node<T, Aggregate>*& parent){
+    Node<T, Aggregate>* current = root_m;
+    parent = nullptr;
+    Node<T, Aggregate>* notGreater = nullptr; // the last node we passed to its right, the only node that can be equal to data
+    int depth = 0;
+    while(current != nullptr){
+        parent = current;
+        depth++;
+        if constexpr (threeWayWith<T>()){
+            int order = compareKeys(data, current->data_m);
+            if(order == 0){
+                instrumentation_m.descent(depth);
+                return taskStatus::FAILURE;
+            }
+            current = order < 0 ? current->getLeft() : current->getRight();
         }
         else{
-            LRrotation(node);
+            if(isBefore(data, current->data_m)){
+                current = current->getLeft();
+            }
+            else{
+                notGreater = current;
+                current = current->getRight();
+            }
         }
     }
-    else if(balance < -1){
-        if(getBalance(node->getRight()) <= 0){
-            RRrotation(node);
+    instrumentation_m.descent(depth);
+    if(notGreater != nullptr && !isBefore(notGreater->data_m, data)){
+        parent = notGreater;
+        return taskStatus::FAILURE;
+    }
+    return taskStatus::SUCCESS;
+}
+
+// hangs the single node node (no children) as a child of parent, on the side its key belongs to,
+// and fixes the tree above it. parent nullptr means the tree is empty and node becomes the root.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::linkNode(Node<T, Aggregate>* node, Node<T, Aggregate>* parent){
+    node->setParent(parent);
+    if(parent == nullptr){
+        setRoot(node);
+        return taskStatus::SUCCESS;
+    }
+    if(isBefore(node->data_m, parent->data_m)){
+        parent->setLeft(node);
+    }
+    else{
+        parent->setRight(node);
+    }
+    return retrace(parent);
+}
+
+// takes node out of the tree and fixes the tree, node is left as a single node and is not freed.
+// a node with two children is replaced by its successor, which has no left child, so the successor is easy
+// to take out of its own place. the successor gets the height of node, so retrace sees the change in height correctly.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::unlinkNode(Node<T, Aggregate>* node){
+    Node<T, Aggregate>* parent = node->getParent();
+    Node<T, Aggregate>* left = node->getLeft();
+    Node<T, Aggregate>* right = node->getRight();
+    Node<T, Aggregate>* replacement = nullptr;
+    Node<T, Aggregate>* retraceFrom = parent;
+    if(left == nullptr || right == nullptr){
+        replacement = left == nullptr ? right : left;
+    }
+    else{
+        replacement = right;
+        while(replacement->getLeft() != nullptr){
+            replacement = replacement->getLeft();
+        }
+        if(replacement == right){
+            retraceFrom = replacement;
         }
         else{
-            RLrotation(node);
+            retraceFrom = replacement->getParent();
+            retraceFrom->setLeft(replacement->getRight());
+            if(replacement->getRight() != nullptr){
+                replacement->getRight()->setParent(retraceFrom);
+            }
+            replacement->setRight(right);
+            right->setParent(replacement);
         }
+        replacement->setLeft(left);
+        left->setParent(replacement);
+        replacement->setHeight(node->getHeight());
+    }
+    if(replacement != nullptr){
+        replacement->setParent(parent);
+    }
+    if(parent == nullptr){
+        setRoot(replacement);
+    }
+    else if(parent->getLeft() == node){
+        parent->setLeft(replacement);
     }
     else{
-        updateHeight(node);
-        updateNodesInSubTree(node);
+        parent->setRight(replacement);
     }
+    node->setParent(nullptr);
+    node->setLeft(nullptr);
+    node->setRight(nullptr);
+    node->setHeight(1);
+    updateNodesInSubTree(node);
+    return retrace(retraceFrom);
+}
 
-    return rebalance(node->getParent());
+// fixes every node from node up to the root. this always goes all the way up, see retrace for the bounded version.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::rebalance(Node<T, Aggregate>* node){
+    int length = 0;
+    while(node != nullptr){
+        node = rebalanceStep(node)->getParent();
+        length++;
+    }
+    instrumentation_m.rebalanceWalk(length);
+    return taskStatus::SUCCESS;
 }
 
-template<class T>
-taskStatus Tree<T>::updateHeight(Node<T>* node){
+// fixes the tree after the children of node changed by one insert or one remove, in a single pass up to the root.
+// while the height of the subtree we came from changes, every node is rebalanced. once a node keeps its old height
+// (after an insert this happens at the latest after the first rotation), no node above it can become unbalanced,
+// so from there on we only update the subtree counts (and aggregates), which do change all the way up.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::retrace(Node<T, Aggregate>* node){
+    int length = 0; // the nodes we pass, both the ones we rebalance and the ones we only update
+    while(node != nullptr){
+        int oldHeight = node->getHeight();
+        node = rebalanceStep(node);
+        length++;
+        Node<T, Aggregate>* parent = node->getParent();
+        if(node->getHeight() == oldHeight){
+            for(; parent != nullptr; parent = parent->getParent()){
+                updateNodesInSubTree(parent);
+                length++;
+            }
+            instrumentation_m.rebalanceWalk(length);
+            return taskStatus::SUCCESS;
+        }
+        node = parent;
+    }
+    instrumentation_m.rebalanceWalk(length);
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::updateHeight(Node<T, Aggregate>* node){
     if(node == nullptr){
         return taskStatus::SUCCESS;
     }
@@ -599,17 +2188,17 @@ taskStatus Tree<T>::updateHeight(Node<T>* node){
     return taskStatus::SUCCESS;
 }
 
-template<class T>
-taskStatus Tree<T>::switchNodesLocation(Node<T>* node1, Node<T>* node2){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::switchNodesLocation(Node<T, Aggregate>* node1, Node<T, Aggregate>* node2){
     if(node1 == nullptr || node2 == nullptr){
         return taskStatus::INVALID_INPUT;
     }
-    Node<T>* node1Parent= node1->getParent();
-    Node<T>* node1Left = node1->getLeft();
-    Node<T>* node1Right = node1->getRight();
-    Node<T>* node2Parent= node2->getParent();
-    Node<T>* node2Left = node2->getLeft();
-    Node<T>* node2Right = node2->getRight();
+    Node<T, Aggregate>* node1Parent= node1->getParent();
+    Node<T, Aggregate>* node1Left = node1->getLeft();
+    Node<T, Aggregate>* node1Right = node1->getRight();
+    Node<T, Aggregate>* node2Parent= node2->getParent();
+    Node<T, Aggregate>* node2Left = node2->getLeft();
+    Node<T, Aggregate>* node2Right = node2->getRight();
     // lets assume 4 cases:
     // 1. node1 and node2 are seperate nodes, they are not connected to each other.
     // 2. node1 is the parent of node2.
@@ -711,11 +2300,8 @@ taskStatus Tree<T>::switchNodesLocation(Node<T>* node1, Node<T>* node2){
         node2->setRight(node1Right);
     }
     
-    T temp;
-    
-    temp = node1->data_m;
-    node1->data_m=node2->data_m;
-    node2->data_m=temp;
+    using std::swap;
+    swap(node1->data_m, node2->data_m);
     
     int tempHeight = node1->getHeight();
     int tempNodesInSubtree = node1->getNodesInSubtree();
@@ -726,12 +2312,16 @@ taskStatus Tree<T>::switchNodesLocation(Node<T>* node1, Node<T>* node2){
     node1->setNodesInSubtree(node2->getNodesInSubtree());
     node2->setNodesInSubtree(tempNodesInSubtree);
 
+    aggregate_type tempAggregate = node1->getAggregate();
+    node1->setAggregate(node2->getAggregate());
+    node2->setAggregate(tempAggregate);
+
 
     return taskStatus::SUCCESS;
 }
 
-template<class T>
-int Tree<T>::getBalance(Node<T>* node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+int Tree<T, Compare, Aggregate, Instrumentation>::getBalance(Node<T, Aggregate>* node){
     if(node == nullptr){
         return 0;
     }
@@ -749,8 +2339,8 @@ int Tree<T>::getBalance(Node<T>* node){
     }
 }
 
-template<class T>
-int Tree<T>::getBalanceFactor(Node<T>* node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+int Tree<T, Compare, Aggregate, Instrumentation>::getBalanceFactor(Node<T, Aggregate>* node){
     if(node == nullptr){
         return 0;
     }
@@ -759,8 +2349,8 @@ int Tree<T>::getBalanceFactor(Node<T>* node){
     return leftHeight - rightHeight;
 }
 
-template<class T>
-taskStatus Tree<T>::updateNodesInSubTree(Node<T> *node){
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus Tree<T, Compare, Aggregate, Instrumentation>::updateNodesInSubTree(Node<T, Aggregate> *node){
     int nodes=1;
     if (node->left_m != nullptr){
         nodes += node->left_m->getNodesInSubtree();
@@ -769,88 +2359,631 @@ taskStatus Tree<T>::updateNodesInSubTree(Node<T> *node){
         nodes += node->right_m->getNodesInSubtree();
     }
     node->setNodesInSubtree(nodes);
+    if constexpr (hasAggregate){
+        aggregate_type aggregate = Aggregate::fromData(node->data_m);
+        if (node->left_m != nullptr){
+            aggregate = Aggregate::combine(node->left_m->getAggregate(), aggregate);
+        }
+        if (node->right_m != nullptr){
+            aggregate = Aggregate::combine(aggregate, node->right_m->getAggregate());
+        }
+        node->setAggregate(aggregate);
+    }
     return taskStatus::SUCCESS;
 
 }
 
-template<class T>
-void Tree<T>::DestroyRecursive(Node<T>* node)
+template<class T, class Compare, class Aggregate, class Instrumentation>
+typename Aggregate::value_type Tree<T, Compare, Aggregate, Instrumentation>::getSubtreeAggregate(Node<T, Aggregate>* node){
+    if(node == nullptr){
+        return Aggregate::identity();
+    }
+    return node->getAggregate();
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void Tree<T, Compare, Aggregate, Instrumentation>::DestroyRecursive(Node<T, Aggregate>* node)
 {
     if (node)
     {
         DestroyRecursive(node->getLeft());
         DestroyRecursive(node->getRight());
-        delete node;
+        deallocateNode(node);
+    }
+}
+
+// nodes that are linked into the tree by hand (for example with createTreeFromSortedArray)
+// must be created with this method, since the tree gives them back to its pool.
+// the data is constructed in place from args, so it is never copied.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class... Args>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::allocateNode(Args&&... args){
+    Node<T, Aggregate>* node = pool_m->allocate(std::in_place, std::forward<Args>(args)...);
+    if(node != nullptr){
+        instrumentation_m.allocation(1);
+        // a new node is a leaf.
+        node->setHeight(1);
+        updateNodesInSubTree(node);
+    }
+    return node;
+}
+
+// count nodes one after the other in memory, nodes[i] is the ith. the nodes are not constructed: the caller must construct
+// every one of them in place (with std::in_place) and link them into the tree, this is what lets the threads of
+// assignParallel (AVLParallel.h) construct them side by side. returns nullptr if we are out of memory.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::allocateNodes(int count){
+    Node<T, Aggregate>* nodes = pool_m->allocateRange(count);
+    if(nodes != nullptr){
+        instrumentation_m.allocation(count);
+    }
+    return nodes;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void Tree<T, Compare, Aggregate, Instrumentation>::deallocateNode(Node<T, Aggregate>* node){
+    instrumentation_m.deallocation(1);
+    pool_m->deallocate(node);
+}
+
+// fixes the height and the count of node, and rotates it if it is out of balance.
+// the children of node must already be up to date. returns the node that took the place of node.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::rebalanceStep(Node<T, Aggregate>* node){
+    int balance = getBalance(node);
+    if(balance > 1){
+        if(getBalance(node->getLeft()) >= 0){
+            instrumentation_m.rotation(rotationKind::LL);
+            LLrotation(node);
+        }
+        else{
+            instrumentation_m.rotation(rotationKind::LR);
+            LRrotation(node);
+        }
+        return node->getParent();
+    }
+    if(balance < -1){
+        if(getBalance(node->getRight()) <= 0){
+            instrumentation_m.rotation(rotationKind::RR);
+            RRrotation(node);
+        }
+        else{
+            instrumentation_m.rotation(rotationKind::RL);
+            RLrotation(node);
+        }
+        return node->getParent();
+    }
+    updateHeight(node);
+    updateNodesInSubTree(node);
+    return node;
+}
+
+// joins the subtree left, the single node pivot and the subtree right into one balanced subtree, and returns its root.
+// all the keys in left must be smaller than the key of pivot, and all the keys in right must be bigger.
+// we go down the spine of the higher subtree until we reach the height of the lower one, hang the pivot there,
+// and fix the spine on the way back up, so the work is the difference between the heights.
+// the returned root has no parent. the nodes are only relinked, never moved.
+// root_m is not updated, the caller must set the root when it is done.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::joinWithPivot(Node<T, Aggregate>* left, Node<T, Aggregate>* pivot, Node<T, Aggregate>* right){
+    int leftHeight = left == nullptr ? 0 : left->getHeight();
+    int rightHeight = right == nullptr ? 0 : right->getHeight();
+    if(left != nullptr){
+        left->setParent(nullptr);
+    }
+    if(right != nullptr){
+        right->setParent(nullptr);
+    }
+    if(leftHeight <= rightHeight + 1 && rightHeight <= leftHeight + 1){
+        pivot->setParent(nullptr);
+        pivot->setLeft(left);
+        pivot->setRight(right);
+        if(left != nullptr){
+            left->setParent(pivot);
+        }
+        if(right != nullptr){
+            right->setParent(pivot);
+        }
+        updateHeight(pivot);
+        updateNodesInSubTree(pivot);
+        return pivot;
+    }
+    Node<T, Aggregate>* parent = nullptr;
+    if(leftHeight > rightHeight){
+        Node<T, Aggregate>* current = left;
+        while(current != nullptr && current->getHeight() > rightHeight + 1){
+            parent = current;
+            current = current->getRight();
+        }
+        pivot->setLeft(current);
+        pivot->setRight(right);
+        if(current != nullptr){
+            current->setParent(pivot);
+        }
+        if(right != nullptr){
+            right->setParent(pivot);
+        }
+        parent->setRight(pivot);
+    }
+    else{
+        Node<T, Aggregate>* current = right;
+        while(current != nullptr && current->getHeight() > leftHeight + 1){
+            parent = current;
+            current = current->getLeft();
+        }
+        pivot->setLeft(left);
+        pivot->setRight(current);
+        if(left != nullptr){
+            left->setParent(pivot);
+        }
+        if(current != nullptr){
+            current->setParent(pivot);
+        }
+        parent->setLeft(pivot);
+    }
+    pivot->setParent(parent);
+    updateHeight(pivot);
+    updateNodesInSubTree(pivot);
+    Node<T, Aggregate>* top = pivot;
+    for(Node<T, Aggregate>* current = parent; current != nullptr; current = current->getParent()){
+        current = rebalanceStep(current);
+        top = current;
+    }
+    return top;
+}
+
+// joins two subtrees where all the keys in left are smaller than all the keys in right, and returns the new root.
+// the biggest node of left is taken out of it and used as the pivot.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::joinSubtrees(Node<T, Aggregate>* left, Node<T, Aggregate>* right){
+    if(left == nullptr){
+        if(right != nullptr){
+            right->setParent(nullptr);
+        }
+        return right;
+    }
+    if(right == nullptr){
+        left->setParent(nullptr);
+        return left;
+    }
+    left->setParent(nullptr);
+    Node<T, Aggregate>* pivot = findMax(left);
+    Node<T, Aggregate>* parent = pivot->getParent();
+    Node<T, Aggregate>* child = pivot->getLeft();
+    if(child != nullptr){
+        child->setParent(parent);
+    }
+    if(parent == nullptr){
+        left = child;
+    }
+    else{
+        parent->setRight(child);
+        for(Node<T, Aggregate>* current = parent; current != nullptr; current = current->getParent()){
+            current = rebalanceStep(current);
+            left = current;
+        }
     }
+    return joinWithPivot(left, pivot, right);
+}
+
+// returns the number of keys in the tree that are smaller than data, data does not have to be in the tree.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+int Tree<T, Compare, Aggregate, Instrumentation>::countSmaller(const T& data){
+    Node<T, Aggregate>* current = root_m;
+    int smaller = 0;
+    int depth = 0;
+    while(current != nullptr){
+        depth++;
+        if(isBefore(current->data_m, data)){
+            smaller += 1;
+            if(current->getLeft() != nullptr){
+                smaller += current->getLeft()->getNodesInSubtree();
+            }
+            current = current->getRight();
+        }
+        else{
+            current = current->getLeft();
+        }
+    }
+    instrumentation_m.descent(depth);
+    return smaller;
+}
+
+// operator<=> is only used for the default orders, where it agrees with compare_m. it needs c++20.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Key>
+constexpr bool Tree<T, Compare, Aggregate, Instrumentation>::threeWayWith(){
+#if AVL_THREE_WAY_COMPARISON
+    return (std::is_same<Compare, std::less<T>>::value || std::is_same<Compare, std::less<>>::value)
+        && std::three_way_comparable_with<Key, T>;
+#else
+    return false;
+#endif
+}
+
+// a rank of any arithmetic type is compared as it is, so a 64 bit rank out of the range of int does not wrap into
+// a valid one when it is cast.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Rank>
+bool Tree<T, Compare, Aggregate, Instrumentation>::isRank(const Rank& rank, int size){
+    if constexpr (std::is_unsigned<Rank>::value){
+        return static_cast<unsigned long long>(rank) < static_cast<unsigned long long>(size);
+    }
+    else{
+        return rank >= 0 && rank < size;
+    }
+}
+
+// a single operator<=> when threeWayWith allows it, otherwise up to two calls to compare_m: the second one only when
+// key is not smaller than data. so the descents that must stop on an equal key (split) pays two calls on a
+// step to the right; the plain searches and findMany do not use it without operator<=>.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Key>
+int Tree<T, Compare, Aggregate, Instrumentation>::compareKeys(const Key& key, const T& data) const{
+#if AVL_THREE_WAY_COMPARISON
+    if constexpr (threeWayWith<Key>()){
+        instrumentation_m.comparison();
+        auto order = key <=> data;
+        return order < 0 ? -1 : (order > 0 ? 1 : 0);
+    }
+#endif
+    if(isBefore(key, data)){
+        return -1;
+    }
+    return isBefore(data, key) ? 1 : 0;
+}
+
+// splits the subtree of node into left, with the keys smaller than key, and right, with the keys bigger than key.
+// if key is in the subtree, its node is taken out on its own and returned, otherwise nullptr is returned.
+// the roots of left and right and the returned node have no parent. root_m is not updated.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* Tree<T, Compare, Aggregate, Instrumentation>::splitSubtree(Node<T, Aggregate>* node, const T& key, Node<T, Aggregate>*& left, Node<T, Aggregate>*& right){
+    if(node == nullptr){
+        left = nullptr;
+        right = nullptr;
+        return nullptr;
+    }
+    Node<T, Aggregate>* nodeLeft = node->getLeft();
+    Node<T, Aggregate>* nodeRight = node->getRight();
+    int order = compareKeys(key, node->data_m);
+    if(order > 0){
+        Node<T, Aggregate>* found = splitSubtree(nodeRight, key, nodeRight, right);
+        left = joinWithPivot(nodeLeft, node, nodeRight);
+        return found;
+    }
+    if(order < 0){
+        Node<T, Aggregate>* found = splitSubtree(nodeLeft, key, left, nodeLeft);
+        right = joinWithPivot(nodeLeft, node, nodeRight);
+        return found;
+    }
+    left = nodeLeft;
+    right = nodeRight;
+    if(left != nullptr){
+        left->setParent(nullptr);
+    }
+    if(right != nullptr){
+        right->setParent(nullptr);
+    }
+    node->setParent(nullptr);
+    node->setLeft(nullptr);
+    node->setRight(nullptr);
+    updateHeight(node);
+    updateNodesInSubTree(node);
+    return node;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //// helper classes
 
-// The following class is used to support output with status code.
-template<typename T>
-class tupleOutput {
-private:
-	
-	const taskStatus __status;
-	const T __ans;
-
-public:
-	tupleOutput() : __status(taskStatus::SUCCESS), __ans(T()) { }
-	tupleOutput(taskStatus status) : __status(status), __ans(T()) { }
-	tupleOutput(const T &ans) : __status(taskStatus::SUCCESS), __ans(ans) { }
-	
-	taskStatus status() { return __status; }
-	T ans() { return __ans; }
-};
 
 
-template<class T>
-class Node{
+template<class T, class Aggregate>
+class Node : public AggregateField<Aggregate>{
     public:
     T data_m;
     int height_m;
     int NodesInSubtree_m=0;
-    Node<T>* left_m=nullptr;
-    Node<T>* right_m=nullptr;
-    Node<T>* parent_m=nullptr;
+    Node<T, Aggregate>* left_m=nullptr;
+    Node<T, Aggregate>* right_m=nullptr;
+    Node<T, Aggregate>* parent_m=nullptr;
 
     public:
-    Node(T data, Node<T>* parent = nullptr, Node<T>* left = nullptr, Node<T>* right = nullptr);
+    Node(T data, Node<T, Aggregate>* parent = nullptr, Node<T, Aggregate>* left = nullptr, Node<T, Aggregate>* right = nullptr);
+    template<class... Args>
+    explicit Node(std::in_place_t, Args&&... args); // constructs the data in place from args
     ~Node();
-    T getData() const {return data_m;}
+    const T& getData() const {return data_m;}
     int getHeight() const {return height_m;}
-    Node<T>* getLeft() const {return left_m;}
-    Node<T>* getRight() const {return right_m;}
-    taskStatus setLeft(Node<T>* left) {this->left_m = left; return taskStatus::SUCCESS;}
-    taskStatus setRight(Node<T>* right) {this->right_m = right; return taskStatus::SUCCESS;}
+    Node<T, Aggregate>* getLeft() const {return left_m;}
+    Node<T, Aggregate>* getRight() const {return right_m;}
+    taskStatus setLeft(Node<T, Aggregate>* left) {storeNodeField<Aggregate>(left_m, left, std::memory_order_release); return taskStatus::SUCCESS;}
+    taskStatus setRight(Node<T, Aggregate>* right) {storeNodeField<Aggregate>(right_m, right, std::memory_order_release); return taskStatus::SUCCESS;}
     taskStatus setHeight(int height) {this->height_m = height; return taskStatus::SUCCESS;}
-    taskStatus setData(T data) {this->data_m = data; return taskStatus::SUCCESS;}
+    taskStatus setData(T data) {this->data_m = std::move(data); return taskStatus::SUCCESS;}
     taskStatus setRefData (T & data) {this->data_m = data; return taskStatus::SUCCESS;}
-    Node<T>* getParent() const {return parent_m;}
-    taskStatus setParent(Node<T>* parent) {this->parent_m = parent; return taskStatus::SUCCESS;}
+    Node<T, Aggregate>* getParent() const {return parent_m;}
+    taskStatus setParent(Node<T, Aggregate>* parent) {this->parent_m = parent; return taskStatus::SUCCESS;}
     int getNodesInSubtree() const {return NodesInSubtree_m;}
-    taskStatus setNodesInSubtree(int NodesInSubtree) {this->NodesInSubtree_m = NodesInSubtree; return taskStatus::SUCCESS;}
+    taskStatus setNodesInSubtree(int NodesInSubtree) {storeNodeField<Aggregate>(NodesInSubtree_m, NodesInSubtree, std::memory_order_relaxed); return taskStatus::SUCCESS;}
 
 };
 
 
 
-template<class T>
-Node<T>::Node(T data, Node<T>* parent, Node<T>* left, Node<T>* right): data_m(data), parent_m(parent), left_m(left), right_m(right), height_m(0){
-    this->data_m = data;
-    this->parent_m = parent;
-    this->left_m = left;
-    this->right_m = right;
-    this->height_m = 0;
+template<class T, class Aggregate>
+Node<T, Aggregate>::Node(T data, Node<T, Aggregate>* parent, Node<T, Aggregate>* left, Node<T, Aggregate>* right): data_m(std::move(data)), height_m(0), left_m(left), right_m(right), parent_m(parent){
 }
 
-template<class T>
-Node<T>::~Node(){
+template<class T, class Aggregate>
+template<class... Args>
+Node<T, Aggregate>::Node(std::in_place_t, Args&&... args): data_m(std::forward<Args>(args)...), height_m(0){
+}
+
+template<class T, class Aggregate>
+Node<T, Aggregate>::~Node(){
     this->left_m = nullptr;
     this->right_m = nullptr;
     this->parent_m = nullptr;
 
+}
+// The following class is a bidirectional iterator over the keys of a tree, in increasing order.
+// it walks with the parent pointers, so ++ and -- are O(1) amortized, and it stays valid as long as its node
+// is in the tree, even if other keys are inserted or removed.
+// the end iterator holds no node, so it keeps a pointer to the root of the tree, to be able to step back from the end.
+template<class T, class Aggregate>
+class TreeIterator{
+    private:
+    Node<T, Aggregate>* node_m;
+    Node<T, Aggregate>* const* root_m;
+
+    public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+    TreeIterator():node_m(nullptr), root_m(nullptr){}
+    TreeIterator(Node<T, Aggregate>* node, Node<T, Aggregate>* const* root):node_m(node), root_m(root){}
+
+    reference operator*() const {return node_m->data_m;}
+    pointer operator->() const {return &node_m->data_m;}
+    Node<T, Aggregate>* getNode() const {return node_m;} // the handle of the key, nullptr for the end iterator
+    TreeIterator& operator++() {node_m = findNext(node_m); return *this;}
+    TreeIterator operator++(int) {TreeIterator old = *this; ++*this; return old;}
+    TreeIterator& operator--();
+    TreeIterator operator--(int) {TreeIterator old = *this; --*this; return old;}
+    bool operator==(const TreeIterator& other) const {return node_m == other.node_m;}
+    bool operator!=(const TreeIterator& other) const {return node_m != other.node_m;}
+};
+
+template<class T, class Aggregate>
+TreeIterator<T, Aggregate>& TreeIterator<T, Aggregate>::operator--(){
+    if(node_m != nullptr){
+        node_m = findPrev(node_m);
+        return *this;
+    }
+    // stepping back from the end gives the biggest key.
+    node_m = *root_m;
+    if(node_m != nullptr){
+        while(node_m->getRight() != nullptr){
+            node_m = node_m->getRight();
+        }
+    }
+    return *this;
+}
+
+// The following class hands out node sized slots from big chunks of memory.
+// a slot is never moved once it was handed out, so the addresses of the nodes stay stable,
+// and freed slots are kept in a free list and reused by the next allocation.
+// the chunks are returned to the system only when the pool is destroyed, all at once.
+template<class N>
+class NodePool{
+    private:
+    union Slot{
+        Slot* next_m;
+        alignas(N) unsigned char storage_m[sizeof(N)];
+    };
+    struct Chunk{
+        Chunk* next_m;
+        int capacity_m;
+    };
+    // the slots start right after the chunk header, rounded up to the alignment of a slot.
+    static const size_t headerSize = (sizeof(Chunk) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+    static Slot* slotsOf(Chunk* chunk) {return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(chunk) + headerSize);}
+
+    static const int firstChunkCapacity = 32;
+    static const int maxChunkCapacity = 1 << 14;
+
+    Chunk* chunks_m = nullptr;
+    std::vector<std::shared_ptr<NodePool>> adopted_m; // pools whose nodes were joined into trees that use this pool
+    Slot* freeList_m = nullptr;
+    Slot* next_m = nullptr; // first slot that was never handed out in the newest chunk
+    Slot* end_m = nullptr;
+    int nextCapacity_m = firstChunkCapacity;
+    int freeCount_m = 0; // slots in the free list
+
+    bool grow(int capacity);
+    bool growFor(int count);
+
+    public:
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+    ~NodePool() {release();}
+
+    template<class... Args>
+    N* allocate(Args&&... args); // complexity O(1) amortized, returns nullptr if we are out of memory
+    void deallocate(N* node); // complexity O(1)
+    N* allocateRange(int count); // complexity O(1), count slots in a row that are not constructed, nullptr if we are out of memory
+    bool reserve(int count); // complexity O(1) amortized, the next count allocations can not fail, and are contiguous if the free list is empty
+    void release(); // complexity O(number of chunks), does not run the destructors of the nodes
+    void adopt(const std::shared_ptr<NodePool>& other); // complexity O(1)
+    bool keepsAlive(const NodePool* other) const; // complexity O(number of adopted pools)
+    size_t getBytes() const; // complexity O(number of chunks)
+    int countPools() const; // complexity O(number of adopted pools), this pool and every pool it keeps alive
+    template<class Function>
+    void forEachPool(Function&& visit) const; // complexity O(number of adopted pools)
+};
+
+template<class N>
+bool NodePool<N>::grow(int capacity){
+    Chunk* chunk = static_cast<Chunk*>(::operator new(headerSize + capacity * sizeof(Slot),
+                                                      std::align_val_t(alignof(Slot)), std::nothrow));
+    if(chunk == nullptr){
+        return false;
+    }
+    chunk->next_m = chunks_m;
+    chunk->capacity_m = capacity;
+    chunks_m = chunk;
+    next_m = slotsOf(chunk);
+    end_m = next_m + capacity;
+    if(nextCapacity_m < maxChunkCapacity){
+        nextCapacity_m *= 2;
+    }
+    return true;
+}
+
+template<class N>
+template<class... Args>
+N* NodePool<N>::allocate(Args&&... args){
+    Slot* slot;
+    if(freeList_m != nullptr){
+        slot = freeList_m;
+        freeList_m = slot->next_m;
+        freeCount_m--;
+    }
+    else{
+        if(next_m == end_m && !grow(nextCapacity_m)){
+            return nullptr;
+        }
+        slot = next_m++;
+    }
+    try{
+        return ::new (static_cast<void*>(slot->storage_m)) N(std::forward<Args>(args)...);
+    }
+    catch(...){
+        slot->next_m = freeList_m;
+        freeList_m = slot;
+        freeCount_m++;
+        throw;
+    }
+}
+
+// the free list counts too, so a batch of keys that are already in the tree, or that fit in the slots of erased
+// nodes, does not grow the pool.
+template<class N>
+bool NodePool<N>::reserve(int count){
+    if(freeCount_m + (end_m - next_m) >= count){
+        return true;
+    }
+    return growFor(count);
+}
+
+// makes room for count slots in a row. the rest of the current chunk goes to the free list first, from the last slot
+// to the first so they are handed out in order, otherwise every reserve that does not fit would lose it for good.
+template<class N>
+bool NodePool<N>::growFor(int count){
+    while(end_m != next_m){
+        Slot* slot = --end_m;
+        slot->next_m = freeList_m;
+        freeList_m = slot;
+        freeCount_m++;
+    }
+    return grow(count > nextCapacity_m ? count : nextCapacity_m);
+}
+
+// the slots are taken from a single chunk and never from the free list, so the caller can index them like an array.
+template<class N>
+N* NodePool<N>::allocateRange(int count){
+    static_assert(sizeof(Slot) == sizeof(N), "the slots of a range must be as far apart as the nodes of an array");
+    if(count <= 0 || (end_m - next_m < count && !growFor(count))){
+        return nullptr;
+    }
+    Slot* first = next_m;
+    next_m += count;
+    return reinterpret_cast<N*>(first->storage_m);
+}
+
+template<class N>
+void NodePool<N>::deallocate(N* node){
+    if(node == nullptr){
+        return;
+    }
+    node->~N();
+    Slot* slot = reinterpret_cast<Slot*>(node);
+    slot->next_m = freeList_m;
+    freeList_m = slot;
+    freeCount_m++;
+}
+
+template<class N>
+void NodePool<N>::release(){
+    while(chunks_m != nullptr){
+        Chunk* next = chunks_m->next_m;
+        ::operator delete(chunks_m, std::align_val_t(alignof(Slot)));
+        chunks_m = next;
+    }
+    freeList_m = nullptr;
+    freeCount_m = 0;
+    next_m = nullptr;
+    end_m = nullptr;
+    nextCapacity_m = firstChunkCapacity;
+    adopted_m.clear();
+}
+
+// after a join, a tree that uses this pool holds nodes from the memory of other,
+// so other has to live at least as long as this pool. freed nodes of other are reused by this pool.
+template<class N>
+void NodePool<N>::adopt(const std::shared_ptr<NodePool>& other){
+    adopted_m.push_back(other);
+}
+
+// the bytes of all the chunks, of this pool and of the pools it adopted, including the slots that are not in use.
+template<class N>
+size_t NodePool<N>::getBytes() const{
+    size_t bytes = 0;
+    forEachPool([&](const NodePool& pool){
+        for(Chunk* chunk = pool.chunks_m; chunk != nullptr; chunk = chunk->next_m){
+            bytes += headerSize + chunk->capacity_m * sizeof(Slot);
+        }
+    });
+    return bytes;
+}
+
+template<class N>
+bool NodePool<N>::keepsAlive(const NodePool* other) const{
+    bool found = false;
+    forEachPool([&](const NodePool& pool){found = found || &pool == other;});
+    return found;
+}
+
+template<class N>
+int NodePool<N>::countPools() const{
+    int count = 0;
+    forEachPool([&](const NodePool&){count++;});
+    return count;
+}
+
+// calls visit once for this pool and once for every pool it keeps alive. the adoptions never make a cycle
+// (see Tree::sharePoolWith), but two pools may adopt the same pool, and after many splits and joins there are
+// many paths to the same pool, so we remember the pools we have seen instead of following every path.
+template<class N>
+template<class Function>
+void NodePool<N>::forEachPool(Function&& visit) const{
+    std::vector<const NodePool*> stack(1, this);
+    std::unordered_set<const NodePool*> seen;
+    while(!stack.empty()){
+        const NodePool* pool = stack.back();
+        stack.pop_back();
+        if(!seen.insert(pool).second){
+            continue;
+        }
+        visit(*pool);
+        for(const std::shared_ptr<NodePool>& adopted : pool->adopted_m){
+            stack.push_back(adopted.get());
+        }
+    }
 }
 
  #endif //AVL_H
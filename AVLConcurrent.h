@@ -0,0 +1,324 @@
+
+/*
+this header file contains a version of the AVL rank tree for one writer and many reader threads.
+
+the readers never lock and never write to shared memory, and the writer never waits for them. the tree is guarded
+by a sequence lock: the writer makes the version odd before it changes the tree and even again when it is done,
+and a reader reads the version before and after it walks the tree. if the version was odd, or changed while it walked,
+something may have been rotated under it, so the reader throws away what it read and walks again.
+
+every field a reader loads is written and read as one atomic access (loadField and storeField in AVL.h): the keys,
+the links and the counts. the tree inside has the aggregate policy SharedLinks<Aggregate>, which makes the setters of
+Tree and Node store the links and the counts that way, so only this tree pays for it and a plain Tree does not. the writer stores a link with release order, and a reader loads it with acquire order, so
+a reader that follows a link sees the node behind it as the writer built it; the counts and the keys are relaxed,
+the version check orders them. besides that:
+ - a node is never destroyed or given back to the pool while the tree exists. remove and clear keep the nodes they
+   take out of the tree in a list of spare nodes, and insert takes a spare node before it asks the pool for a new one.
+   so every pointer a reader can see, even to a node that was removed or reused under it, points to a live node,
+   and the new key of a reused node is stored atomically like every other write.
+ - the keys are read with one atomic load, so they are trivially copyable and at most 8 bytes. the readers return
+   copies of keys, never Node pointers.
+ - a walk that is confused by a concurrent rotation may go around in a circle, so every walk gives up after
+   maxSteps steps (more than the height of any AVL tree of 2^31 nodes) and is retried.
+
+the writers are serialized by a mutex, so more than one thread may write, but the intended use is a single writer.
+*/
+
+
+
+#ifndef AVL_CONCURRENT_H
+#define AVL_CONCURRENT_H
+
+#include "AVL.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+template<class T, class Compare = std::less<T>, class Aggregate = NoAggregate<T>>
+class ConcurrentTree{
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(std::uint64_t) && alignof(T) == sizeof(T),
+                  "the readers load the keys with one atomic load");
+
+    private:
+    Tree<T, Compare, SharedLinks<Aggregate>> tree_m; // the links of its nodes are stored atomically, see SharedLinks in AVL.h
+    std::atomic<unsigned> version_m; // odd while the writer changes the tree
+    std::mutex writer_m;
+    Node<T, SharedLinks<Aggregate>>* spare_m; // removed nodes, linked by their parent pointers, which the readers never load
+
+    static const int maxSteps = 64;
+
+    static Node<T, SharedLinks<Aggregate>>* loadLink(Node<T, SharedLinks<Aggregate>>* const& link) {return loadField(link, std::memory_order_acquire);}
+    static int loadCount(const Node<T, SharedLinks<Aggregate>>* node) {return loadField(node->NodesInSubtree_m, std::memory_order_relaxed);}
+    static T loadKey(const Node<T, SharedLinks<Aggregate>>* node) {return loadField(node->data_m, std::memory_order_relaxed);}
+    void keepSpare(Node<T, SharedLinks<Aggregate>>* node); // puts the subtree of node on the list of spare nodes
+
+    template<class Function>
+    auto read(Function&& walk) const; // runs walk until it runs with no write overlapping it
+    void beginWrite();
+    void endWrite();
+
+    public:
+    //basic methods
+    explicit ConcurrentTree(const Compare& compare = Compare()) : tree_m(compare), version_m(0), spare_m(nullptr){}
+    ~ConcurrentTree(); // no reader may run by now
+    taskStatus insert(const T& data); // complexity O(logn), writer
+    taskStatus remove(const T& data); // complexity O(logn), writer
+    void clear(); // complexity O(n), writer
+    tupleOutput<T> find(const T& data) const; // complexity O(logn), reader
+    int getSize() const; // complexity O(1), reader
+
+    // advanced methods
+    tupleOutput<T> findKthElement(int k) const; // complexity O(logn), reader
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn), reader
+    int countRange(const T& low, const T& high) const; // complexity O(logn), reader
+};
+
+/*
+    taskStatus insert(const T& data); // complexity O(logn), writer
+    taskStatus remove(const T& data); // complexity O(logn), writer
+    void clear(); // complexity O(n), writer
+    tupleOutput<T> find(const T& data) const; // complexity O(logn), reader, returns a copy of the key in the tree
+    int getSize() const; // complexity O(1), reader
+*/
+
+// a write never waits for the readers, only for another writer.
+template<class T, class Compare, class Aggregate>
+void ConcurrentTree<T, Compare, Aggregate>::beginWrite(){
+    writer_m.lock();
+    version_m.store(version_m.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+template<class T, class Compare, class Aggregate>
+void ConcurrentTree<T, Compare, Aggregate>::endWrite(){
+    version_m.store(version_m.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    writer_m.unlock();
+}
+
+template<class T, class Compare, class Aggregate>
+ConcurrentTree<T, Compare, Aggregate>::~ConcurrentTree(){
+    while(spare_m != nullptr){
+        Node<T, SharedLinks<Aggregate>>* next = spare_m->getParent();
+        tree_m.deallocateNode(spare_m);
+        spare_m = next;
+    }
+}
+
+template<class T, class Compare, class Aggregate>
+void ConcurrentTree<T, Compare, Aggregate>::keepSpare(Node<T, SharedLinks<Aggregate>>* node){
+    if(node == nullptr){
+        return;
+    }
+    keepSpare(node->getLeft());
+    keepSpare(node->getRight());
+    node->setLeft(nullptr);
+    node->setRight(nullptr);
+    node->setHeight(1);
+    tree_m.updateNodesInSubTree(node);
+    node->setParent(spare_m);
+    spare_m = node;
+}
+
+// a spare node is a single node already, so only its key (and its aggregate) changes.
+template<class T, class Compare, class Aggregate>
+taskStatus ConcurrentTree<T, Compare, Aggregate>::insert(const T& data){
+    beginWrite();
+    Node<T, SharedLinks<Aggregate>>* parent = nullptr;
+    taskStatus status = tree_m.insertionPoint(data, parent);
+    if(status == taskStatus::SUCCESS){
+        Node<T, SharedLinks<Aggregate>>* node = spare_m;
+        if(node != nullptr){
+            spare_m = node->getParent();
+            storeField(node->data_m, data, std::memory_order_relaxed);
+            tree_m.updateNodesInSubTree(node); // the aggregate of the node, if there is one
+        }
+        else{
+            node = tree_m.allocateNode(data);
+        }
+        if(node == nullptr){
+            status = taskStatus::ALLOCATION_ERROR;
+        }
+        else{
+            tree_m.linkNode(node, parent);
+        }
+    }
+    endWrite();
+    return status;
+}
+
+template<class T, class Compare, class Aggregate>
+taskStatus ConcurrentTree<T, Compare, Aggregate>::remove(const T& data){
+    beginWrite();
+    tupleOutput<Node<T, SharedLinks<Aggregate>>*> node = tree_m.find(data);
+    if(node.status() == taskStatus::SUCCESS){
+        tree_m.unlinkNode(node.ans());
+        keepSpare(node.ans());
+    }
+    endWrite();
+    return node.status();
+}
+
+// the nodes stay spare nodes, so a reader that is still walking reads live nodes.
+template<class T, class Compare, class Aggregate>
+void ConcurrentTree<T, Compare, Aggregate>::clear(){
+    beginWrite();
+    Node<T, SharedLinks<Aggregate>>* root = tree_m.getRoot();
+    tree_m.setRoot(nullptr);
+    keepSpare(root);
+    endWrite();
+}
+
+// walk gets a bool& it sets to false if it gave up, and returns what it read.
+template<class T, class Compare, class Aggregate>
+template<class Function>
+auto ConcurrentTree<T, Compare, Aggregate>::read(Function&& walk) const{
+    while(true){
+        unsigned before = version_m.load(std::memory_order_acquire);
+        if(before & 1){
+            std::this_thread::yield();
+            continue;
+        }
+        bool complete = true;
+        auto result = walk(complete);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(complete && version_m.load(std::memory_order_relaxed) == before){
+            return result;
+        }
+    }
+}
+
+template<class T, class Compare, class Aggregate>
+tupleOutput<T> ConcurrentTree<T, Compare, Aggregate>::find(const T& data) const{
+    Compare compare = tree_m.getCompare();
+    return read([&](bool& complete){
+        Node<T, SharedLinks<Aggregate>>* current = tree_m.getRoot();
+        for(int steps = 0; current != nullptr; steps++){
+            if(steps == maxSteps){
+                complete = false;
+                break;
+            }
+            T key = loadKey(current);
+            if(compare(data, key)){
+                current = loadLink(current->left_m);
+            }
+            else if(compare(key, data)){
+                current = loadLink(current->right_m);
+            }
+            else{
+                return tupleOutput<T>(key);
+            }
+        }
+        return tupleOutput<T>(taskStatus::FAILURE);
+    });
+}
+
+template<class T, class Compare, class Aggregate>
+int ConcurrentTree<T, Compare, Aggregate>::getSize() const{
+    return read([&](bool&){
+        Node<T, SharedLinks<Aggregate>>* root = tree_m.getRoot();
+        return root == nullptr ? 0 : loadCount(root);
+    });
+}
+
+/*
+    tupleOutput<T> findKthElement(int k) const; // complexity O(logn), reader
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn), reader
+    int countRange(const T& low, const T& high) const; // complexity O(logn), reader
+*/
+
+template<class T, class Compare, class Aggregate>
+tupleOutput<T> ConcurrentTree<T, Compare, Aggregate>::findKthElement(int k) const{
+    return read([&](bool& complete){
+        Node<T, SharedLinks<Aggregate>>* current = tree_m.getRoot();
+        int left = k;
+        if(current == nullptr || left < 0 || left >= loadCount(current)){
+            return tupleOutput<T>(taskStatus::INVALID_INPUT);
+        }
+        for(int steps = 0; current != nullptr; steps++){
+            if(steps == maxSteps){
+                complete = false;
+                break;
+            }
+            Node<T, SharedLinks<Aggregate>>* leftChild = loadLink(current->left_m);
+            int leftNodes = leftChild == nullptr ? 0 : loadCount(leftChild);
+            if(left == leftNodes){
+                return tupleOutput<T>(loadKey(current));
+            }
+            if(left < leftNodes){
+                current = leftChild;
+            }
+            else{
+                left -= leftNodes + 1;
+                current = loadLink(current->right_m);
+            }
+        }
+        return tupleOutput<T>(taskStatus::FAILURE);
+    });
+}
+
+template<class T, class Compare, class Aggregate>
+tupleOutput<int> ConcurrentTree<T, Compare, Aggregate>::rank(const T& data) const{
+    Compare compare = tree_m.getCompare();
+    return read([&](bool& complete){
+        Node<T, SharedLinks<Aggregate>>* current = tree_m.getRoot();
+        int smaller = 0;
+        for(int steps = 0; current != nullptr; steps++){
+            if(steps == maxSteps){
+                complete = false;
+                break;
+            }
+            T key = loadKey(current);
+            Node<T, SharedLinks<Aggregate>>* leftChild = loadLink(current->left_m);
+            int leftNodes = leftChild == nullptr ? 0 : loadCount(leftChild);
+            if(compare(data, key)){
+                current = leftChild;
+            }
+            else if(compare(key, data)){
+                smaller += leftNodes + 1;
+                current = loadLink(current->right_m);
+            }
+            else{
+                return tupleOutput<int>(smaller + leftNodes);
+            }
+        }
+        return tupleOutput<int>(taskStatus::FAILURE);
+    });
+}
+
+// the number of keys in [low, high), both bounds are counted in the same walk over the tree.
+template<class T, class Compare, class Aggregate>
+int ConcurrentTree<T, Compare, Aggregate>::countRange(const T& low, const T& high) const{
+    Compare compare = tree_m.getCompare();
+    if(!compare(low, high)){
+        return 0;
+    }
+    auto countSmaller = [&](const T& bound, bool& complete){
+        Node<T, SharedLinks<Aggregate>>* current = tree_m.getRoot();
+        int smaller = 0;
+        for(int steps = 0; current != nullptr; steps++){
+            if(steps == maxSteps){
+                complete = false;
+                break;
+            }
+            Node<T, SharedLinks<Aggregate>>* leftChild = loadLink(current->left_m);
+            if(compare(loadKey(current), bound)){
+                smaller += (leftChild == nullptr ? 0 : loadCount(leftChild)) + 1;
+                current = loadLink(current->right_m);
+            }
+            else{
+                current = leftChild;
+            }
+        }
+        return smaller;
+    };
+    return read([&](bool& complete){
+        int highCount = countSmaller(high, complete);
+        return highCount - countSmaller(low, complete);
+    });
+}
+
+#endif //AVL_CONCURRENT_H
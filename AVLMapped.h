@@ -0,0 +1,210 @@
+
+/*
+this header file contains a read only AVL rank tree that answers straight from a file written by Tree::save.
+
+open maps the file into memory and checks only its header, so it costs the same for any size of tree, and the
+pages of the file are read by the system when a lookup first touches them. the nodes are in breadth first order,
+so the top levels of the tree, that every lookup passes through, share a few pages.
+the file is never changed, and many processes that open the same file share its pages.
+
+the keys must be trivially copyable, like for save. the answers point into the mapped file, so they are valid until
+close (or the destructor). the rest of the file is not checked by open, so a walk that meets a child index that
+can not be right (not after its parent, or out of the file) stops with INVALID_INPUT instead of going around in circles.
+this uses mmap, so it is for posix systems only, on others open returns FAILURE.
+*/
+
+
+
+#ifndef AVL_MAPPED_H
+#define AVL_MAPPED_H
+
+#include "AVL.h"
+
+#include <functional>
+#include <type_traits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define AVL_HAS_MMAP 1
+#else
+#define AVL_HAS_MMAP 0
+#endif
+
+template<class T, class Compare = std::less<T>>
+class MappedTree{
+    static_assert(std::is_trivially_copyable<T>::value, "the keys are read from the file as bytes");
+
+    private:
+    void* map_m;
+    size_t length_m;
+    const SnapshotNode<T>* nodes_m;
+    int count_m;
+    Compare compare_m;
+
+    public:
+    //basic methods
+    explicit MappedTree(const Compare& compare = Compare()) : map_m(nullptr), length_m(0), nodes_m(nullptr), count_m(0), compare_m(compare){}
+    MappedTree(const MappedTree&) = delete;
+    MappedTree& operator=(const MappedTree&) = delete;
+    ~MappedTree() {close();}
+    taskStatus open(const char* path); // complexity O(1)
+    void close(); // complexity O(1)
+    tupleOutput<const T*> find(const T& data) const; // complexity O(logn)
+    int getSize() const {return count_m;} // complexity O(1)
+
+    // advanced methods
+    tupleOutput<const T*> findKthElement(int k) const; // complexity O(logn)
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn)
+};
+
+/*
+    taskStatus open(const char* path); // complexity O(1), FAILURE if the file can not be mapped, INVALID_INPUT if it is not a snapshot of T
+    void close(); // complexity O(1)
+    tupleOutput<const T*> find(const T& data) const; // complexity O(logn), points into the file
+    int getSize() const; // complexity O(1)
+*/
+
+template<class T, class Compare>
+taskStatus MappedTree<T, Compare>::open(const char* path){
+    close();
+#if AVL_HAS_MMAP
+    int file = ::open(path, O_RDONLY);
+    if(file < 0){
+        return taskStatus::FAILURE;
+    }
+    struct stat status;
+    if(::fstat(file, &status) != 0){
+        ::close(file);
+        return taskStatus::FAILURE;
+    }
+    if(status.st_size < 0 || static_cast<size_t>(status.st_size) < sizeof(SnapshotHeader)){
+        ::close(file);
+        return taskStatus::INVALID_INPUT;
+    }
+    size_t length = static_cast<size_t>(status.st_size);
+    void* map = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file); // the mapping keeps the file
+    if(map == MAP_FAILED){
+        return taskStatus::FAILURE;
+    }
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(map);
+    if(!header->matches<SnapshotNode<T>>()
+       || length < sizeof(SnapshotHeader) + static_cast<size_t>(header->count_m) * sizeof(SnapshotNode<T>)){
+        ::munmap(map, length);
+        return taskStatus::INVALID_INPUT;
+    }
+    map_m = map;
+    length_m = length;
+    count_m = header->count_m;
+    nodes_m = reinterpret_cast<const SnapshotNode<T>*>(static_cast<const char*>(map) + sizeof(SnapshotHeader));
+    return taskStatus::SUCCESS;
+#else
+    (void)path;
+    return taskStatus::FAILURE;
+#endif
+}
+
+template<class T, class Compare>
+void MappedTree<T, Compare>::close(){
+#if AVL_HAS_MMAP
+    if(map_m != nullptr){
+        ::munmap(map_m, length_m);
+    }
+#endif
+    map_m = nullptr;
+    length_m = 0;
+    nodes_m = nullptr;
+    count_m = 0;
+}
+
+// the same descent as Tree::find, by the indices of the children.
+template<class T, class Compare>
+tupleOutput<const T*> MappedTree<T, Compare>::find(const T& data) const{
+    std::uint32_t index = count_m == 0 ? SnapshotHeader::nil : 0;
+    while(index != SnapshotHeader::nil){
+        const SnapshotNode<T>& node = nodes_m[index];
+        std::uint32_t next;
+        if(compare_m(data, node.data_m)){
+            next = node.left_m;
+        }
+        else if(compare_m(node.data_m, data)){
+            next = node.right_m;
+        }
+        else{
+            return tupleOutput<const T*>(&node.data_m);
+        }
+        if(next != SnapshotHeader::nil && (next <= index || next >= static_cast<std::uint32_t>(count_m))){
+            return tupleOutput<const T*>(taskStatus::INVALID_INPUT);
+        }
+        index = next;
+    }
+    return tupleOutput<const T*>(taskStatus::FAILURE);
+}
+
+/*
+    tupleOutput<const T*> findKthElement(int k) const; // complexity O(logn), k is 0 based
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn)
+*/
+
+template<class T, class Compare>
+tupleOutput<const T*> MappedTree<T, Compare>::findKthElement(int k) const{
+    if(k < 0 || k >= count_m){
+        return tupleOutput<const T*>(taskStatus::INVALID_INPUT);
+    }
+    std::uint32_t index = 0;
+    while(true){
+        const SnapshotNode<T>& node = nodes_m[index];
+        if(node.left_m != SnapshotHeader::nil && (node.left_m <= index || node.left_m >= static_cast<std::uint32_t>(count_m))){
+            return tupleOutput<const T*>(taskStatus::INVALID_INPUT);
+        }
+        int leftNodes = node.left_m == SnapshotHeader::nil ? 0 : nodes_m[node.left_m].nodesInSubtree_m;
+        std::uint32_t next;
+        if(k == leftNodes){
+            return tupleOutput<const T*>(&node.data_m);
+        }
+        if(k < leftNodes){
+            next = node.left_m;
+        }
+        else{
+            k -= leftNodes + 1;
+            next = node.right_m;
+        }
+        if(next == SnapshotHeader::nil || next <= index || next >= static_cast<std::uint32_t>(count_m)){
+            return tupleOutput<const T*>(taskStatus::INVALID_INPUT);
+        }
+        index = next;
+    }
+}
+
+template<class T, class Compare>
+tupleOutput<int> MappedTree<T, Compare>::rank(const T& data) const{
+    std::uint32_t index = count_m == 0 ? SnapshotHeader::nil : 0;
+    int smaller = 0;
+    while(index != SnapshotHeader::nil){
+        const SnapshotNode<T>& node = nodes_m[index];
+        if(node.left_m != SnapshotHeader::nil && (node.left_m <= index || node.left_m >= static_cast<std::uint32_t>(count_m))){
+            return tupleOutput<int>(taskStatus::INVALID_INPUT);
+        }
+        int leftNodes = node.left_m == SnapshotHeader::nil ? 0 : nodes_m[node.left_m].nodesInSubtree_m;
+        std::uint32_t next;
+        if(compare_m(data, node.data_m)){
+            next = node.left_m;
+        }
+        else if(compare_m(node.data_m, data)){
+            smaller += leftNodes + 1;
+            next = node.right_m;
+        }
+        else{
+            return tupleOutput<int>(smaller + leftNodes);
+        }
+        if(next != SnapshotHeader::nil && (next <= index || next >= static_cast<std::uint32_t>(count_m))){
+            return tupleOutput<int>(taskStatus::INVALID_INPUT);
+        }
+        index = next;
+    }
+    return tupleOutput<int>(taskStatus::FAILURE);
+}
+
+#endif //AVL_MAPPED_H
@@ -0,0 +1,261 @@
+
+/*
+this header file contains a multiset built on the AVL rank tree: every key can be in the set many times.
+
+every node holds a key and its number of copies, and the number of copies in every subtree is kept with the
+aggregate policy of Tree (MultisetCopies below), next to the number of nodes. so findKthElement, rank and getSize
+count every copy of a key, and adding or removing a copy of a key that is already in the set only changes the
+count of its node and the aggregates above it: no allocation and no rotation.
+a node is removed only when its last copy is removed, and like in Tree, a node never moves in memory.
+the counts are ints, so the set holds at most INT_MAX copies in all, an insert past that fails with ALLOCATION_ERROR.
+*/
+
+
+
+#ifndef AVL_MULTISET_H
+#define AVL_MULTISET_H
+
+#include "AVL.h"
+
+#include <functional>
+#include <limits>
+#include <utility>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// helper classes
+// The following class is the key of a node of the multiset: a key and its number of copies.
+template<class T>
+struct MultisetEntry{
+    T key_m;
+    int copies_m;
+};
+
+// The following class orders the entries by their keys only. it is transparent, so the tree can find an entry by a key.
+template<class T, class Compare>
+class MultisetCompare{
+    private:
+    Compare compare_m;
+
+    public:
+    typedef void is_transparent;
+    explicit MultisetCompare(const Compare& compare = Compare()) : compare_m(compare){}
+    bool operator()(const MultisetEntry<T>& first, const MultisetEntry<T>& second) const {return compare_m(first.key_m, second.key_m);}
+    bool operator()(const MultisetEntry<T>& first, const T& second) const {return compare_m(first.key_m, second);}
+    bool operator()(const T& first, const MultisetEntry<T>& second) const {return compare_m(first, second.key_m);}
+};
+
+// The following class is the aggregate policy that counts the copies in every subtree.
+template<class T>
+class MultisetCopies{
+    public:
+    typedef int value_type;
+    static value_type identity() {return 0;}
+    static value_type fromData(const MultisetEntry<T>& data) {return data.copies_m;}
+    static value_type combine(const value_type& left, const value_type& right) {return left + right;}
+};
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class T, class Compare = std::less<T>>
+class Multiset{
+    public:
+    typedef Tree<MultisetEntry<T>, MultisetCompare<T, Compare>, MultisetCopies<T>> tree_type;
+    typedef Node<MultisetEntry<T>, MultisetCopies<T>> node_type;
+    typedef typename tree_type::iterator iterator; // goes over the distinct keys, ->copies_m is the number of copies
+
+    private:
+    tree_type tree_m;
+
+    taskStatus updateCopies(node_type* node, int copies); // complexity O(logn)
+
+    public:
+    //basic methods
+    explicit Multiset(const Compare& compare = Compare()) : tree_m(MultisetCompare<T, Compare>(compare)){}
+    void clear() {tree_m.clear();} // complexity O(n)
+    tupleOutput<node_type*> insert(const T& key, int copies = 1); // complexity O(logn)
+    taskStatus remove(const T& key, int copies = 1); // complexity O(logn)
+    taskStatus erase(node_type* node) {return tree_m.erase(node);} // complexity O(logn)
+    tupleOutput<node_type*> find(const T& key) {return tree_m.find(key);} // complexity O(logn)
+    int count(const T& key); // complexity O(logn)
+    int getSize() const; // complexity O(1)
+    int getDistinct() const {return tree_m.getSize();} // complexity O(1)
+
+    // advanced methods
+    tupleOutput<node_type*> findKthElement(int k); // complexity O(logn)
+    tupleOutput<int> rank(const T& key); // complexity O(logn)
+    int countSmaller(const T& key); // complexity O(logn)
+    int countRange(const T& low, const T& high); // complexity O(logn)
+    iterator begin() const {return tree_m.begin();} // complexity O(logn)
+    iterator end() const {return tree_m.end();} // complexity O(1)
+
+    // helper methods
+    node_type* getRoot() const {return tree_m.getRoot();}
+    const tree_type& getTree() const {return tree_m;}
+};
+
+/*
+    void clear(); // complexity O(n)
+    tupleOutput<node_type*> insert(const T& key, int copies = 1); // complexity O(logn), at most INT_MAX copies in all
+    taskStatus remove(const T& key, int copies = 1); // complexity O(logn)
+    taskStatus erase(node_type* node); // complexity O(logn), removes all the copies of the key of node
+    tupleOutput<node_type*> find(const T& key); // complexity O(logn)
+    int count(const T& key); // complexity O(logn)
+    int getSize() const; // complexity O(1), counts every copy
+    int getDistinct() const; // complexity O(1), counts every key once
+*/
+
+// a key that is already in the set only gets more copies, in its node. one descent finds either its node or the
+// place of a new node.
+// the copies of a node and of every subtree are at most the copies of the whole set, so checking the total is enough
+// to keep every count from overflowing.
+template<class T, class Compare>
+tupleOutput<typename Multiset<T, Compare>::node_type*> Multiset<T, Compare>::insert(const T& key, int copies){
+    if(copies < 1){
+        return tupleOutput<node_type*>(taskStatus::INVALID_INPUT);
+    }
+    if(copies > std::numeric_limits<int>::max() - getSize()){
+        return tupleOutput<node_type*>(taskStatus::ALLOCATION_ERROR);
+    }
+    MultisetEntry<T> entry{key, copies};
+    node_type* parent = nullptr;
+    if(tree_m.insertionPoint(entry, parent) != taskStatus::SUCCESS){
+        updateCopies(parent, parent->data_m.copies_m + copies);
+        return tupleOutput<node_type*>(parent);
+    }
+    node_type* node = tree_m.allocateNode(std::move(entry));
+    if(node == nullptr){
+        return tupleOutput<node_type*>(taskStatus::ALLOCATION_ERROR);
+    }
+    tree_m.linkNode(node, parent);
+    return tupleOutput<node_type*>(node);
+}
+
+// removes copies copies of key, or all of them if there are fewer. the node goes only with its last copy.
+template<class T, class Compare>
+taskStatus Multiset<T, Compare>::remove(const T& key, int copies){
+    if(copies < 1){
+        return taskStatus::INVALID_INPUT;
+    }
+    tupleOutput<node_type*> found = tree_m.find(key);
+    if(found.status() != taskStatus::SUCCESS){
+        return found.status();
+    }
+    node_type* node = found.ans();
+    if(node->data_m.copies_m <= copies){
+        return tree_m.erase(node);
+    }
+    return updateCopies(node, node->data_m.copies_m - copies);
+}
+
+template<class T, class Compare>
+int Multiset<T, Compare>::count(const T& key){
+    tupleOutput<node_type*> found = tree_m.find(key);
+    if(found.status() != taskStatus::SUCCESS){
+        return 0;
+    }
+    return found.ans()->data_m.copies_m;
+}
+
+template<class T, class Compare>
+int Multiset<T, Compare>::getSize() const{
+    return tree_type::getSubtreeAggregate(tree_m.getRoot());
+}
+
+/*
+    tupleOutput<node_type*> findKthElement(int k); // complexity O(logn), k counts every copy
+    tupleOutput<int> rank(const T& key); // complexity O(logn), the number of copies of smaller keys
+    int countSmaller(const T& key); // complexity O(logn)
+    int countRange(const T& low, const T& high); // complexity O(logn)
+    iterator begin() const; // complexity O(logn)
+    iterator end() const; // complexity O(1)
+*/
+
+// the node of the kth smallest copy, k is 0 based. for the median of n copies, k is n/2.
+template<class T, class Compare>
+tupleOutput<typename Multiset<T, Compare>::node_type*> Multiset<T, Compare>::findKthElement(int k){
+    if(k < 0 || k >= getSize()){
+        return tupleOutput<node_type*>(taskStatus::INVALID_INPUT);
+    }
+    node_type* node = tree_m.getRoot();
+    while(node != nullptr){
+        int leftCopies = tree_type::getSubtreeAggregate(node->getLeft());
+        if(k < leftCopies){
+            node = node->getLeft();
+        }
+        else if(k < leftCopies + node->data_m.copies_m){
+            return tupleOutput<node_type*>(node);
+        }
+        else{
+            k -= leftCopies + node->data_m.copies_m;
+            node = node->getRight();
+        }
+    }
+    return tupleOutput<node_type*>(taskStatus::FAILURE);
+}
+
+// like Tree::rank, FAILURE if key is not in the set.
+// a single descent, like Tree::find: we remember the last node that is not smaller than key and the copies before it,
+// it is the only node that can hold key, so one more comparison at the bottom tells if key is there.
+template<class T, class Compare>
+tupleOutput<int> Multiset<T, Compare>::rank(const T& key){
+    MultisetCompare<T, Compare> compare = tree_m.getCompare();
+    node_type* current = tree_m.getRoot();
+    node_type* bound = nullptr;
+    int smaller = 0;
+    int boundSmaller = 0;
+    while(current != nullptr){
+        int leftCopies = tree_type::getSubtreeAggregate(current->getLeft());
+        if(compare(current->data_m, key)){
+            smaller += leftCopies + current->data_m.copies_m;
+            current = current->getRight();
+        }
+        else{
+            bound = current;
+            boundSmaller = smaller + leftCopies;
+            current = current->getLeft();
+        }
+    }
+    if(bound == nullptr || compare(key, bound->data_m)){
+        return tupleOutput<int>(taskStatus::FAILURE);
+    }
+    return tupleOutput<int>(boundSmaller);
+}
+
+// the number of copies of keys smaller than key, key does not have to be in the set.
+template<class T, class Compare>
+int Multiset<T, Compare>::countSmaller(const T& key){
+    MultisetCompare<T, Compare> compare = tree_m.getCompare();
+    node_type* current = tree_m.getRoot();
+    int smaller = 0;
+    while(current != nullptr){
+        if(compare(current->data_m, key)){
+            smaller += tree_type::getSubtreeAggregate(current->getLeft()) + current->data_m.copies_m;
+            current = current->getRight();
+        }
+        else{
+            current = current->getLeft();
+        }
+    }
+    return smaller;
+}
+
+// the number of copies in [low, high).
+template<class T, class Compare>
+int Multiset<T, Compare>::countRange(const T& low, const T& high){
+    MultisetCompare<T, Compare> compare = tree_m.getCompare();
+    if(!compare(MultisetEntry<T>{low, 0}, MultisetEntry<T>{high, 0})){
+        return 0;
+    }
+    return countSmaller(high) - countSmaller(low);
+}
+
+// the copies do not take part in the order, so they can change in place. only the aggregates above the node change.
+template<class T, class Compare>
+taskStatus Multiset<T, Compare>::updateCopies(node_type* node, int copies){
+    node->data_m.copies_m = copies;
+    for(node_type* current = node; current != nullptr; current = current->getParent()){
+        tree_m.updateNodesInSubTree(current);
+    }
+    return taskStatus::SUCCESS;
+}
+
+#endif //AVL_MULTISET_H
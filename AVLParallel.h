@@ -0,0 +1,151 @@
+
+/*
+this header file contains a parallel build of an AVL rank tree from a sorted range, and a parallel export of the
+keys of a tree to an array, both on the threads of a ThreadPool.
+
+both are O(n) work, and they split along the subtree counts with no coordination between the threads: in a tree
+of n nodes the key of rank k goes to out[k], so the subtree of a node writes exactly the part of the array
+[rank of its smallest key, rank of its smallest key + NodesInSubtree_m), and the two children of a node can be done
+by two threads at once. the build is the same split the other way: the middle key of a range is the root,
+and the halves to its left and to its right are built on their own.
+a subtree smaller than a cutoff is done on the thread that reached it, so tiny tasks do not cost more than they save.
+
+the build takes the nodes as one block from the pool (Tree::allocateNodes), so the nodes are in order in memory,
+like after assign, and every thread constructs its own nodes in place. the keys must be nothrow copy constructible
+(and nothrow copy assignable for the export), since a key that throws halfway through would leave
+nodes that are not constructed in the tree; other keys are done on the calling thread.
+the tree must not be used by other threads while these run.
+*/
+
+
+
+#ifndef AVL_PARALLEL_H
+#define AVL_PARALLEL_H
+
+#include "AVL.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// interface
+template<class T, class Compare, class Aggregate, class Instrumentation, class Iterator>
+taskStatus assignParallel(Tree<T, Compare, Aggregate, Instrumentation>& tree, Iterator first, Iterator last, ThreadPool* threads = nullptr); // complexity O(n)
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus toArrayParallel(Tree<T, Compare, Aggregate, Instrumentation>& tree, T* out, ThreadPool* threads = nullptr); // complexity O(n)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The following class holds the state of one parallel build or export.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+class TreeParallelWalk{
+    private:
+    Tree<T, Compare, Aggregate, Instrumentation>& tree_m;
+    ThreadPool* threads_m;
+    Compare compare_m; // a copy, so the threads do not count comparisons in the instrumentation of the tree
+    std::atomic<bool> sorted_m;
+
+    static const int sequentialCutoff = 1 << 14; // below this many nodes in a subtree, we do not fork
+
+    public:
+    TreeParallelWalk(Tree<T, Compare, Aggregate, Instrumentation>& tree, ThreadPool* threads)
+        : tree_m(tree), threads_m(threads), compare_m(tree.getCompare()), sorted_m(true){}
+    template<class Iterator>
+    Node<T, Aggregate>* build(Iterator first, Node<T, Aggregate>* nodes, int begin, int end, Node<T, Aggregate>* parent);
+    void copy(const Node<T, Aggregate>* node, T* out);
+    bool isSorted() const {return sorted_m.load();}
+};
+
+// builds the keys first[begin, end) into a balanced subtree of the nodes nodes[begin, end) and returns its root.
+// the shape is the same as the one of assign. every key but the first is checked against the key before it,
+// once, by the call that constructs its node.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+template<class Iterator>
+Node<T, Aggregate>* TreeParallelWalk<T, Compare, Aggregate, Instrumentation>::build(Iterator first, Node<T, Aggregate>* nodes, int begin, int end, Node<T, Aggregate>* parent){
+    if(begin == end){
+        return nullptr;
+    }
+    int mid = begin + (end - begin - 1) / 2;
+    Node<T, Aggregate>* node = ::new (static_cast<void*>(nodes + mid)) Node<T, Aggregate>(std::in_place, first[mid]);
+    if(mid > 0 && !compare_m(first[mid - 1], first[mid])){
+        sorted_m.store(false, std::memory_order_relaxed);
+    }
+    node->setParent(parent);
+    Node<T, Aggregate>* left = nullptr;
+    Node<T, Aggregate>* right = nullptr;
+    if(threads_m != nullptr && end - begin >= sequentialCutoff){
+        threads_m->parallelInvoke([&]{left = build(first, nodes, begin, mid, node);},
+                                  [&]{right = build(first, nodes, mid + 1, end, node);});
+    }
+    else{
+        left = build(first, nodes, begin, mid, node);
+        right = build(first, nodes, mid + 1, end, node);
+    }
+    node->setLeft(left);
+    node->setRight(right);
+    tree_m.updateHeight(node);
+    tree_m.updateNodesInSubTree(node);
+    return node;
+}
+
+// writes the keys of the subtree of node in order to out, out[0] gets the smallest one.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void TreeParallelWalk<T, Compare, Aggregate, Instrumentation>::copy(const Node<T, Aggregate>* node, T* out){
+    // we recurse to the left and loop to the right, so a small subtree costs one call per left child only.
+    while(node != nullptr){
+        int leftNodes = node->left_m == nullptr ? 0 : node->left_m->NodesInSubtree_m;
+        out[leftNodes] = node->data_m;
+        if(threads_m != nullptr && node->NodesInSubtree_m >= sequentialCutoff){
+            threads_m->parallelInvoke([&]{copy(node->left_m, out);},
+                                      [&]{copy(node->right_m, out + leftNodes + 1);});
+            return;
+        }
+        copy(node->left_m, out);
+        out += leftNodes + 1;
+        node = node->right_m;
+    }
+}
+
+// replaces the content of tree with the keys in [first, last), like Tree::assign, with the work split over threads.
+// the range must be random access and sorted in a strictly increasing order, otherwise the tree is left empty and
+// INVALID_INPUT is returned. without threads (or for keys that may throw) this is assign on the calling thread.
+template<class T, class Compare, class Aggregate, class Instrumentation, class Iterator>
+taskStatus assignParallel(Tree<T, Compare, Aggregate, Instrumentation>& tree, Iterator first, Iterator last, ThreadPool* threads){
+    if(threads == nullptr || !std::is_nothrow_constructible<T, decltype(*first)>::value){
+        return tree.assign(first, last);
+    }
+    tree.clear();
+    auto distance = last - first;
+    if(distance <= 0){
+        return taskStatus::SUCCESS;
+    }
+    int count = static_cast<int>(distance);
+    Node<T, Aggregate>* nodes = tree.allocateNodes(count);
+    if(nodes == nullptr){
+        return taskStatus::ALLOCATION_ERROR;
+    }
+    TreeParallelWalk<T, Compare, Aggregate, Instrumentation> walk(tree, threads);
+    tree.setRoot(walk.build(first, nodes, 0, count, nullptr));
+    if(!walk.isSorted()){
+        tree.clear();
+        return taskStatus::INVALID_INPUT;
+    }
+    return taskStatus::SUCCESS;
+}
+
+// writes all the keys of tree in order to out, which must have room for tree.getSize() keys.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus toArrayParallel(Tree<T, Compare, Aggregate, Instrumentation>& tree, T* out, ThreadPool* threads){
+    if(out == nullptr && tree.getSize() > 0){
+        return taskStatus::INVALID_INPUT;
+    }
+    if(!std::is_nothrow_copy_assignable<T>::value){
+        threads = nullptr;
+    }
+    TreeParallelWalk<T, Compare, Aggregate, Instrumentation> walk(tree, threads);
+    walk.copy(tree.getRoot(), out);
+    return taskStatus::SUCCESS;
+}
+
+#endif //AVL_PARALLEL_H
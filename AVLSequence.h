@@ -0,0 +1,192 @@
+
+/*
+this header file contains a sequence built on the AVL rank tree: a list where the order comes from the position of
+the values, not from operator<, like a std::vector that can insert and erase in the middle in O(logn).
+
+the nodes are the nodes of Tree, and NodesInSubtree_m gives the position of a node, the same way findKthElement
+and rank(Node*) use it. the keys are never compared, so T does not need operator<.
+like in Tree, a node never moves in memory, so a Node pointer can be saved and used later: indexOf gives its
+current position, and moveTo moves it to another position without copying the value.
+*/
+
+
+
+#ifndef AVL_SEQUENCE_H
+#define AVL_SEQUENCE_H
+
+#include "AVL.h"
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+template<class T, class Aggregate = NoAggregate<T>>
+class Sequence{
+    private:
+    // only the helpers of the tree that do not compare keys are used.
+    Tree<T, std::less<T>, Aggregate> tree_m;
+
+    taskStatus linkAt(Node<T, Aggregate>* node, int index);
+
+    public:
+    typedef typename Tree<T, std::less<T>, Aggregate>::iterator iterator;
+    typedef typename Tree<T, std::less<T>, Aggregate>::const_iterator const_iterator;
+    typedef typename Tree<T, std::less<T>, Aggregate>::reverse_iterator reverse_iterator;
+    typedef typename Tree<T, std::less<T>, Aggregate>::const_reverse_iterator const_reverse_iterator;
+
+    //basic methods
+    Sequence() = default;
+    template<class Iterator>
+    taskStatus assign(Iterator first, Iterator last); // complexity O(n)
+    void clear() {tree_m.clear();} // complexity O(n)
+    template<class... Args>
+    tupleOutput<Node<T, Aggregate>*> insertAt(int index, Args&&... args); // complexity O(logn)
+    template<class... Args>
+    tupleOutput<Node<T, Aggregate>*> pushBack(Args&&... args) {return insertAt(getSize(), std::forward<Args>(args)...);} // complexity O(logn)
+    template<class... Args>
+    tupleOutput<Node<T, Aggregate>*> pushFront(Args&&... args) {return insertAt(0, std::forward<Args>(args)...);} // complexity O(logn)
+    taskStatus eraseAt(int index); // complexity O(logn)
+    taskStatus erase(Node<T, Aggregate>* node) {return tree_m.erase(node);} // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> at(int index) {return tree_m.findKthElement(index);} // complexity O(logn)
+    int getSize() const {return tree_m.getSize();} // complexity O(1)
+
+    // advanced methods
+    tupleOutput<int> indexOf(Node<T, Aggregate>* node) {return tree_m.rank(node);} // complexity O(logn)
+    taskStatus moveTo(Node<T, Aggregate>* node, int index); // complexity O(logn)
+    taskStatus setAt(int index, T data); // complexity O(logn)
+    tupleOutput<typename Aggregate::value_type> aggregate(int first, int last) {return tree_m.aggregateRank(first, last);} // complexity O(logn)
+    iterator begin() const {return tree_m.begin();} // complexity O(logn)
+    iterator end() const {return tree_m.end();} // complexity O(1)
+    reverse_iterator rbegin() const {return tree_m.rbegin();} // complexity O(1)
+    reverse_iterator rend() const {return tree_m.rend();} // complexity O(logn)
+
+    // helper methods
+    Node<T, Aggregate>* getRoot() const {return tree_m.getRoot();}
+};
+
+/*
+    taskStatus assign(Iterator first, Iterator last); // complexity O(n)
+    void clear(); // complexity O(n)
+    tupleOutput<Node<T, Aggregate>*> insertAt(int index, Args&&... args); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> pushBack(Args&&... args); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> pushFront(Args&&... args); // complexity O(logn)
+    taskStatus eraseAt(int index); // complexity O(logn)
+    taskStatus erase(Node<T, Aggregate>* node); // complexity O(logn)
+    tupleOutput<Node<T, Aggregate>*> at(int index); // complexity O(logn)
+    int getSize() const; // complexity O(1)
+*/
+
+// builds a balanced tree of the values in the order they come, like Tree::assign but without checking any order.
+template<class T, class Aggregate>
+template<class Iterator>
+taskStatus Sequence<T, Aggregate>::assign(Iterator first, Iterator last){
+    clear();
+    std::vector<Node<T, Aggregate>*> nodes;
+    nodes.reserve(static_cast<size_t>(std::distance(first, last)));
+    for(; first != last; ++first){
+        Node<T, Aggregate>* node = tree_m.allocateNode(*first);
+        if(node == nullptr){
+            for(Node<T, Aggregate>* allocated : nodes){
+                tree_m.deallocateNode(allocated);
+            }
+            return taskStatus::ALLOCATION_ERROR;
+        }
+        nodes.push_back(node);
+    }
+    if(!nodes.empty()){
+        tree_m.createTreeFromSortedArray(nodes.data(), 0, static_cast<int>(nodes.size()) - 1);
+    }
+    return taskStatus::SUCCESS;
+}
+
+// the new value gets position index, and the values from index on move one position up.
+// index can be getSize(), to add the value at the end.
+template<class T, class Aggregate>
+template<class... Args>
+tupleOutput<Node<T, Aggregate>*> Sequence<T, Aggregate>::insertAt(int index, Args&&... args){
+    if(index < 0 || index > getSize()){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::INVALID_INPUT);
+    }
+    Node<T, Aggregate>* node = tree_m.allocateNode(std::forward<Args>(args)...);
+    if(node == nullptr){
+        return tupleOutput<Node<T, Aggregate>*>(taskStatus::ALLOCATION_ERROR);
+    }
+    linkAt(node, index);
+    return tupleOutput<Node<T, Aggregate>*>(node);
+}
+
+template<class T, class Aggregate>
+taskStatus Sequence<T, Aggregate>::eraseAt(int index){
+    tupleOutput<Node<T, Aggregate>*> node = at(index);
+    if(node.status() != taskStatus::SUCCESS){
+        return taskStatus::INVALID_INPUT;
+    }
+    return tree_m.erase(node.ans());
+}
+
+/*
+    tupleOutput<int> indexOf(Node<T, Aggregate>* node); // complexity O(logn)
+    taskStatus moveTo(Node<T, Aggregate>* node, int index); // complexity O(logn)
+    taskStatus setAt(int index, T data); // complexity O(logn)
+    tupleOutput<typename Aggregate::value_type> aggregate(int first, int last); // complexity O(logn)
+    iterator begin() const; // complexity O(logn)
+    iterator end() const; // complexity O(1)
+    reverse_iterator rbegin() const; // complexity O(1)
+    reverse_iterator rend() const; // complexity O(logn)
+*/
+
+// takes node out and puts it back so its position is index, the node keeps its address and its value.
+template<class T, class Aggregate>
+taskStatus Sequence<T, Aggregate>::moveTo(Node<T, Aggregate>* node, int index){
+    if(node == nullptr || index < 0 || index >= getSize()){
+        return taskStatus::INVALID_INPUT;
+    }
+    tree_m.unlinkNode(node);
+    return linkAt(node, index);
+}
+
+// replaces the value at index. the position does not depend on the value, so only the aggregates above it change.
+template<class T, class Aggregate>
+taskStatus Sequence<T, Aggregate>::setAt(int index, T data){
+    tupleOutput<Node<T, Aggregate>*> node = at(index);
+    if(node.status() != taskStatus::SUCCESS){
+        return taskStatus::INVALID_INPUT;
+    }
+    node.ans()->data_m = std::move(data);
+    for(Node<T, Aggregate>* current = node.ans(); current != nullptr; current = current->getParent()){
+        tree_m.updateNodesInSubTree(current);
+    }
+    return taskStatus::SUCCESS;
+}
+
+// hangs the single node node so that its position is index: as the left child of the node now at index,
+// or as the right child of the node just before it, whichever place is free. then the tree is fixed above it.
+template<class T, class Aggregate>
+taskStatus Sequence<T, Aggregate>::linkAt(Node<T, Aggregate>* node, int index){
+    Node<T, Aggregate>* root = tree_m.getRoot();
+    if(root == nullptr){
+        node->setParent(nullptr);
+        tree_m.setRoot(node);
+        return taskStatus::SUCCESS;
+    }
+    Node<T, Aggregate>* parent;
+    if(index == getSize()){
+        parent = tree_m.findMax(root);
+        parent->setRight(node);
+    }
+    else{
+        Node<T, Aggregate>* next = tree_m.findKthElement(index).ans();
+        if(next->getLeft() == nullptr){
+            parent = next;
+            parent->setLeft(node);
+        }
+        else{
+            parent = tree_m.findMax(next->getLeft());
+            parent->setRight(node);
+        }
+    }
+    node->setParent(parent);
+    return tree_m.retrace(parent);
+}
+
+#endif //AVL_SEQUENCE_H
@@ -0,0 +1,172 @@
+
+/*
+this header file contains union, intersection and difference of two AVL rank trees.
+
+the operations are the join based divide and conquer algorithms: the second tree is split by the key of the root
+of the first tree, the two halves are combined with the two subtrees of the root in parallel, and the results are
+joined back around the root. the work is O(mlog(n/m+1)) where m is the size of the smaller tree, and the two
+recursive calls are independent, so they run on the threads of a ThreadPool.
+the subtree sizes (NodesInSubtree_m) decide when a piece of work is too small to be worth a task.
+
+all the operations are destructive: the result is left in target, and source is left empty.
+the nodes of target that are in the result keep their addresses, so saved handles into target stay valid.
+nodes of source that are in the result also keep their addresses, other nodes of source are freed.
+*/
+
+
+
+#ifndef AVL_SET_OPERATIONS_H
+#define AVL_SET_OPERATIONS_H
+
+#include "AVL.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// interface
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus treeUnion(Tree<T, Compare, Aggregate, Instrumentation>& target, Tree<T, Compare, Aggregate, Instrumentation>& source, ThreadPool* threads = nullptr); // complexity O(mlog(n/m+1))
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus treeIntersection(Tree<T, Compare, Aggregate, Instrumentation>& target, Tree<T, Compare, Aggregate, Instrumentation>& source, ThreadPool* threads = nullptr); // complexity O(mlog(n/m+1))
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus treeDifference(Tree<T, Compare, Aggregate, Instrumentation>& target, Tree<T, Compare, Aggregate, Instrumentation>& source, ThreadPool* threads = nullptr); // complexity O(mlog(n/m+1))
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The following class holds the state of one set operation.
+// the recursion only relinks nodes, the nodes that are dropped from the result are pushed to a lock free stack
+// (linked through their parent pointers) and freed by the calling thread when the recursion is done,
+// so the node pool is never touched by two threads at once.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+class TreeSetOperation{
+    public:
+    enum struct kind {UNION, INTERSECTION, DIFFERENCE};
+
+    private:
+    Tree<T, Compare, Aggregate, Instrumentation>& target_m;
+    ThreadPool* threads_m;
+    kind kind_m;
+    std::atomic<Node<T, Aggregate>*> dropped_m;
+
+    static const int sequentialCutoff = 4096; // below this many nodes in both subtrees, we do not fork
+
+    void drop(Node<T, Aggregate>* subtree);
+    Node<T, Aggregate>* detach(Node<T, Aggregate>* node);
+    Node<T, Aggregate>* combine(Node<T, Aggregate>* first, Node<T, Aggregate>* second);
+
+    public:
+    TreeSetOperation(Tree<T, Compare, Aggregate, Instrumentation>& target, ThreadPool* threads, kind operation)
+        : target_m(target), threads_m(threads), kind_m(operation), dropped_m(nullptr){}
+    taskStatus run(Tree<T, Compare, Aggregate, Instrumentation>& source);
+};
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus TreeSetOperation<T, Compare, Aggregate, Instrumentation>::run(Tree<T, Compare, Aggregate, Instrumentation>& source){
+    if(&source == &target_m){
+        return taskStatus::INVALID_INPUT;
+    }
+    target_m.sharePoolWith(source);
+    Node<T, Aggregate>* first = target_m.getRoot();
+    Node<T, Aggregate>* second = source.getRoot();
+    // while the recursion runs the trees have no root, so the rotations inside the joins never touch root_m.
+    target_m.setRoot(nullptr);
+    source.setRoot(nullptr);
+    Node<T, Aggregate>* result = combine(first, second);
+    if(result != nullptr){
+        result->setParent(nullptr);
+    }
+    target_m.setRoot(result);
+    Node<T, Aggregate>* dropped = dropped_m.load();
+    while(dropped != nullptr){
+        Node<T, Aggregate>* next = dropped->getParent();
+        target_m.DestroyRecursive(dropped);
+        dropped = next;
+    }
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare, class Aggregate, class Instrumentation>
+void TreeSetOperation<T, Compare, Aggregate, Instrumentation>::drop(Node<T, Aggregate>* subtree){
+    if(subtree == nullptr){
+        return;
+    }
+    Node<T, Aggregate>* head = dropped_m.load(std::memory_order_relaxed);
+    do{
+        subtree->setParent(head);
+    } while(!dropped_m.compare_exchange_weak(head, subtree, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// cuts node off its children, so it can be dropped on its own.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* TreeSetOperation<T, Compare, Aggregate, Instrumentation>::detach(Node<T, Aggregate>* node){
+    node->setLeft(nullptr);
+    node->setRight(nullptr);
+    return node;
+}
+
+// combines the subtree first (of target) with the subtree second (of source) and returns the root of the result.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+Node<T, Aggregate>* TreeSetOperation<T, Compare, Aggregate, Instrumentation>::combine(Node<T, Aggregate>* first, Node<T, Aggregate>* second){
+    if(first == nullptr){
+        if(kind_m == kind::UNION){
+            return second;
+        }
+        drop(second);
+        return nullptr;
+    }
+    if(second == nullptr){
+        if(kind_m == kind::INTERSECTION){
+            drop(first);
+            return nullptr;
+        }
+        return first;
+    }
+    int work = first->getNodesInSubtree() + second->getNodesInSubtree();
+    Node<T, Aggregate>* firstLeft = first->getLeft();
+    Node<T, Aggregate>* firstRight = first->getRight();
+    Node<T, Aggregate>* secondLeft = nullptr;
+    Node<T, Aggregate>* secondRight = nullptr;
+    Node<T, Aggregate>* found = target_m.splitSubtree(second, first->data_m, secondLeft, secondRight);
+    Node<T, Aggregate>* left = nullptr;
+    Node<T, Aggregate>* right = nullptr;
+    if(threads_m != nullptr && work >= sequentialCutoff){
+        threads_m->parallelInvoke([&]{left = combine(firstLeft, secondLeft);},
+                                  [&]{right = combine(firstRight, secondRight);});
+    }
+    else{
+        left = combine(firstLeft, secondLeft);
+        right = combine(firstRight, secondRight);
+    }
+    // the key of first is in the result: always for union, only if found for intersection, only if not found for difference.
+    bool keep = kind_m == kind::UNION || ((found != nullptr) == (kind_m == kind::INTERSECTION));
+    drop(found);
+    if(keep){
+        return target_m.joinWithPivot(left, first, right);
+    }
+    drop(detach(first));
+    return target_m.joinSubtrees(left, right);
+}
+
+// leaves in target all the keys that are in target or in source.
+// for a key that is in both trees, the node of target is kept.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus treeUnion(Tree<T, Compare, Aggregate, Instrumentation>& target, Tree<T, Compare, Aggregate, Instrumentation>& source, ThreadPool* threads){
+    TreeSetOperation<T, Compare, Aggregate, Instrumentation> operation(target, threads, TreeSetOperation<T, Compare, Aggregate, Instrumentation>::kind::UNION);
+    return operation.run(source);
+}
+
+// leaves in target only the keys that are in both trees, the nodes of target are kept.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus treeIntersection(Tree<T, Compare, Aggregate, Instrumentation>& target, Tree<T, Compare, Aggregate, Instrumentation>& source, ThreadPool* threads){
+    TreeSetOperation<T, Compare, Aggregate, Instrumentation> operation(target, threads, TreeSetOperation<T, Compare, Aggregate, Instrumentation>::kind::INTERSECTION);
+    return operation.run(source);
+}
+
+// leaves in target only the keys that are not in source.
+template<class T, class Compare, class Aggregate, class Instrumentation>
+taskStatus treeDifference(Tree<T, Compare, Aggregate, Instrumentation>& target, Tree<T, Compare, Aggregate, Instrumentation>& source, ThreadPool* threads){
+    TreeSetOperation<T, Compare, Aggregate, Instrumentation> operation(target, threads, TreeSetOperation<T, Compare, Aggregate, Instrumentation>::kind::DIFFERENCE);
+    return operation.run(source);
+}
+
+#endif //AVL_SET_OPERATIONS_H
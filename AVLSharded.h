@@ -0,0 +1,612 @@
+/*
+this header file contains a sharded version of the AVL rank tree, for many threads that write at the same time.
+
+the keys are cut into ranges, and every range (shard) is a Tree of its own with its own lock, so writes to keys in
+different shards run in parallel. the sizes of the shards are kept in a small fenwick tree of atomic counters,
+so the global size, the global rank of a key and the kth key of the whole set are still O(logn):
+O(log(number of shards)) to find the shard and the offset in it, and O(logn) in the shard itself.
+
+the ranges adapt to the keys that come: a shard that grew past splitSize keys while there is room for more shards,
+or that took splitSize/4 writes since the ranges last changed (a hot shard), is cut at its median into two shards.
+when there are already maxShards shards, the two neighbouring shards that took the fewest writes are merged first
+to make room for the hot shard, if they are cold enough to be worth it.
+
+the ranges (the bounds, the shards and the fenwick tree) are a table that is never changed once it is published,
+so the operations read it with no lock, in the style of rcu: a change builds a new table with all the shards locked,
+publishes it, and frees the old one only when no thread that could still see it is left. a thread announces that it
+reads a table in one of readerSlots counters, picked by its thread id, so the threads do not all write the same cache
+line as they would with a shared lock. a thread that locks a shard checks that its table is still the published one,
+and looks again if it is not.
+cutting and merging shards are split and join of Tree, O(logn), and the nodes do not move. after a cut the new shard
+gets a pool of its own for the nodes it allocates (Tree::detachPool), so two shards never allocate from one pool on
+two threads at once. the pool of a shard keeps alive the pools its nodes came from, and after many cuts and merges
+that would be every pool the tree ever had, so a shard whose pool keeps more than poolLimit pools alive is copied
+once to a pool of its own, and the old pools are freed when no shard holds their nodes anymore. the copy runs after
+the new table is published, with only the lock of that shard held.
+the methods return copies of the keys and not Node pointers, since a node may change shards.
+
+with writers running, the global statistics are exact in the shard they land in, but the shards before it may have
+changed by a few keys in the meantime; with no writer running they are exact.
+*/
+
+
+
+#ifndef AVL_SHARDED_H
+#define AVL_SHARDED_H
+
+#include "AVL.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template<class T, class Compare = std::less<T>>
+class ShardedTree{
+    private:
+    struct Shard{
+        Tree<T, Compare> tree_m;
+        std::mutex mutex_m;
+        std::atomic<int> writes_m; // since the ranges last changed
+        explicit Shard(const Compare& compare) : tree_m(compare), writes_m(0){}
+    };
+    // a published table is never changed, only its counters are.
+    struct Ranges{
+        std::vector<T> bounds_m; // bounds_m[i] is the smallest key that may be in shard i+1
+        std::vector<Shard*> shards_m;
+        std::unique_ptr<std::atomic<int>[]> sizes_m; // a fenwick tree over the sizes of the shards, 1 based
+    };
+    // the number of threads that read a table. a new reader enters readers_m[epoch_m & 1].
+    struct alignas(64) ReaderSlot{
+        std::atomic<int> readers_m[2];
+    };
+    // holds the published table for as long as it lives, the table is not freed before.
+    class ReadSection{
+        private:
+        std::atomic<int>* readers_m;
+
+        public:
+        const Ranges* ranges_m;
+        explicit ReadSection(const ShardedTree& tree);
+        ReadSection(const ReadSection&) = delete;
+        ReadSection& operator=(const ReadSection&) = delete;
+        ~ReadSection() {readers_m->fetch_sub(1, std::memory_order_release);}
+    };
+
+    static const int readerSlots = 32;
+    static const int poolLimit = 8; // the pools the pool of a shard may keep alive, see compactPools
+
+    std::vector<std::unique_ptr<Shard>> shards_m; // owns the shards, changed only with adapt_m held
+    std::atomic<Ranges*> ranges_m; // the published table
+    mutable ReaderSlot slots_m[readerSlots];
+    std::atomic<unsigned> epoch_m;
+    std::mutex adapt_m; // one change of the ranges at a time
+    Compare compare_m;
+    int maxShards_m;
+    int splitSize_m;
+
+    static int readerSlot(); // complexity O(1)
+    int shardOf(const Ranges& ranges, const T& data) const; // complexity O(log(number of shards))
+    static void addSize(const Ranges& ranges, int shard, int delta); // complexity O(log(number of shards))
+    static int sizeBefore(const Ranges& ranges, int shard); // complexity O(log(number of shards))
+    static int findShard(const Ranges& ranges, int& k); // complexity O(log(number of shards))
+    template<class Function>
+    bool inShard(const Ranges& ranges, int shard, Function&& run) const; // complexity O(1) and run
+    Ranges* makeRanges(std::vector<T> bounds) const; // complexity O(number of shards)
+    void publish(std::vector<T> bounds); // complexity O(number of shards) and the wait for the readers
+    void waitForReaders(); // complexity O(readerSlots) and the wait
+    void lockAll(); // complexity O(number of shards)
+    void unlockAll(const Ranges& ranges); // complexity O(number of shards)
+    bool needsSplit(const Ranges& ranges, int shard) const; // complexity O(1)
+    void adaptRanges(const Shard* shard); // complexity O(logn + number of shards)
+    void splitShard(std::vector<T>& bounds, int shard); // complexity O(logn)
+    std::unique_ptr<Shard> mergeShards(std::vector<T>& bounds, int shard); // complexity O(logn)
+    void compactPools(int shard); // complexity O(number of pools), O(size of the shard) when it copies
+
+    public:
+    //basic methods
+    explicit ShardedTree(int maxShards = 4 * static_cast<int>(std::thread::hardware_concurrency()), int splitSize = 1 << 16,
+                         const Compare& compare = Compare());
+    ShardedTree(const ShardedTree&) = delete;
+    ShardedTree& operator=(const ShardedTree&) = delete;
+    ~ShardedTree(); // no other thread may use the tree by now
+    void clear(); // complexity O(n)
+    taskStatus insert(const T& data); // complexity O(logn)
+    taskStatus remove(const T& data); // complexity O(logn)
+    tupleOutput<T> find(const T& data) const; // complexity O(logn)
+    int getSize() const; // complexity O(log(number of shards))
+
+    // advanced methods
+    tupleOutput<T> findKthElement(int k) const; // complexity O(logn)
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn)
+    int countRange(const T& low, const T& high) const; // complexity O(logn)
+    int getShardCount() const; // complexity O(1)
+    int countPools() const; // complexity O(number of shards * poolLimit)
+};
+
+/*
+    ShardedTree(int maxShards, int splitSize, const Compare& compare = Compare()); // starts with a single shard
+    ~ShardedTree();
+    void clear(); // complexity O(n), keeps the ranges of the shards
+    taskStatus insert(const T& data); // complexity O(logn), may cut the shard of data, see adaptRanges
+    taskStatus remove(const T& data); // complexity O(logn)
+    tupleOutput<T> find(const T& data) const; // complexity O(logn), returns a copy of the key in the tree
+    int getSize() const; // complexity O(log(number of shards))
+*/
+
+template<class T, class Compare>
+ShardedTree<T, Compare>::ShardedTree(int maxShards, int splitSize, const Compare& compare)
+    : ranges_m(nullptr), epoch_m(0), compare_m(compare), maxShards_m(std::max(maxShards, 1)), splitSize_m(std::max(splitSize, 4)){
+    for(ReaderSlot& slot : slots_m){
+        slot.readers_m[0] = 0;
+        slot.readers_m[1] = 0;
+    }
+    shards_m.push_back(std::make_unique<Shard>(compare_m));
+    ranges_m = makeRanges(std::vector<T>());
+}
+
+template<class T, class Compare>
+ShardedTree<T, Compare>::~ShardedTree(){
+    delete ranges_m.load();
+}
+
+// the trees are cleared in place and a table with the sizes at 0 is published.
+template<class T, class Compare>
+void ShardedTree<T, Compare>::clear(){
+    std::lock_guard<std::mutex> adapt(adapt_m);
+    lockAll();
+    for(std::unique_ptr<Shard>& shard : shards_m){
+        shard->tree_m.clear();
+        shard->writes_m = 0;
+    }
+    publish(ranges_m.load()->bounds_m);
+}
+
+template<class T, class Compare>
+taskStatus ShardedTree<T, Compare>::insert(const T& data){
+    while(true){
+        bool split = false;
+        const Shard* current = nullptr;
+        taskStatus status = taskStatus::FAILURE;
+        {
+            ReadSection read(*this);
+            const Ranges& ranges = *read.ranges_m;
+            int shard = shardOf(ranges, data);
+            current = ranges.shards_m[shard];
+            bool published = inShard(ranges, shard, [&](Shard& locked){
+                status = locked.tree_m.insert(data).status();
+                if(status == taskStatus::SUCCESS){
+                    addSize(ranges, shard, 1);
+                    locked.writes_m.fetch_add(1, std::memory_order_relaxed);
+                }
+                split = needsSplit(ranges, shard);
+            });
+            if(!published){
+                continue;
+            }
+        }
+        if(split){
+            adaptRanges(current);
+        }
+        return status;
+    }
+}
+
+template<class T, class Compare>
+taskStatus ShardedTree<T, Compare>::remove(const T& data){
+    while(true){
+        bool split = false;
+        const Shard* current = nullptr;
+        taskStatus status = taskStatus::FAILURE;
+        {
+            ReadSection read(*this);
+            const Ranges& ranges = *read.ranges_m;
+            int shard = shardOf(ranges, data);
+            current = ranges.shards_m[shard];
+            bool published = inShard(ranges, shard, [&](Shard& locked){
+                status = locked.tree_m.remove(data);
+                if(status == taskStatus::SUCCESS){
+                    addSize(ranges, shard, -1);
+                    locked.writes_m.fetch_add(1, std::memory_order_relaxed);
+                }
+                split = needsSplit(ranges, shard);
+            });
+            if(!published){
+                continue;
+            }
+        }
+        if(split){
+            adaptRanges(current);
+        }
+        return status;
+    }
+}
+
+template<class T, class Compare>
+tupleOutput<T> ShardedTree<T, Compare>::find(const T& data) const{
+    while(true){
+        ReadSection read(*this);
+        tupleOutput<T> result(taskStatus::FAILURE);
+        bool published = inShard(*read.ranges_m, shardOf(*read.ranges_m, data), [&](Shard& locked){
+            tupleOutput<Node<T, NoAggregate<T>>*> found = locked.tree_m.find(data);
+            if(found.status() == taskStatus::SUCCESS){
+                result = tupleOutput<T>(found.ans()->getData());
+            }
+        });
+        if(published){
+            return result;
+        }
+    }
+}
+
+template<class T, class Compare>
+int ShardedTree<T, Compare>::getSize() const{
+    ReadSection read(*this);
+    return sizeBefore(*read.ranges_m, static_cast<int>(read.ranges_m->shards_m.size()));
+}
+
+/*
+    tupleOutput<T> findKthElement(int k) const; // complexity O(logn), k is 0 based over all the shards
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn), over all the shards
+    int countRange(const T& low, const T& high) const; // complexity O(logn)
+    int getShardCount() const; // complexity O(1)
+    int countPools() const; // complexity O(number of shards * poolLimit), the most pools a shard keeps alive
+*/
+
+// the fenwick tree gives the shard and the offset in it, the shard gives the key.
+// if the shard lost keys before we locked it, the offset is out of its range, and we look again.
+template<class T, class Compare>
+tupleOutput<T> ShardedTree<T, Compare>::findKthElement(int k) const{
+    if(k < 0){
+        return tupleOutput<T>(taskStatus::INVALID_INPUT);
+    }
+    while(true){
+        ReadSection read(*this);
+        const Ranges& ranges = *read.ranges_m;
+        int offset = k;
+        int shard = findShard(ranges, offset);
+        if(shard == static_cast<int>(ranges.shards_m.size())){
+            return tupleOutput<T>(taskStatus::INVALID_INPUT);
+        }
+        tupleOutput<T> result(taskStatus::FAILURE);
+        inShard(ranges, shard, [&](Shard& locked){
+            tupleOutput<Node<T, NoAggregate<T>>*> found = locked.tree_m.findKthElement(offset);
+            if(found.status() == taskStatus::SUCCESS){
+                result = tupleOutput<T>(found.ans()->getData());
+            }
+        });
+        if(result.status() == taskStatus::SUCCESS){
+            return result;
+        }
+    }
+}
+
+template<class T, class Compare>
+tupleOutput<int> ShardedTree<T, Compare>::rank(const T& data) const{
+    while(true){
+        ReadSection read(*this);
+        const Ranges& ranges = *read.ranges_m;
+        int shard = shardOf(ranges, data);
+        tupleOutput<int> result(taskStatus::FAILURE);
+        bool published = inShard(ranges, shard, [&](Shard& locked){
+            tupleOutput<int> inTree = locked.tree_m.rank(data);
+            if(inTree.status() == taskStatus::SUCCESS){
+                result = tupleOutput<int>(sizeBefore(ranges, shard) + inTree.ans());
+            }
+        });
+        if(published){
+            return result;
+        }
+    }
+}
+
+// the number of keys in [low, high), the shards between the shards of low and high are counted by the fenwick tree.
+template<class T, class Compare>
+int ShardedTree<T, Compare>::countRange(const T& low, const T& high) const{
+    if(!compare_m(low, high)){
+        return 0;
+    }
+    while(true){
+        ReadSection read(*this);
+        const Ranges& ranges = *read.ranges_m;
+        int lowShard = shardOf(ranges, low);
+        int highShard = shardOf(ranges, high);
+        int count = sizeBefore(ranges, highShard) - sizeBefore(ranges, lowShard);
+        int lowSmaller = 0;
+        int highSmaller = 0;
+        if(inShard(ranges, lowShard, [&](Shard& locked){lowSmaller = locked.tree_m.countSmaller(low);})
+           && inShard(ranges, highShard, [&](Shard& locked){highSmaller = locked.tree_m.countSmaller(high);})){
+            return count - lowSmaller + highSmaller;
+        }
+    }
+}
+
+template<class T, class Compare>
+int ShardedTree<T, Compare>::getShardCount() const{
+    ReadSection read(*this);
+    return static_cast<int>(read.ranges_m->shards_m.size());
+}
+
+// at most poolLimit with no change of the ranges running. a change copies the shards that went past it only after it
+// published the new table, so a count taken in the meantime may be above it.
+template<class T, class Compare>
+int ShardedTree<T, Compare>::countPools() const{
+    while(true){
+        ReadSection read(*this);
+        const Ranges& ranges = *read.ranges_m;
+        int most = 0;
+        bool published = true;
+        for(int shard = 0; published && shard < static_cast<int>(ranges.shards_m.size()); shard++){
+            published = inShard(ranges, shard, [&](Shard& locked){most = std::max(most, locked.tree_m.countPools());});
+        }
+        if(published){
+            return most;
+        }
+    }
+}
+
+
+//// helper methods ////
+/*
+    ReadSection(const ShardedTree& tree); // complexity O(1), the table of tree can not be freed while this lives
+    static int readerSlot(); // complexity O(1), the slot of the calling thread
+    int shardOf(const Ranges& ranges, const T& data) const; // complexity O(log(number of shards))
+    static void addSize(const Ranges& ranges, int shard, int delta); // complexity O(log(number of shards))
+    static int sizeBefore(const Ranges& ranges, int shard); // complexity O(log(number of shards)), the number of keys in shards [0, shard)
+    static int findShard(const Ranges& ranges, int& k); // complexity O(log(number of shards)), k becomes the offset in the shard
+    bool inShard(const Ranges& ranges, int shard, Function&& run) const; // complexity O(1) and run, false if ranges is not published
+    Ranges* makeRanges(std::vector<T> bounds) const; // complexity O(number of shards), with all the shards locked
+    void publish(std::vector<T> bounds); // complexity O(number of shards), with adapt_m and all the shards locked, unlocks them
+    void waitForReaders(); // complexity O(readerSlots) and the wait, until no thread reads an older table
+    void lockAll(); // complexity O(number of shards)
+    void unlockAll(const Ranges& ranges); // complexity O(number of shards)
+    bool needsSplit(const Ranges& ranges, int shard) const; // complexity O(1)
+    void adaptRanges(const Shard* shard); // complexity O(logn + number of shards)
+    void splitShard(std::vector<T>& bounds, int shard); // complexity O(logn)
+    std::unique_ptr<Shard> mergeShards(std::vector<T>& bounds, int shard); // complexity O(logn), merges shard and shard+1
+    void compactPools(int shard); // complexity O(number of pools), O(size of the shard) when it copies the keys, locks the shard
+*/
+
+// the counter is entered before the table is read, so a change that published a newer table after it sees the reader.
+template<class T, class Compare>
+ShardedTree<T, Compare>::ReadSection::ReadSection(const ShardedTree& tree){
+    unsigned epoch = tree.epoch_m.load();
+    readers_m = &tree.slots_m[readerSlot()].readers_m[epoch & 1];
+    readers_m->fetch_add(1);
+    ranges_m = tree.ranges_m.load();
+}
+
+template<class T, class Compare>
+int ShardedTree<T, Compare>::readerSlot(){
+    static thread_local const int slot = static_cast<int>(std::hash<std::thread::id>()(std::this_thread::get_id()) % readerSlots);
+    return slot;
+}
+
+template<class T, class Compare>
+int ShardedTree<T, Compare>::shardOf(const Ranges& ranges, const T& data) const{
+    return static_cast<int>(std::upper_bound(ranges.bounds_m.begin(), ranges.bounds_m.end(), data, compare_m) - ranges.bounds_m.begin());
+}
+
+template<class T, class Compare>
+void ShardedTree<T, Compare>::addSize(const Ranges& ranges, int shard, int delta){
+    int shards = static_cast<int>(ranges.shards_m.size());
+    for(int i = shard + 1; i <= shards; i += i & -i){
+        ranges.sizes_m[i].fetch_add(delta, std::memory_order_relaxed);
+    }
+}
+
+template<class T, class Compare>
+int ShardedTree<T, Compare>::sizeBefore(const Ranges& ranges, int shard){
+    int size = 0;
+    for(int i = shard; i > 0; i -= i & -i){
+        size += ranges.sizes_m[i].load(std::memory_order_relaxed);
+    }
+    return size;
+}
+
+// the usual fenwick descent: the largest prefix of shards with at most k keys.
+template<class T, class Compare>
+int ShardedTree<T, Compare>::findShard(const Ranges& ranges, int& k){
+    int shards = static_cast<int>(ranges.shards_m.size());
+    int step = 1;
+    while(step * 2 <= shards){
+        step *= 2;
+    }
+    int shard = 0;
+    for(; step > 0; step /= 2){
+        if(shard + step <= shards){
+            int size = ranges.sizes_m[shard + step].load(std::memory_order_relaxed);
+            if(size <= k){
+                shard += step;
+                k -= size;
+            }
+        }
+    }
+    return shard;
+}
+
+// runs run on the shard with its lock held. a change of the ranges holds all the locks while it publishes, so if
+// ranges is still the published table once we hold the lock, the shard still has the range it has in ranges.
+template<class T, class Compare>
+template<class Function>
+bool ShardedTree<T, Compare>::inShard(const Ranges& ranges, int shard, Function&& run) const{
+    Shard& current = *ranges.shards_m[shard];
+    std::lock_guard<std::mutex> lock(current.mutex_m);
+    if(ranges_m.load(std::memory_order_acquire) != &ranges){
+        return false;
+    }
+    run(current);
+    return true;
+}
+
+template<class T, class Compare>
+typename ShardedTree<T, Compare>::Ranges* ShardedTree<T, Compare>::makeRanges(std::vector<T> bounds) const{
+    Ranges* ranges = new Ranges;
+    ranges->bounds_m = std::move(bounds);
+    int shards = static_cast<int>(shards_m.size());
+    ranges->sizes_m.reset(new std::atomic<int>[shards + 1]);
+    for(int i = 0; i <= shards; i++){
+        ranges->sizes_m[i] = 0;
+    }
+    for(int shard = 0; shard < shards; shard++){
+        ranges->shards_m.push_back(shards_m[shard].get());
+    }
+    for(int shard = 0; shard < shards; shard++){
+        addSize(*ranges, shard, shards_m[shard]->tree_m.getSize());
+    }
+    return ranges;
+}
+
+// the locks are taken in the order of the shards, and the other threads hold at most one of them, so this can not deadlock.
+template<class T, class Compare>
+void ShardedTree<T, Compare>::publish(std::vector<T> bounds){
+    Ranges* old = ranges_m.load();
+    ranges_m.store(makeRanges(std::move(bounds)));
+    unlockAll(*old);
+    waitForReaders();
+    delete old;
+}
+
+// the two passes are the ones of srcu: a reader that read the epoch before the first flip but entered its counter
+// after we saw that counter at 0 is in the other counter, which the second pass waits for. a reader that entered
+// after we looked at its counter reads the new table, so it does not hold us up.
+template<class T, class Compare>
+void ShardedTree<T, Compare>::waitForReaders(){
+    for(int pass = 0; pass < 2; pass++){
+        unsigned old = epoch_m.fetch_add(1) & 1;
+        for(ReaderSlot& slot : slots_m){
+            while(slot.readers_m[old].load() != 0){
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+template<class T, class Compare>
+void ShardedTree<T, Compare>::lockAll(){
+    for(std::unique_ptr<Shard>& shard : shards_m){
+        shard->mutex_m.lock();
+    }
+}
+
+template<class T, class Compare>
+void ShardedTree<T, Compare>::unlockAll(const Ranges& ranges){
+    for(Shard* shard : ranges.shards_m){
+        shard->mutex_m.unlock();
+    }
+}
+
+// called with the shard locked, so its size is exact. a shard that is too small to cut is never hot.
+// the writes are counted again after every try, so a hot shard that can not be cut tries again only after splitSize/4 writes.
+template<class T, class Compare>
+bool ShardedTree<T, Compare>::needsSplit(const Ranges& ranges, int shard) const{
+    const Shard& current = *ranges.shards_m[shard];
+    int size = current.tree_m.getSize();
+    bool large = size >= splitSize_m && static_cast<int>(ranges.shards_m.size()) < maxShards_m;
+    return large || (size >= 4 && current.writes_m.load(std::memory_order_relaxed) >= splitSize_m / 4);
+}
+
+// runs with all the shards locked. another thread may have changed the ranges since we asked,
+// so the shard is found again and checked again. a merged shard is freed with the old table, once no thread reads it.
+template<class T, class Compare>
+void ShardedTree<T, Compare>::adaptRanges(const Shard* hot){
+    std::lock_guard<std::mutex> adapt(adapt_m);
+    const Ranges& ranges = *ranges_m.load();
+    int shard = static_cast<int>(std::find(ranges.shards_m.begin(), ranges.shards_m.end(), hot) - ranges.shards_m.begin());
+    if(shard == static_cast<int>(ranges.shards_m.size())){
+        return;
+    }
+    lockAll();
+    if(!needsSplit(ranges, shard)){
+        unlockAll(ranges);
+        return;
+    }
+    std::vector<T> bounds = ranges.bounds_m;
+    std::unique_ptr<Shard> merged;
+    int coldest = -1;
+    if(static_cast<int>(shards_m.size()) == maxShards_m){
+        // the two coldest neighbours make room, unless they are about as hot as the shard itself.
+        int coldestWrites = shards_m[shard]->writes_m / 2;
+        for(int i = 0; i + 1 < static_cast<int>(shards_m.size()); i++){
+            int writes = shards_m[i]->writes_m + shards_m[i + 1]->writes_m;
+            if(i != shard && i + 1 != shard && writes < coldestWrites){
+                coldest = i;
+                coldestWrites = writes;
+            }
+        }
+        if(coldest == -1){
+            for(std::unique_ptr<Shard>& current : shards_m){
+                current->writes_m = 0;
+            }
+            unlockAll(ranges);
+            return;
+        }
+        merged = mergeShards(bounds, coldest);
+        if(coldest < shard){
+            shard--;
+        }
+    }
+    splitShard(bounds, shard);
+    if(merged != nullptr && coldest > shard){
+        coldest++; // the new shard is right after shard
+    }
+    for(std::unique_ptr<Shard>& current : shards_m){
+        current->writes_m = 0;
+    }
+    publish(std::move(bounds));
+    // the copies of the pools come after the new table is out, each with the lock of its own shard only.
+    // adapt_m is still held, so shards_m does not change under them.
+    if(merged != nullptr){
+        compactPools(coldest);
+    }
+    compactPools(shard + 1);
+}
+
+// the upper half of the shard goes to a new shard right after it, by a split of its tree: no key is copied.
+// no other thread can see the new shard before the new table is published, so it is not locked.
+template<class T, class Compare>
+void ShardedTree<T, Compare>::splitShard(std::vector<T>& bounds, int shard){
+    Tree<T, Compare>& tree = shards_m[shard]->tree_m;
+    T median = tree.findKthElement(tree.getSize() / 2).ans()->getData();
+    std::unique_ptr<Shard> right = std::make_unique<Shard>(compare_m);
+    tree.split(median, right->tree_m);
+    right->tree_m.detachPool();
+    bounds.insert(bounds.begin() + shard, std::move(median));
+    shards_m.insert(shards_m.begin() + shard + 1, std::move(right));
+}
+
+// the keys of shard+1 are joined to shard, and the empty shard is handed back to be freed after the old table.
+// it is still locked, and it is unlocked with the other shards of the old table.
+template<class T, class Compare>
+std::unique_ptr<typename ShardedTree<T, Compare>::Shard> ShardedTree<T, Compare>::mergeShards(std::vector<T>& bounds, int shard){
+    shards_m[shard]->tree_m.join(shards_m[shard + 1]->tree_m);
+    std::unique_ptr<Shard> merged = std::move(shards_m[shard + 1]);
+    shards_m.erase(shards_m.begin() + shard + 1);
+    bounds.erase(bounds.begin() + shard);
+    return merged;
+}
+
+// a merge joins the pools of both shards, and a cut gives the new shard a pool that keeps the pool of the old one
+// alive, so each of them adds to the pools a shard keeps alive, and those pools are never freed. so when a shard keeps
+// more than poolLimit pools alive, its keys are copied to a new pool. runs with adapt_m held and the new table
+// published, and locks only the shard it copies, so the writes to the other shards go on meanwhile.
+template<class T, class Compare>
+void ShardedTree<T, Compare>::compactPools(int shard){
+    std::lock_guard<std::mutex> lock(shards_m[shard]->mutex_m);
+    Tree<T, Compare>& tree = shards_m[shard]->tree_m;
+    if(tree.countPools() <= poolLimit){
+        return;
+    }
+    std::vector<T> keys;
+    keys.reserve(tree.getSize());
+    tree.inOrder([&](const T& key){keys.push_back(key);});
+    // the nodes go back to the old pool, and the tree starts over in a pool that keeps nothing else alive.
+    tree.clear();
+    tree.detachPool();
+    tree.assign(keys.begin(), keys.end());
+}
+
+#endif //AVL_SHARDED_H
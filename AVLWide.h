@@ -0,0 +1,648 @@
+
+/*
+this header file contains a wide version of the rank tree, for keys that are plain numbers (int64, double...).
+
+a search in Tree reads one key per node, and for a big tree every node is a cache miss. here a node holds up to Width
+sorted keys (16 by default) in one array, and the search inside a node does not branch: it counts the keys that are
+smaller than the key it looks for, over the whole array, so the compiler turns it into a few SIMD compares.
+the unused places of the array hold the biggest value of T, which is never smaller than a key, so they add nothing.
+the loop has the same length for every node, build with -march=native (or -mavx2) to let it use the wide compares
+for 64 bit keys, for 32 bit keys and doubles plain x86-64 already has them.
+
+the tree is a B+ tree: all the keys are in the leaves, and an inner node keeps, for each child, the smallest key of
+the next child (as separators) and the number of keys under the child, for findKthElement and rank in O(logn).
+every node but the root is at least half full, and all the leaves are at the same depth.
+
+the keys move between the leaves when the leaves split and merge, so a key can not be handed out by its place.
+by default the tree has no handles: insert, find and findKthElement answer with a copy of the key, read from the leaf
+the search ended in, and a leaf holds nothing but its keys. with Handles (the third template argument) every key also
+gets its own WideEntry, allocated once when the key is inserted and never moved, and the leaves point to it: a
+WideEntry pointer is the handle of a key, like a Node pointer of Tree, and it is valid until the key is removed.
+the handles cost a pointer in the leaf and a WideEntry in a pool for every key, and reading the key through a handle
+is one more dependent load after the search, so take them only if something has to hold on to a key.
+
+the API is the one of Tree: insert, remove, find, findKthElement, rank and getSize, for the default order std::less.
+the answers are of handle_type, the key itself without handles and a WideEntry pointer with them.
+NaN is not a key, inserting it returns INVALID_INPUT.
+*/
+
+
+
+#ifndef AVL_WIDE_H
+#define AVL_WIDE_H
+
+#include "AVL.h"
+
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// helper classes
+// The following class is the handle of a key in a WideTree.
+template<class T>
+class WideEntry{
+    public:
+    T data_m;
+
+    explicit WideEntry(const T& data) : data_m(data){}
+    const T& getData() const {return data_m;}
+};
+
+// The following classes are the handles of the keys of a leaf, which a tree without handles has no room for.
+template<class T, int Width, bool Handles>
+struct WideLeafEntries{
+    WideEntry<T>* entries_m[Width];
+};
+
+template<class T, int Width>
+struct WideLeafEntries<T, Width, false>{
+};
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class T, int Width = 16, bool Handles = false>
+class WideTree{
+    static_assert(std::is_arithmetic<T>::value, "the keys of a wide tree are compared with simd, they must be numbers");
+    static_assert(Width >= 8 && Width <= 64, "a node holds between 8 and 64 keys");
+
+    public:
+    typedef typename std::conditional<Handles, WideEntry<T>*, T>::type handle_type; // what insert, find and findKthElement answer
+
+    private:
+    static constexpr int minFill = Width / 2; // every node but the root has at least this many keys or children
+
+    // the part of a node that a search reads first: the keys, and right after them their number.
+    struct Block{
+        T keys_m[Width];
+        int size_m; // the number of keys of a leaf, the number of children of an inner node
+    };
+    struct Leaf : Block, WideLeafEntries<T, Width, Handles>{
+    };
+    // keys_m[i] is the separator of children_m[i] and children_m[i + 1]: the keys of child i are smaller, and the
+    // keys of child i + 1 are not smaller. a node with c children has c - 1 separators.
+    struct Inner : Block{
+        Block* children_m[Width];
+        int counts_m[Width]; // the number of keys under every child
+    };
+    // what a node that split hands to its parent: the new node to its right, the separator, and the keys under it.
+    struct Split{
+        Block* block_m;
+        T key_m;
+        int count_m;
+    };
+
+    Block* root_m;
+    int height_m; // the number of levels of inner nodes, 0 if the root is a leaf
+    int size_m;
+    NodePool<Leaf> leaves_m;
+    NodePool<Inner> inners_m;
+    NodePool<WideEntry<T>> entries_m; // empty without handles
+
+    static constexpr T padding(); // the value of the unused places of the keys
+    static int countLess(const T* keys, const T& data); // complexity O(Width), no branches
+    static int countNotGreater(const T* keys, const T& data); // complexity O(Width), no branches
+    static int childIndex(const Inner* inner, const T& data); // complexity O(Width)
+    static handle_type handleOf(const Leaf* leaf, int index); // complexity O(1)
+    static void moveKey(Leaf* to, int toIndex, const Leaf* from, int fromIndex); // complexity O(1), the key and its handle
+    tupleOutput<handle_type> insertRecursive(Block* block, int level, const T& data, Split& split);
+    taskStatus removeRecursive(Block* block, int level, const T& data);
+    Leaf* newLeaf(); // complexity O(Width)
+    Inner* newInner(); // complexity O(Width)
+    void insertChild(Inner* inner, int index, const Split& split, Split& up); // complexity O(Width)
+    void removeChild(Inner* inner, int index); // complexity O(Width)
+    void fixChild(Inner* inner, int index, int level); // complexity O(Width)
+
+    public:
+    //basic methods
+    WideTree() : root_m(nullptr), height_m(0), size_m(0){}
+    WideTree(const WideTree&) = delete;
+    WideTree& operator=(const WideTree&) = delete;
+    ~WideTree() {clear();}
+    void clear(); // complexity O(number of chunks)
+    tupleOutput<handle_type> insert(const T& data); // complexity O(Width * log(n)/log(Width))
+    taskStatus remove(const T& data); // complexity O(Width * log(n)/log(Width))
+    tupleOutput<handle_type> find(const T& data) const; // complexity O(Width * log(n)/log(Width))
+    int getSize() const {return size_m;} // complexity O(1)
+
+    // advanced methods
+    tupleOutput<handle_type> findKthElement(int k) const; // complexity O(Width * log(n)/log(Width))
+    tupleOutput<int> rank(const T& data) const; // complexity O(Width * log(n)/log(Width))
+    int getHeight() const {return root_m == nullptr ? 0 : height_m + 1;} // complexity O(1), the number of levels of nodes
+    size_t memoryUsage() const; // complexity O(number of chunks)
+    double memoryPerNode() const; // complexity O(number of chunks), the bytes per key, to compare with Tree and CompactTree
+};
+
+/*
+    void clear(); // complexity O(number of chunks), the keys are numbers, so the pools are freed without a walk
+    tupleOutput<handle_type> insert(const T& data); // complexity O(Width * log(n)/log(Width)), FAILURE if data is already in the tree
+    taskStatus remove(const T& data); // complexity O(Width * log(n)/log(Width)), FAILURE if data is not in the tree
+    tupleOutput<handle_type> find(const T& data) const; // complexity O(Width * log(n)/log(Width))
+    int getSize() const; // complexity O(1)
+*/
+
+template<class T, int Width, bool Handles>
+void WideTree<T, Width, Handles>::clear(){
+    root_m = nullptr;
+    height_m = 0;
+    size_m = 0;
+    leaves_m.release();
+    inners_m.release();
+    entries_m.release();
+}
+
+// the nodes that a split needs are reserved before we go down, so once a key is placed nothing can fail on the way up.
+template<class T, int Width, bool Handles>
+tupleOutput<typename WideTree<T, Width, Handles>::handle_type> WideTree<T, Width, Handles>::insert(const T& data){
+    if(!(data == data)){
+        return tupleOutput<handle_type>(taskStatus::INVALID_INPUT);
+    }
+    if((Handles && !entries_m.reserve(1)) || !leaves_m.reserve(1) || !inners_m.reserve(height_m + 1)){
+        return tupleOutput<handle_type>(taskStatus::ALLOCATION_ERROR);
+    }
+    if(root_m == nullptr){
+        root_m = newLeaf();
+        height_m = 0;
+    }
+    Split split = {nullptr, T(), 0};
+    tupleOutput<handle_type> entry = insertRecursive(root_m, height_m, data, split);
+    if(entry.status() != taskStatus::SUCCESS){
+        return entry;
+    }
+    size_m++;
+    if(split.block_m != nullptr){
+        // the root split, the tree grows by a level.
+        Inner* root = newInner();
+        root->children_m[0] = root_m;
+        root->counts_m[0] = size_m - split.count_m;
+        root->size_m = 1;
+        Split none = {nullptr, T(), 0};
+        insertChild(root, 1, split, none);
+        root_m = root;
+        height_m++;
+    }
+    return entry;
+}
+
+template<class T, int Width, bool Handles>
+taskStatus WideTree<T, Width, Handles>::remove(const T& data){
+    if(root_m == nullptr){
+        return taskStatus::FAILURE;
+    }
+    taskStatus status = removeRecursive(root_m, height_m, data);
+    if(status != taskStatus::SUCCESS){
+        return status;
+    }
+    size_m--;
+    // a root with a single child gives its place to the child, and an empty tree has no root.
+    if(height_m > 0 && root_m->size_m == 1){
+        Inner* root = static_cast<Inner*>(root_m);
+        root_m = root->children_m[0];
+        height_m--;
+        inners_m.deallocate(root);
+    }
+    else if(height_m == 0 && root_m->size_m == 0){
+        leaves_m.deallocate(static_cast<Leaf*>(root_m));
+        root_m = nullptr;
+    }
+    return taskStatus::SUCCESS;
+}
+
+template<class T, int Width, bool Handles>
+tupleOutput<typename WideTree<T, Width, Handles>::handle_type> WideTree<T, Width, Handles>::find(const T& data) const{
+    const Block* block = root_m;
+    if(block == nullptr){
+        return tupleOutput<handle_type>(taskStatus::FAILURE);
+    }
+    for(int level = height_m; level > 0; level--){
+        const Inner* inner = static_cast<const Inner*>(block);
+        block = inner->children_m[childIndex(inner, data)];
+    }
+    const Leaf* leaf = static_cast<const Leaf*>(block);
+    int index = countLess(leaf->keys_m, data);
+    if(index == leaf->size_m || data < leaf->keys_m[index]){
+        return tupleOutput<handle_type>(taskStatus::FAILURE);
+    }
+    return tupleOutput<handle_type>(handleOf(leaf, index));
+}
+
+/*
+    tupleOutput<handle_type> findKthElement(int k) const; // complexity O(Width * log(n)/log(Width)), k is 0 based
+    tupleOutput<int> rank(const T& data) const; // complexity O(Width * log(n)/log(Width)), FAILURE if data is not in the tree
+    int getHeight() const; // complexity O(1)
+    size_t memoryUsage() const; // complexity O(number of chunks)
+    double memoryPerNode() const; // complexity O(number of chunks)
+*/
+
+template<class T, int Width, bool Handles>
+tupleOutput<typename WideTree<T, Width, Handles>::handle_type> WideTree<T, Width, Handles>::findKthElement(int k) const{
+    if(k < 0 || k >= size_m){
+        return tupleOutput<handle_type>(taskStatus::INVALID_INPUT);
+    }
+    const Block* block = root_m;
+    for(int level = height_m; level > 0; level--){
+        const Inner* inner = static_cast<const Inner*>(block);
+        int child = 0;
+        while(k >= inner->counts_m[child]){
+            k -= inner->counts_m[child];
+            child++;
+        }
+        block = inner->children_m[child];
+    }
+    return tupleOutput<handle_type>(handleOf(static_cast<const Leaf*>(block), k));
+}
+
+template<class T, int Width, bool Handles>
+tupleOutput<int> WideTree<T, Width, Handles>::rank(const T& data) const{
+    const Block* block = root_m;
+    if(block == nullptr){
+        return tupleOutput<int>(taskStatus::FAILURE);
+    }
+    int smaller = 0;
+    for(int level = height_m; level > 0; level--){
+        const Inner* inner = static_cast<const Inner*>(block);
+        int child = childIndex(inner, data);
+        for(int i = 0; i < child; i++){
+            smaller += inner->counts_m[i];
+        }
+        block = inner->children_m[child];
+    }
+    const Leaf* leaf = static_cast<const Leaf*>(block);
+    int index = countLess(leaf->keys_m, data);
+    if(index == leaf->size_m || data < leaf->keys_m[index]){
+        return tupleOutput<int>(taskStatus::FAILURE);
+    }
+    return tupleOutput<int>(smaller + index);
+}
+
+template<class T, int Width, bool Handles>
+size_t WideTree<T, Width, Handles>::memoryUsage() const{
+    return sizeof(*this) + leaves_m.getBytes() + inners_m.getBytes() + entries_m.getBytes();
+}
+
+template<class T, int Width, bool Handles>
+double WideTree<T, Width, Handles>::memoryPerNode() const{
+    if(size_m == 0){
+        return 0;
+    }
+    return static_cast<double>(memoryUsage()) / size_m;
+}
+
+
+//// helper methods ////
+/*
+    static constexpr T padding(); // the value of the unused places of the keys
+    static int countLess(const T* keys, const T& data); // complexity O(Width), no branches
+    static int countNotGreater(const T* keys, const T& data); // complexity O(Width), no branches
+    static int childIndex(const Inner* inner, const T& data); // complexity O(Width)
+    tupleOutput<handle_type> insertRecursive(Block* block, int level, const T& data, Split& split);
+    taskStatus removeRecursive(Block* block, int level, const T& data);
+    Leaf* newLeaf(); // complexity O(Width)
+    Inner* newInner(); // complexity O(Width)
+    void insertChild(Inner* inner, int index, const Split& split, Split& up); // complexity O(Width)
+    void removeChild(Inner* inner, int index); // complexity O(Width)
+    void fixChild(Inner* inner, int index, int level); // complexity O(Width)
+    static handle_type handleOf(const Leaf* leaf, int index); // complexity O(1), the key itself without handles
+    static void moveKey(Leaf* to, int toIndex, const Leaf* from, int fromIndex); // complexity O(1), the key and its handle
+*/
+
+template<class T, int Width, bool Handles>
+constexpr T WideTree<T, Width, Handles>::padding(){
+    if constexpr (std::numeric_limits<T>::has_infinity){
+        return std::numeric_limits<T>::infinity();
+    }
+    else{
+        return std::numeric_limits<T>::max();
+    }
+}
+
+template<class T, int Width, bool Handles>
+typename WideTree<T, Width, Handles>::handle_type WideTree<T, Width, Handles>::handleOf(const Leaf* leaf, int index){
+    if constexpr (Handles){
+        return leaf->entries_m[index];
+    }
+    else{
+        return leaf->keys_m[index];
+    }
+}
+
+template<class T, int Width, bool Handles>
+void WideTree<T, Width, Handles>::moveKey(Leaf* to, int toIndex, const Leaf* from, int fromIndex){
+    to->keys_m[toIndex] = from->keys_m[fromIndex];
+    if constexpr (Handles){
+        to->entries_m[toIndex] = from->entries_m[fromIndex];
+    }
+}
+
+// the padding is never smaller than a key, so the count is the number of keys in use that are smaller than data.
+template<class T, int Width, bool Handles>
+int WideTree<T, Width, Handles>::countLess(const T* keys, const T& data){
+    int count = 0;
+    for(int i = 0; i < Width; i++){
+        count += keys[i] < data;
+    }
+    return count;
+}
+
+template<class T, int Width, bool Handles>
+int WideTree<T, Width, Handles>::countNotGreater(const T* keys, const T& data){
+    int count = 0;
+    for(int i = 0; i < Width; i++){
+        count += keys[i] <= data;
+    }
+    return count;
+}
+
+// the child whose keys data belongs with: the number of separators that are not bigger than data.
+// the padding is not bigger than data only if data is the biggest value itself, then it is the last child anyway.
+template<class T, int Width, bool Handles>
+int WideTree<T, Width, Handles>::childIndex(const Inner* inner, const T& data){
+    int child = countNotGreater(inner->keys_m, data);
+    return child < inner->size_m - 1 ? child : inner->size_m - 1;
+}
+
+// places data in the subtree of block (level 0 is a leaf). if block had to split, split gets the new block on its right.
+template<class T, int Width, bool Handles>
+tupleOutput<typename WideTree<T, Width, Handles>::handle_type> WideTree<T, Width, Handles>::insertRecursive(Block* block, int level, const T& data, Split& split){
+    if(level == 0){
+        Leaf* leaf = static_cast<Leaf*>(block);
+        int index = countLess(leaf->keys_m, data);
+        if(index < leaf->size_m && !(data < leaf->keys_m[index])){
+            return tupleOutput<handle_type>(taskStatus::FAILURE);
+        }
+        Leaf* target = leaf;
+        if(leaf->size_m == Width){
+            // the right half moves to a new leaf, and data goes to the half it belongs to.
+            Leaf* right = newLeaf();
+            const int keep = Width / 2;
+            for(int i = keep; i < Width; i++){
+                moveKey(right, i - keep, leaf, i);
+                leaf->keys_m[i] = padding();
+            }
+            right->size_m = Width - keep;
+            leaf->size_m = keep;
+            if(index > keep){
+                target = right;
+                index -= keep;
+            }
+            split.block_m = right;
+        }
+        for(int i = target->size_m; i > index; i--){
+            moveKey(target, i, target, i - 1);
+        }
+        target->keys_m[index] = data;
+        if constexpr (Handles){
+            target->entries_m[index] = entries_m.allocate(data);
+        }
+        target->size_m++;
+        if(split.block_m != nullptr){
+            Leaf* right = static_cast<Leaf*>(split.block_m);
+            split.key_m = right->keys_m[0];
+            split.count_m = right->size_m;
+        }
+        return tupleOutput<handle_type>(handleOf(target, index));
+    }
+    Inner* inner = static_cast<Inner*>(block);
+    int child = childIndex(inner, data);
+    Split childSplit = {nullptr, T(), 0};
+    tupleOutput<handle_type> entry = insertRecursive(inner->children_m[child], level - 1, data, childSplit);
+    if(entry.status() != taskStatus::SUCCESS){
+        return entry;
+    }
+    inner->counts_m[child]++;
+    if(childSplit.block_m != nullptr){
+        inner->counts_m[child] -= childSplit.count_m;
+        insertChild(inner, child + 1, childSplit, split);
+    }
+    return entry;
+}
+
+// takes data out of the subtree of block. a child that is left less than half full is fixed by its parent.
+template<class T, int Width, bool Handles>
+taskStatus WideTree<T, Width, Handles>::removeRecursive(Block* block, int level, const T& data){
+    if(level == 0){
+        Leaf* leaf = static_cast<Leaf*>(block);
+        int index = countLess(leaf->keys_m, data);
+        if(index == leaf->size_m || data < leaf->keys_m[index]){
+            return taskStatus::FAILURE;
+        }
+        if constexpr (Handles){
+            entries_m.deallocate(leaf->entries_m[index]);
+        }
+        for(int i = index + 1; i < leaf->size_m; i++){
+            moveKey(leaf, i - 1, leaf, i);
+        }
+        leaf->size_m--;
+        leaf->keys_m[leaf->size_m] = padding();
+        return taskStatus::SUCCESS;
+    }
+    Inner* inner = static_cast<Inner*>(block);
+    int child = childIndex(inner, data);
+    taskStatus status = removeRecursive(inner->children_m[child], level - 1, data);
+    if(status != taskStatus::SUCCESS){
+        return status;
+    }
+    inner->counts_m[child]--;
+    if(inner->children_m[child]->size_m < minFill){
+        fixChild(inner, child, level - 1);
+    }
+    return taskStatus::SUCCESS;
+}
+
+// the pools were reserved by insert, so these allocations can not fail there.
+template<class T, int Width, bool Handles>
+typename WideTree<T, Width, Handles>::Leaf* WideTree<T, Width, Handles>::newLeaf(){
+    Leaf* leaf = leaves_m.allocate();
+    for(int i = 0; i < Width; i++){
+        leaf->keys_m[i] = padding();
+    }
+    leaf->size_m = 0;
+    return leaf;
+}
+
+template<class T, int Width, bool Handles>
+typename WideTree<T, Width, Handles>::Inner* WideTree<T, Width, Handles>::newInner(){
+    Inner* inner = inners_m.allocate();
+    for(int i = 0; i < Width; i++){
+        inner->keys_m[i] = padding();
+    }
+    inner->size_m = 0;
+    return inner;
+}
+
+// hangs split.block_m as child index of inner, with split.key_m as the separator on its left.
+// if inner is full it splits too, and up gets its new right half.
+template<class T, int Width, bool Handles>
+void WideTree<T, Width, Handles>::insertChild(Inner* inner, int index, const Split& split, Split& up){
+    // the children, the separators and the counts with the new child, Width + 1 children in the worst case.
+    Block* children[Width + 1];
+    T keys[Width];
+    int counts[Width + 1];
+    const int size = inner->size_m + 1;
+    for(int i = 0, from = 0; i < size; i++){
+        if(i == index){
+            children[i] = split.block_m;
+            counts[i] = split.count_m;
+            continue;
+        }
+        children[i] = inner->children_m[from];
+        counts[i] = inner->counts_m[from];
+        from++;
+    }
+    for(int i = 0, from = 0; i < size - 1; i++){
+        if(i == index - 1){
+            keys[i] = split.key_m;
+            continue;
+        }
+        keys[i] = inner->keys_m[from];
+        from++;
+    }
+    Inner* right = nullptr;
+    int keep = size;
+    if(size > Width){
+        right = newInner();
+        keep = size / 2;
+    }
+    // the separator between the halves goes up to the parent, it is not kept in either half.
+    for(int i = 0; i < keep - 1; i++){
+        inner->keys_m[i] = keys[i];
+    }
+    for(int i = keep - 1; i < Width; i++){
+        inner->keys_m[i] = padding();
+    }
+    for(int i = 0; i < keep; i++){
+        inner->children_m[i] = children[i];
+        inner->counts_m[i] = counts[i];
+    }
+    inner->size_m = keep;
+    if(right == nullptr){
+        return;
+    }
+    int count = 0;
+    for(int i = keep; i < size; i++){
+        right->children_m[i - keep] = children[i];
+        right->counts_m[i - keep] = counts[i];
+        count += counts[i];
+        if(i < size - 1){
+            right->keys_m[i - keep] = keys[i];
+        }
+    }
+    right->size_m = size - keep;
+    up.block_m = right;
+    up.key_m = keys[keep - 1];
+    up.count_m = count;
+}
+
+// takes child index out of inner, with the separator on its left.
+template<class T, int Width, bool Handles>
+void WideTree<T, Width, Handles>::removeChild(Inner* inner, int index){
+    for(int i = index; i < inner->size_m - 1; i++){
+        inner->children_m[i] = inner->children_m[i + 1];
+        inner->counts_m[i] = inner->counts_m[i + 1];
+    }
+    for(int i = index - 1; i < inner->size_m - 2; i++){
+        inner->keys_m[i] = inner->keys_m[i + 1];
+    }
+    inner->size_m--;
+    inner->keys_m[inner->size_m - 1] = padding();
+}
+
+// child index of inner (a node of level) is less than half full. it is merged with a neighbour if the two fit in
+// one node, otherwise the keys (or the children) of the two are shared evenly, and the separator between them is fixed.
+template<class T, int Width, bool Handles>
+void WideTree<T, Width, Handles>::fixChild(Inner* inner, int index, int level){
+    int leftIndex = index > 0 ? index - 1 : index;
+    Block* left = inner->children_m[leftIndex];
+    Block* right = inner->children_m[leftIndex + 1];
+    const int size = left->size_m + right->size_m;
+    if(level == 0){
+        Leaf* leftLeaf = static_cast<Leaf*>(left);
+        Leaf* rightLeaf = static_cast<Leaf*>(right);
+        // both leaves in one, in order, then shared out again.
+        Leaf both[2];
+        for(int i = 0; i < size; i++){
+            bool fromLeft = i < leftLeaf->size_m;
+            moveKey(&both[i / Width], i % Width, fromLeft ? leftLeaf : rightLeaf, fromLeft ? i : i - leftLeaf->size_m);
+        }
+        int keep = size <= Width ? size : size / 2;
+        for(int i = 0; i < Width; i++){
+            leftLeaf->keys_m[i] = padding();
+            rightLeaf->keys_m[i] = padding();
+        }
+        for(int i = 0; i < size; i++){
+            if(i < keep){
+                moveKey(leftLeaf, i, &both[i / Width], i % Width);
+            }
+            else{
+                moveKey(rightLeaf, i - keep, &both[i / Width], i % Width);
+            }
+        }
+        leftLeaf->size_m = keep;
+        rightLeaf->size_m = size - keep;
+        if(keep == size){
+            removeChild(inner, leftIndex + 1);
+            leaves_m.deallocate(rightLeaf);
+        }
+        else{
+            inner->keys_m[leftIndex] = rightLeaf->keys_m[0];
+        }
+        inner->counts_m[leftIndex] = keep;
+        if(keep < size){
+            inner->counts_m[leftIndex + 1] = size - keep;
+        }
+        return;
+    }
+    Inner* leftInner = static_cast<Inner*>(left);
+    Inner* rightInner = static_cast<Inner*>(right);
+    // the children of both, and between them the separator of inner, which now separates two children of one node.
+    Block* children[2 * Width];
+    int counts[2 * Width];
+    T keys[2 * Width];
+    for(int i = 0; i < size; i++){
+        bool fromLeft = i < leftInner->size_m;
+        int from = fromLeft ? i : i - leftInner->size_m;
+        children[i] = fromLeft ? leftInner->children_m[from] : rightInner->children_m[from];
+        counts[i] = fromLeft ? leftInner->counts_m[from] : rightInner->counts_m[from];
+    }
+    for(int i = 0; i < size - 1; i++){
+        if(i < leftInner->size_m - 1){
+            keys[i] = leftInner->keys_m[i];
+        }
+        else if(i == leftInner->size_m - 1){
+            keys[i] = inner->keys_m[leftIndex];
+        }
+        else{
+            keys[i] = rightInner->keys_m[i - leftInner->size_m];
+        }
+    }
+    int keep = size <= Width ? size : size / 2;
+    int leftCount = 0;
+    int rightCount = 0;
+    for(int i = 0; i < Width; i++){
+        leftInner->keys_m[i] = i < keep - 1 ? keys[i] : padding();
+        rightInner->keys_m[i] = i < size - keep - 1 ? keys[keep + i] : padding();
+    }
+    for(int i = 0; i < keep; i++){
+        leftInner->children_m[i] = children[i];
+        leftInner->counts_m[i] = counts[i];
+        leftCount += counts[i];
+    }
+    for(int i = keep; i < size; i++){
+        rightInner->children_m[i - keep] = children[i];
+        rightInner->counts_m[i - keep] = counts[i];
+        rightCount += counts[i];
+    }
+    leftInner->size_m = keep;
+    rightInner->size_m = size - keep;
+    inner->counts_m[leftIndex] = leftCount;
+    if(keep == size){
+        removeChild(inner, leftIndex + 1);
+        inners_m.deallocate(rightInner);
+    }
+    else{
+        // the separator between the halves goes up to inner.
+        inner->keys_m[leftIndex] = keys[keep - 1];
+        inner->counts_m[leftIndex + 1] = rightCount;
+    }
+}
+
+#endif //AVL_WIDE_H
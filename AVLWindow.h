@@ -0,0 +1,291 @@
+
+/*
+this header file contains a sliding window over a stream of samples, built on the AVL rank tree, for rolling
+medians and percentiles over the last N samples or the last T units of time.
+
+every sample gets a node of its own: the key of the node is the sample and its sequence number, so equal samples
+are still different keys. the nodes never move, so the window keeps them in a FIFO in the order they came, and
+evicting the oldest sample is erase of its node: no search. the node that was just freed is the first one the pool
+gives back, so a full window that takes a sample and drops one keeps working in the same memory. when many samples
+go at once (a batch, or a jump of the clock), their keys are sorted and erased with one eraseBatch.
+a quantile is findKthElement, and a set of quantiles is one selectMany, so the descents of the quantiles of one tick overlap.
+
+the window is bounded by a number of samples (capacity), by time (span), or both; 0 means no bound.
+the time is any integer clock the caller likes (ticks, nanoseconds...), it must not go back.
+a sample of time t is in the window of time now while now - span < t.
+*/
+
+
+
+#ifndef AVL_WINDOW_H
+#define AVL_WINDOW_H
+
+#include "AVL.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// helper classes
+// The following class is the key of a node of the window: the sample, and its place in the stream.
+template<class T>
+struct WindowSample{
+    T value_m;
+    std::uint64_t sequence_m;
+};
+
+// The following class orders the samples by their values, and equal values by the order they came in.
+template<class T, class Compare>
+class WindowCompare{
+    private:
+    Compare compare_m;
+
+    public:
+    explicit WindowCompare(const Compare& compare = Compare()) : compare_m(compare){}
+    bool operator()(const WindowSample<T>& first, const WindowSample<T>& second) const{
+        if(compare_m(first.value_m, second.value_m)){
+            return true;
+        }
+        if(compare_m(second.value_m, first.value_m)){
+            return false;
+        }
+        return first.sequence_m < second.sequence_m;
+    }
+};
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class T, class Compare = std::less<T>>
+class SlidingWindow{
+    public:
+    typedef Tree<WindowSample<T>, WindowCompare<T, Compare>> tree_type;
+    typedef Node<WindowSample<T>> node_type;
+
+    private:
+    struct Entry{
+        node_type* node_m;
+        std::int64_t time_m;
+    };
+
+    tree_type tree_m;
+    std::deque<Entry> fifo_m; // the samples in the window, the oldest first
+    int capacity_m;
+    std::int64_t span_m;
+    std::int64_t now_m;
+    std::uint64_t sequence_m; // the sequence number of the next sample
+    std::vector<WindowSample<T>> batch_m; // scratch space of push for a batch, kept to save the allocations
+    std::vector<node_type*> handles_m; // scratch space of push and quantiles
+    std::vector<int> ranks_m; // scratch space of quantiles
+
+    static int nearestRank(double q, int size); // the rank of the quantile q of size samples
+    void evictOldest(size_t count); // complexity O(logn) for one sample, O(mlog(n/m+1) + mlogm) for m samples
+    taskStatus advance(std::int64_t time); // complexity O(mlog(n/m+1) + mlogm) for m evicted samples
+
+    public:
+    //basic methods
+    explicit SlidingWindow(int capacity, std::int64_t span = 0, const Compare& compare = Compare());
+    void clear(); // complexity O(n)
+    taskStatus push(const T& value, std::int64_t time = 0); // complexity O(logn)
+    template<class Iterator>
+    taskStatus push(Iterator first, Iterator last, std::int64_t time = 0); // complexity O(mlog(n/m+1) + mlogm)
+    taskStatus expire(std::int64_t now) {return advance(now);} // complexity O(logn) per evicted sample
+    int getSize() const {return tree_m.getSize();} // complexity O(1)
+
+    // advanced methods
+    tupleOutput<T> quantile(double q); // complexity O(logn)
+    template<class Iterator>
+    taskStatus quantiles(Iterator first, Iterator last, T* values); // complexity O(mlogn)
+    tupleOutput<T> findKthElement(int k); // complexity O(logn)
+    const tree_type& getTree() const {return tree_m;}
+};
+
+/*
+    SlidingWindow(int capacity, std::int64_t span = 0, const Compare& compare = Compare()); // 0 is no bound
+    void clear(); // complexity O(n)
+    taskStatus push(const T& value, std::int64_t time = 0); // complexity O(logn), evicts what falls out of the window
+    taskStatus push(Iterator first, Iterator last, std::int64_t time = 0); // complexity O(mlog(n/m+1) + mlogm), all of them at time
+    taskStatus expire(std::int64_t now); // complexity O(logn) per evicted sample, moves the clock without a sample
+    int getSize() const; // complexity O(1)
+*/
+
+template<class T, class Compare>
+SlidingWindow<T, Compare>::SlidingWindow(int capacity, std::int64_t span, const Compare& compare)
+    : tree_m(WindowCompare<T, Compare>(compare)), capacity_m(std::max(capacity, 0)), span_m(std::max<std::int64_t>(span, 0)),
+      now_m(std::numeric_limits<std::int64_t>::min()), sequence_m(0){
+}
+
+template<class T, class Compare>
+void SlidingWindow<T, Compare>::clear(){
+    tree_m.clear();
+    fifo_m.clear();
+}
+
+// INVALID_INPUT if time is before the time of an earlier sample, the window does not change then.
+template<class T, class Compare>
+taskStatus SlidingWindow<T, Compare>::push(const T& value, std::int64_t time){
+    taskStatus status = advance(time);
+    if(status != taskStatus::SUCCESS){
+        return status;
+    }
+    if(capacity_m > 0 && getSize() == capacity_m){
+        evictOldest(1);
+    }
+    tupleOutput<node_type*> node = tree_m.insert(WindowSample<T>{value, sequence_m++});
+    if(node.status() != taskStatus::SUCCESS){
+        return node.status();
+    }
+    fifo_m.push_back(Entry{node.ans(), time});
+    return taskStatus::SUCCESS;
+}
+
+// pushes the samples in the order they come, all of them at time. the batch is sorted and added with insertBatch,
+// so the samples share the descents. the samples that the batch itself would push out of a full window are skipped.
+template<class T, class Compare>
+template<class Iterator>
+taskStatus SlidingWindow<T, Compare>::push(Iterator first, Iterator last, std::int64_t time){
+    taskStatus status = advance(time);
+    if(status != taskStatus::SUCCESS){
+        return status;
+    }
+    std::ptrdiff_t count = std::distance(first, last);
+    if(capacity_m > 0 && count > capacity_m){
+        std::advance(first, count - capacity_m);
+        count = capacity_m;
+    }
+    if(capacity_m > 0 && getSize() + count > capacity_m){
+        evictOldest(static_cast<size_t>(std::min<std::ptrdiff_t>(getSize() + count - capacity_m, getSize())));
+    }
+    const std::uint64_t base = sequence_m;
+    batch_m.clear();
+    for(; first != last; ++first){
+        batch_m.push_back(WindowSample<T>{*first, sequence_m++});
+    }
+    std::sort(batch_m.begin(), batch_m.end(), tree_m.getCompare());
+    handles_m.resize(batch_m.size());
+    status = tree_m.insertBatch(batch_m.begin(), batch_m.end(), handles_m.data());
+    if(status != taskStatus::SUCCESS){
+        return status;
+    }
+    // the handles come in the order of the values, the fifo wants them in the order of the sequence numbers.
+    size_t start = fifo_m.size();
+    fifo_m.resize(start + batch_m.size(), Entry{nullptr, time});
+    for(size_t i = 0; i < batch_m.size(); i++){
+        fifo_m[start + (batch_m[i].sequence_m - base)].node_m = handles_m[i];
+    }
+    return taskStatus::SUCCESS;
+}
+
+/*
+    tupleOutput<T> quantile(double q); // complexity O(logn), q in [0, 1]
+    taskStatus quantiles(Iterator first, Iterator last, T* values); // complexity O(mlogn), values[i] is the quantile first[i]
+    tupleOutput<T> findKthElement(int k); // complexity O(logn), the kth smallest sample in the window, k is 0 based
+    const tree_type& getTree() const; // the tree of the samples
+*/
+
+// the nearest rank quantile: the smallest sample that at least q of the samples are not bigger than.
+// quantile(0.5) of 4 samples is the second one, quantile(0) the smallest and quantile(1) the biggest.
+template<class T, class Compare>
+tupleOutput<T> SlidingWindow<T, Compare>::quantile(double q){
+    const int size = getSize();
+    if(size == 0 || !(q >= 0 && q <= 1)){
+        return tupleOutput<T>(taskStatus::INVALID_INPUT);
+    }
+    return findKthElement(nearestRank(q, size));
+}
+
+// INVALID_INPUT if the window is empty or one of the quantiles is not in [0, 1], values is not changed then.
+template<class T, class Compare>
+template<class Iterator>
+taskStatus SlidingWindow<T, Compare>::quantiles(Iterator first, Iterator last, T* values){
+    const int size = getSize();
+    if(size == 0){
+        return taskStatus::INVALID_INPUT;
+    }
+    ranks_m.clear();
+    for(; first != last; ++first){
+        double q = *first;
+        if(!(q >= 0 && q <= 1)){
+            return taskStatus::INVALID_INPUT;
+        }
+        ranks_m.push_back(nearestRank(q, size));
+    }
+    handles_m.resize(ranks_m.size());
+    tree_m.selectMany(ranks_m.begin(), ranks_m.end(), handles_m.data());
+    for(size_t i = 0; i < ranks_m.size(); i++){
+        values[i] = handles_m[i]->getData().value_m;
+    }
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare>
+tupleOutput<T> SlidingWindow<T, Compare>::findKthElement(int k){
+    tupleOutput<node_type*> node = tree_m.findKthElement(k);
+    if(node.status() != taskStatus::SUCCESS){
+        return tupleOutput<T>(node.status());
+    }
+    return tupleOutput<T>(node.ans()->getData().value_m);
+}
+
+
+//// helper methods ////
+/*
+    static int nearestRank(double q, int size); // complexity O(1), q in [0, 1] and size > 0
+    void evictOldest(size_t count); // complexity O(logn) for one sample, O(mlog(n/m+1) + mlogm) for m samples
+    taskStatus advance(std::int64_t time); // evicts the samples that are too old at time
+*/
+
+template<class T, class Compare>
+int SlidingWindow<T, Compare>::nearestRank(double q, int size){
+    int rank = static_cast<int>(std::ceil(q * size)) - 1;
+    return std::min(std::max(rank, 0), size - 1);
+}
+
+// a single sample is erased by its node, which is at hand, so there is nothing to search for. more samples are
+// erased by their keys, sorted, with one eraseBatch, so they share the descents and the rebalancing.
+template<class T, class Compare>
+void SlidingWindow<T, Compare>::evictOldest(size_t count){
+    if(count == 0){
+        return;
+    }
+    if(count == 1){
+        tree_m.erase(fifo_m.front().node_m);
+        fifo_m.pop_front();
+        return;
+    }
+    if(count == fifo_m.size()){
+        clear();
+        return;
+    }
+    batch_m.clear();
+    for(size_t i = 0; i < count; i++){
+        batch_m.push_back(fifo_m[i].node_m->getData());
+    }
+    std::sort(batch_m.begin(), batch_m.end(), tree_m.getCompare());
+    tree_m.eraseBatch(batch_m.begin(), batch_m.end());
+    fifo_m.erase(fifo_m.begin(), fifo_m.begin() + count);
+}
+
+template<class T, class Compare>
+taskStatus SlidingWindow<T, Compare>::advance(std::int64_t time){
+    if(time < now_m){
+        return taskStatus::INVALID_INPUT;
+    }
+    now_m = time;
+    if(span_m > 0){
+        // time - span_m may not fit in an int64_t, but time - time_m does fit in a uint64_t, since no sample is newer
+        // than time.
+        size_t expired = 0;
+        while(expired < fifo_m.size()
+              && static_cast<std::uint64_t>(time) - static_cast<std::uint64_t>(fifo_m[expired].time_m) >= static_cast<std::uint64_t>(span_m)){
+            expired++;
+        }
+        evictOldest(expired);
+    }
+    return taskStatus::SUCCESS;
+}
+
+#endif //AVL_WINDOW_H
@@ -0,0 +1,882 @@
+
+/*
+this header file contains a compact version of the AVL rank tree, for very many small keys.
+
+the nodes of Tree hold three pointers and two ints next to the key, for a small key that is most of the node.
+here the nodes live in arrays and point to each other by 32 bit indices, and the fields are split by who reads them:
+ - the key and the two children, everything a search reads, are in one array (4 nodes in a cache line for 8 byte keys).
+ - the parent and the number of nodes in the subtree, which only the updates and the ranks need, are in a second array.
+ - the height is a single byte in a third array.
+for 8 byte keys that is 25 bytes per node, a Node of Tree takes 40. see memoryPerNode.
+
+a node is named by its index. the index of a node never changes, not when the tree is rebalanced and not when the
+arrays grow, so an index can be saved and used later, like a Node pointer of Tree.
+index 0 (nil) is never a node, it stands for nullptr. it has height 0 and 0 nodes in its subtree, so the code can read
+the height and the count of a missing child without checking for it.
+
+the arrays grow in chunks of 16384 nodes, like the chunks of NodePool: a full chunk is never copied, so growing never
+needs the old and the new memory at once, and less than a chunk is unused. only the first chunk grows like a std::vector,
+so a small tree stays small. a tree holds at most INT_MAX nodes. T has to be default constructible and move assignable: the nil node holds a T(), and a freed
+slot gets a T() too, so it does not keep the memory of its old key (for trivially destructible keys it keeps the bytes).
+there are no aggregates, split or join here, use Tree for those.
+*/
+
+
+
+#ifndef COMPACT_AVL_H
+#define COMPACT_AVL_H
+
+#include "AVL.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The following class is an array that grows in chunks of a fixed size.
+// an element keeps its index, but not its address: the first chunk moves while it grows.
+template<class X>
+class ChunkedArray{
+    public:
+    static const int chunkShift = 14;
+    static const size_t chunkSize = static_cast<size_t>(1) << chunkShift;
+
+    private:
+    std::vector<std::vector<X>> chunks_m;
+    size_t size_m = 0;
+
+    public:
+    X& operator[](size_t index) {return chunks_m[index >> chunkShift][index & (chunkSize - 1)];} // complexity O(1)
+    const X& operator[](size_t index) const {return chunks_m[index >> chunkShift][index & (chunkSize - 1)];} // complexity O(1)
+    size_t size() const {return size_m;} // complexity O(1)
+    template<class Value>
+    void pushBack(Value&& value); // complexity O(1) amortized, throws std::bad_alloc
+    void reserve(size_t count); // complexity O(number of chunks), throws std::bad_alloc
+    void truncate(size_t count); // complexity O(size - count), only makes the array shorter
+    void clear(); // complexity O(number of chunks), frees all the chunks
+    size_t getBytes() const; // complexity O(number of chunks), including the unused capacity
+};
+
+/*
+    void pushBack(Value&& value); // complexity O(1) amortized, throws std::bad_alloc
+    void reserve(size_t count); // complexity O(number of chunks), throws std::bad_alloc
+    void truncate(size_t count); // complexity O(size - count), only makes the array shorter
+    void clear(); // complexity O(number of chunks), frees all the chunks
+    size_t getBytes() const; // complexity O(number of chunks), including the unused capacity
+*/
+
+// a new chunk gets its full size at once, only the first chunk doubles, and never beyond chunkSize.
+template<class X>
+template<class Value>
+void ChunkedArray<X>::pushBack(Value&& value){
+    size_t chunk = size_m >> chunkShift;
+    if(chunk == chunks_m.size()){
+        chunks_m.emplace_back();
+        try{
+            chunks_m.back().reserve(chunk == 0 ? 16 : chunkSize);
+        }
+        catch(...){
+            chunks_m.pop_back();
+            throw;
+        }
+    }
+    std::vector<X>& last = chunks_m[chunk];
+    if(last.size() == last.capacity()){
+        last.reserve(std::min(2 * last.capacity(), chunkSize));
+    }
+    last.push_back(std::forward<Value>(value));
+    size_m++;
+}
+
+template<class X>
+void ChunkedArray<X>::reserve(size_t count){
+    size_t chunks = (count + chunkSize - 1) >> chunkShift;
+    if(chunks == 0){
+        return;
+    }
+    chunks_m.reserve(chunks);
+    if(chunks_m.empty()){
+        chunks_m.emplace_back();
+    }
+    chunks_m[0].reserve(std::min(count, chunkSize));
+    while(chunks_m.size() < chunks){
+        chunks_m.emplace_back();
+        try{
+            chunks_m.back().reserve(chunkSize);
+        }
+        catch(...){
+            chunks_m.pop_back();
+            throw;
+        }
+    }
+}
+
+// the chunks that get empty keep their memory, for the next pushBack.
+template<class X>
+void ChunkedArray<X>::truncate(size_t count){
+    while(size_m > count){
+        size_m--;
+        chunks_m[size_m >> chunkShift].pop_back();
+    }
+}
+
+template<class X>
+void ChunkedArray<X>::clear(){
+    std::vector<std::vector<X>>().swap(chunks_m);
+    size_m = 0;
+}
+
+template<class X>
+size_t ChunkedArray<X>::getBytes() const{
+    size_t bytes = chunks_m.capacity() * sizeof(std::vector<X>);
+    for(const std::vector<X>& chunk : chunks_m){
+        bytes += chunk.capacity() * sizeof(X);
+    }
+    return bytes;
+}
+
+template<class T, class Compare = std::less<T>>
+class CompactTree{
+    static_assert(std::is_default_constructible<T>::value, "the nil node and the freed slots hold a T()");
+    static_assert(std::is_move_assignable<T>::value, "a slot is reused by moving a new key into it");
+
+    public:
+    typedef std::uint32_t index_type;
+    static constexpr index_type nil = 0; // stands for nullptr
+
+    private:
+    // everything a search reads.
+    struct HotNode{
+        T data_m;
+        index_type left_m;
+        index_type right_m;
+    };
+    // everything only the updates and the ranks read.
+    struct ColdNode{
+        index_type parent_m;
+        index_type nodesInSubtree_m;
+    };
+
+    ChunkedArray<HotNode> hot_m;
+    ChunkedArray<ColdNode> cold_m;
+    ChunkedArray<std::uint8_t> height_m; // a tree of 2^32 nodes is less than 47 high. freed nodes have height 0.
+    index_type root_m;
+    index_type freeList_m; // freed nodes, linked through left_m
+    int size_m;
+    Compare compare_m;
+
+    template<class Iterator>
+    index_type buildBalanced(Iterator& it, int count, index_type parent, index_type& prev, taskStatus& status);
+    template<class Data>
+    tupleOutput<index_type> insertData(Data&& data);
+
+    public:
+    //basic methods
+    explicit CompactTree(const Compare& compare = Compare());
+    template<class Iterator>
+    taskStatus assign(Iterator first, Iterator last); // complexity O(n), the range must be sorted
+    taskStatus reserve(int count); // complexity O(number of chunks)
+    void clear(); // complexity O(n)
+    tupleOutput<index_type> insert(const T& data); // complexity O(logn) amortized
+    tupleOutput<index_type> insert(T&& data); // complexity O(logn) amortized
+    taskStatus remove(const T& data); // complexity O(logn)
+    taskStatus erase(index_type node); // complexity O(logn)
+    tupleOutput<index_type> find(const T& data) const; // complexity O(logn)
+    const T& getData(index_type node) const {return hot_m[node].data_m;} // complexity O(1)
+
+    // advanced methods
+    index_type findMin() const; // complexity O(logn)
+    index_type findMax() const; // complexity O(logn)
+    index_type findSuccessor(index_type node) const; // complexity O(logn)
+    index_type findPredecessor(index_type node) const; // complexity O(logn)
+    tupleOutput<index_type> findKthElement(int k) const; // complexity O(logn)
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn)
+    tupleOutput<int> rankNode(index_type node) const; // complexity O(logn), rank(index_type) would be ambiguous for integer keys
+    tupleOutput<index_type> lowerBound(const T& data) const; // complexity O(logn)
+    tupleOutput<index_type> upperBound(const T& data) const; // complexity O(logn)
+    int countRange(const T& low, const T& high) const; // complexity O(logn)
+    size_t memoryUsage() const; // complexity O(1)
+    double memoryPerNode() const; // complexity O(1)
+
+    // helper methods
+    index_type getRoot() const {return root_m;}
+    int getSize() const {return size_m;}
+    index_type getLeft(index_type node) const {return hot_m[node].left_m;}
+    index_type getRight(index_type node) const {return hot_m[node].right_m;}
+    index_type getParent(index_type node) const {return cold_m[node].parent_m;}
+    int getHeight(index_type node) const {return height_m[node];}
+    int getNodesInSubtree(index_type node) const {return static_cast<int>(cold_m[node].nodesInSubtree_m);}
+    taskStatus RRrotation(index_type node); // complexity O(1)
+    taskStatus LLrotation(index_type node); // complexity O(1)
+    taskStatus RLrotation(index_type node); // complexity O(1)
+    taskStatus LRrotation(index_type node); // complexity O(1)
+    int getBalance(index_type node) const; // complexity O(1)
+    taskStatus updateNode(index_type node); // complexity O(1)
+    index_type rebalanceStep(index_type node); // complexity O(1)
+    taskStatus retrace(index_type node); // complexity O(logn)
+    taskStatus replaceChild(index_type parent, index_type child, index_type replacement); // complexity O(1)
+    taskStatus insertionPoint(const T& data, index_type& parent) const; // complexity O(logn)
+    taskStatus linkNode(index_type node, index_type parent); // complexity O(logn)
+    taskStatus unlinkNode(index_type node); // complexity O(logn)
+    template<class Data>
+    tupleOutput<index_type> allocateNode(Data&& data); // complexity O(1) amortized
+    void deallocateNode(index_type node); // complexity O(1)
+    int countSmaller(const T& data) const; // complexity O(logn)
+};
+
+/*
+CompactTree(const Compare& compare = Compare());
+    taskStatus assign(Iterator first, Iterator last); // complexity O(n), the range must be sorted
+    taskStatus reserve(int count); // complexity O(number of chunks)
+    void clear(); // complexity O(n)
+    tupleOutput<index_type> insert(const T& data); // complexity O(logn) amortized
+    tupleOutput<index_type> insert(T&& data); // complexity O(logn) amortized
+    taskStatus remove(const T& data); // complexity O(logn)
+    taskStatus erase(index_type node); // complexity O(logn)
+    tupleOutput<index_type> find(const T& data) const; // complexity O(logn)
+    const T& getData(index_type node) const; // complexity O(1)
+*/
+
+template<class T, class Compare>
+CompactTree<T, Compare>::CompactTree(const Compare& compare):root_m(nil), freeList_m(nil), size_m(0), compare_m(compare){
+    clear();
+}
+
+template<class T, class Compare>
+template<class Iterator>
+taskStatus CompactTree<T, Compare>::assign(Iterator first, Iterator last){
+    clear();
+    auto distance = std::distance(first, last);
+    if(distance <= 0){
+        return taskStatus::SUCCESS;
+    }
+    if(distance > std::numeric_limits<int>::max()){
+        return taskStatus::INVALID_INPUT;
+    }
+    int count = static_cast<int>(distance);
+    if(reserve(count) != taskStatus::SUCCESS){
+        return taskStatus::ALLOCATION_ERROR;
+    }
+    index_type prev = nil;
+    taskStatus status = taskStatus::SUCCESS;
+    root_m = buildBalanced(first, count, nil, prev, status);
+    if(status != taskStatus::SUCCESS){
+        clear();
+    }
+    return status;
+}
+
+template<class T, class Compare>
+template<class Iterator>
+typename CompactTree<T, Compare>::index_type CompactTree<T, Compare>::buildBalanced(Iterator& it, int count, index_type parent, index_type& prev, taskStatus& status){
+    if(count == 0){
+        return nil;
+    }
+    // the left subtree is built first, so the indices are in the order of the keys.
+    int leftCount = (count - 1) / 2;
+    index_type left = buildBalanced(it, leftCount, nil, prev, status);
+    // the arrays were reserved by assign, so this allocation can not fail.
+    index_type node = allocateNode(*it).ans();
+    ++it;
+    if(prev != nil && !compare_m(hot_m[prev].data_m, hot_m[node].data_m)){
+        status = taskStatus::INVALID_INPUT;
+    }
+    prev = node;
+    cold_m[node].parent_m = parent;
+    hot_m[node].left_m = left;
+    if(left != nil){
+        cold_m[left].parent_m = node;
+    }
+    hot_m[node].right_m = buildBalanced(it, count - 1 - leftCount, node, prev, status);
+    updateNode(node);
+    return node;
+}
+
+// makes room for count nodes in all, so filling the tree up to count nodes allocates nothing more.
+// count is an int, so it can not go over the limit of INT_MAX nodes, and the nil node fits next to them in an index_type.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::reserve(int count){
+    if(count < 0){
+        return taskStatus::INVALID_INPUT;
+    }
+    try{
+        hot_m.reserve(static_cast<size_t>(count) + 1);
+        cold_m.reserve(static_cast<size_t>(count) + 1);
+        height_m.reserve(static_cast<size_t>(count) + 1);
+    }
+    catch(const std::bad_alloc&){
+        return taskStatus::ALLOCATION_ERROR;
+    }
+    return taskStatus::SUCCESS;
+}
+
+// frees all the memory of the arrays, and puts back the nil node.
+template<class T, class Compare>
+void CompactTree<T, Compare>::clear(){
+    hot_m.clear();
+    cold_m.clear();
+    height_m.clear();
+    hot_m.pushBack(HotNode{T(), nil, nil});
+    cold_m.pushBack(ColdNode{nil, 0});
+    height_m.pushBack(0);
+    root_m = nil;
+    freeList_m = nil;
+    size_m = 0;
+}
+
+template<class T, class Compare>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::insert(const T& data){
+    return insertData(data);
+}
+
+template<class T, class Compare>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::insert(T&& data){
+    return insertData(std::move(data));
+}
+
+// we allocate only after the search, so a duplicate key costs no allocation.
+template<class T, class Compare>
+template<class Data>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::insertData(Data&& data){
+    index_type parent = nil;
+    if(insertionPoint(data, parent) != taskStatus::SUCCESS){
+        return tupleOutput<index_type>(taskStatus::FAILURE);
+    }
+    tupleOutput<index_type> node = allocateNode(std::forward<Data>(data));
+    if(node.status() != taskStatus::SUCCESS){
+        return node;
+    }
+    linkNode(node.ans(), parent);
+    return node;
+}
+
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::remove(const T& data){
+    tupleOutput<index_type> output = find(data);
+    if(output.status() != taskStatus::SUCCESS){
+        return output.status();
+    }
+    return erase(output.ans());
+}
+
+// a freed node has height 0, so an index that was already erased is reported as INVALID_INPUT.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::erase(index_type node){
+    if(node == nil || node >= hot_m.size() || height_m[node] == 0){
+        return taskStatus::INVALID_INPUT;
+    }
+    unlinkNode(node);
+    deallocateNode(node);
+    return taskStatus::SUCCESS;
+}
+
+// a single call to compare_m per node: we go all the way down and remember the last node that is not smaller
+// than data, it is the only node that can be equal to data.
+template<class T, class Compare>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::find(const T& data) const{
+    index_type current = root_m;
+    index_type bound = nil;
+    while(current != nil){
+        if(compare_m(hot_m[current].data_m, data)){
+            current = hot_m[current].right_m;
+        }
+        else{
+            bound = current;
+            current = hot_m[current].left_m;
+        }
+    }
+    if(bound == nil || compare_m(data, hot_m[bound].data_m)){
+        return tupleOutput<index_type>(taskStatus::FAILURE);
+    }
+    return tupleOutput<index_type>(bound);
+}
+
+/*
+    index_type findMin() const; // complexity O(logn)
+    index_type findMax() const; // complexity O(logn)
+    index_type findSuccessor(index_type node) const; // complexity O(logn)
+    index_type findPredecessor(index_type node) const; // complexity O(logn)
+    tupleOutput<index_type> findKthElement(int k) const; // complexity O(logn)
+    tupleOutput<int> rank(const T& data) const; // complexity O(logn)
+    tupleOutput<int> rankNode(index_type node) const; // complexity O(logn)
+    tupleOutput<index_type> lowerBound(const T& data) const; // complexity O(logn)
+    tupleOutput<index_type> upperBound(const T& data) const; // complexity O(logn)
+    int countRange(const T& low, const T& high) const; // complexity O(logn)
+    size_t memoryUsage() const; // complexity O(1)
+    double memoryPerNode() const; // complexity O(1)
+*/
+
+template<class T, class Compare>
+typename CompactTree<T, Compare>::index_type CompactTree<T, Compare>::findMin() const{
+    index_type node = root_m;
+    while(node != nil && hot_m[node].left_m != nil){
+        node = hot_m[node].left_m;
+    }
+    return node;
+}
+
+template<class T, class Compare>
+typename CompactTree<T, Compare>::index_type CompactTree<T, Compare>::findMax() const{
+    index_type node = root_m;
+    while(node != nil && hot_m[node].right_m != nil){
+        node = hot_m[node].right_m;
+    }
+    return node;
+}
+
+// nil if node is the last node.
+template<class T, class Compare>
+typename CompactTree<T, Compare>::index_type CompactTree<T, Compare>::findSuccessor(index_type node) const{
+    if(node == nil){
+        return nil;
+    }
+    if(hot_m[node].right_m != nil){
+        node = hot_m[node].right_m;
+        while(hot_m[node].left_m != nil){
+            node = hot_m[node].left_m;
+        }
+        return node;
+    }
+    index_type parent = cold_m[node].parent_m;
+    while(parent != nil && hot_m[parent].right_m == node){
+        node = parent;
+        parent = cold_m[node].parent_m;
+    }
+    return parent;
+}
+
+// nil if node is the first node.
+template<class T, class Compare>
+typename CompactTree<T, Compare>::index_type CompactTree<T, Compare>::findPredecessor(index_type node) const{
+    if(node == nil){
+        return nil;
+    }
+    if(hot_m[node].left_m != nil){
+        node = hot_m[node].left_m;
+        while(hot_m[node].right_m != nil){
+            node = hot_m[node].right_m;
+        }
+        return node;
+    }
+    index_type parent = cold_m[node].parent_m;
+    while(parent != nil && hot_m[parent].left_m == node){
+        node = parent;
+        parent = cold_m[node].parent_m;
+    }
+    return parent;
+}
+
+// k is 0 based, like Tree::findKthElement.
+template<class T, class Compare>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::findKthElement(int k) const{
+    if(k < 0 || k >= size_m){
+        return tupleOutput<index_type>(taskStatus::INVALID_INPUT);
+    }
+    index_type node = root_m;
+    while(node != nil){
+        int leftNodes = getNodesInSubtree(hot_m[node].left_m);
+        if(leftNodes == k){
+            return tupleOutput<index_type>(node);
+        }
+        if(leftNodes > k){
+            node = hot_m[node].left_m;
+        }
+        else{
+            k -= leftNodes + 1;
+            node = hot_m[node].right_m;
+        }
+    }
+    return tupleOutput<index_type>(taskStatus::FAILURE);
+}
+
+template<class T, class Compare>
+tupleOutput<int> CompactTree<T, Compare>::rank(const T& data) const{
+    index_type current = root_m;
+    int smaller = 0;
+    while(current != nil){
+        if(compare_m(data, hot_m[current].data_m)){
+            current = hot_m[current].left_m;
+        }
+        else if(compare_m(hot_m[current].data_m, data)){
+            // the node and all of its left subtree are smaller than data.
+            smaller += getNodesInSubtree(hot_m[current].left_m) + 1;
+            current = hot_m[current].right_m;
+        }
+        else{
+            return tupleOutput<int>(smaller + getNodesInSubtree(hot_m[current].left_m));
+        }
+    }
+    return tupleOutput<int>(taskStatus::FAILURE);
+}
+
+template<class T, class Compare>
+tupleOutput<int> CompactTree<T, Compare>::rankNode(index_type node) const{
+    if(node == nil || node >= hot_m.size() || height_m[node] == 0){
+        return tupleOutput<int>(taskStatus::INVALID_INPUT);
+    }
+    int smaller = getNodesInSubtree(hot_m[node].left_m);
+    for(index_type parent = cold_m[node].parent_m; parent != nil; node = parent, parent = cold_m[node].parent_m){
+        if(hot_m[parent].right_m == node){
+            smaller += getNodesInSubtree(hot_m[parent].left_m) + 1;
+        }
+    }
+    return tupleOutput<int>(smaller);
+}
+
+template<class T, class Compare>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::lowerBound(const T& data) const{
+    index_type current = root_m;
+    index_type bound = nil;
+    while(current != nil){
+        if(compare_m(hot_m[current].data_m, data)){
+            current = hot_m[current].right_m;
+        }
+        else{
+            bound = current;
+            current = hot_m[current].left_m;
+        }
+    }
+    if(bound == nil){
+        return tupleOutput<index_type>(taskStatus::FAILURE);
+    }
+    return tupleOutput<index_type>(bound);
+}
+
+template<class T, class Compare>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::upperBound(const T& data) const{
+    index_type current = root_m;
+    index_type bound = nil;
+    while(current != nil){
+        if(compare_m(data, hot_m[current].data_m)){
+            bound = current;
+            current = hot_m[current].left_m;
+        }
+        else{
+            current = hot_m[current].right_m;
+        }
+    }
+    if(bound == nil){
+        return tupleOutput<index_type>(taskStatus::FAILURE);
+    }
+    return tupleOutput<index_type>(bound);
+}
+
+// the number of keys in [low, high).
+template<class T, class Compare>
+int CompactTree<T, Compare>::countRange(const T& low, const T& high) const{
+    if(!compare_m(low, high)){
+        return 0;
+    }
+    return countSmaller(high) - countSmaller(low);
+}
+
+// the bytes held by the arrays, including the capacity that is not used yet and the freed nodes.
+template<class T, class Compare>
+size_t CompactTree<T, Compare>::memoryUsage() const{
+    return sizeof(*this) + hot_m.getBytes() + cold_m.getBytes() + height_m.getBytes();
+}
+
+template<class T, class Compare>
+double CompactTree<T, Compare>::memoryPerNode() const{
+    if(size_m == 0){
+        return 0;
+    }
+    return static_cast<double>(memoryUsage()) / size_m;
+}
+
+/*
+    taskStatus RRrotation(index_type node); // complexity O(1)
+    taskStatus LLrotation(index_type node); // complexity O(1)
+    taskStatus RLrotation(index_type node); // complexity O(1)
+    taskStatus LRrotation(index_type node); // complexity O(1)
+    int getBalance(index_type node) const; // complexity O(1)
+    taskStatus updateNode(index_type node); // complexity O(1)
+    index_type rebalanceStep(index_type node); // complexity O(1)
+    taskStatus retrace(index_type node); // complexity O(logn)
+    taskStatus replaceChild(index_type parent, index_type child, index_type replacement); // complexity O(1)
+    taskStatus insertionPoint(const T& data, index_type& parent) const; // complexity O(logn)
+    taskStatus linkNode(index_type node, index_type parent); // complexity O(logn)
+    taskStatus unlinkNode(index_type node); // complexity O(logn)
+    tupleOutput<index_type> allocateNode(Data&& data); // complexity O(1) amortized
+    void deallocateNode(index_type node); // complexity O(1)
+    int countSmaller(const T& data) const; // complexity O(logn)
+*/
+
+// the right child of node takes its place.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::RRrotation(index_type node){
+    index_type parent = cold_m[node].parent_m;
+    index_type right = hot_m[node].right_m;
+    index_type rightLeft = hot_m[right].left_m;
+    replaceChild(parent, node, right);
+    cold_m[right].parent_m = parent;
+    hot_m[right].left_m = node;
+    cold_m[node].parent_m = right;
+    hot_m[node].right_m = rightLeft;
+    if(rightLeft != nil){
+        cold_m[rightLeft].parent_m = node;
+    }
+    updateNode(node);
+    updateNode(right);
+    return taskStatus::SUCCESS;
+}
+
+// the left child of node takes its place.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::LLrotation(index_type node){
+    index_type parent = cold_m[node].parent_m;
+    index_type left = hot_m[node].left_m;
+    index_type leftRight = hot_m[left].right_m;
+    replaceChild(parent, node, left);
+    cold_m[left].parent_m = parent;
+    hot_m[left].right_m = node;
+    cold_m[node].parent_m = left;
+    hot_m[node].left_m = leftRight;
+    if(leftRight != nil){
+        cold_m[leftRight].parent_m = node;
+    }
+    updateNode(node);
+    updateNode(left);
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::RLrotation(index_type node){
+    LLrotation(hot_m[node].right_m);
+    return RRrotation(node);
+}
+
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::LRrotation(index_type node){
+    RRrotation(hot_m[node].left_m);
+    return LLrotation(node);
+}
+
+template<class T, class Compare>
+int CompactTree<T, Compare>::getBalance(index_type node) const{
+    return height_m[hot_m[node].left_m] - height_m[hot_m[node].right_m];
+}
+
+// the height and the count of node, from its children. nil has height 0 and count 0, so there are no checks here.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::updateNode(index_type node){
+    index_type left = hot_m[node].left_m;
+    index_type right = hot_m[node].right_m;
+    std::uint8_t leftHeight = height_m[left];
+    std::uint8_t rightHeight = height_m[right];
+    height_m[node] = static_cast<std::uint8_t>((leftHeight > rightHeight ? leftHeight : rightHeight) + 1);
+    cold_m[node].nodesInSubtree_m = cold_m[left].nodesInSubtree_m + cold_m[right].nodesInSubtree_m + 1;
+    return taskStatus::SUCCESS;
+}
+
+// fixes node, and returns the root of its subtree after the fix.
+template<class T, class Compare>
+typename CompactTree<T, Compare>::index_type CompactTree<T, Compare>::rebalanceStep(index_type node){
+    int balance = getBalance(node);
+    if(balance > 1){
+        if(getBalance(hot_m[node].left_m) >= 0){
+            LLrotation(node);
+        }
+        else{
+            LRrotation(node);
+        }
+        return cold_m[node].parent_m;
+    }
+    if(balance < -1){
+        if(getBalance(hot_m[node].right_m) <= 0){
+            RRrotation(node);
+        }
+        else{
+            RLrotation(node);
+        }
+        return cold_m[node].parent_m;
+    }
+    updateNode(node);
+    return node;
+}
+
+// the same single pass as Tree::retrace: once a height does not change, only the counts above are fixed.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::retrace(index_type node){
+    while(node != nil){
+        std::uint8_t oldHeight = height_m[node];
+        node = rebalanceStep(node);
+        index_type parent = cold_m[node].parent_m;
+        if(height_m[node] == oldHeight){
+            for(; parent != nil; parent = cold_m[parent].parent_m){
+                cold_m[parent].nodesInSubtree_m = cold_m[hot_m[parent].left_m].nodesInSubtree_m
+                    + cold_m[hot_m[parent].right_m].nodesInSubtree_m + 1;
+            }
+            return taskStatus::SUCCESS;
+        }
+        node = parent;
+    }
+    return taskStatus::SUCCESS;
+}
+
+// puts replacement where child was under parent, parent nil means child was the root.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::replaceChild(index_type parent, index_type child, index_type replacement){
+    if(parent == nil){
+        root_m = replacement;
+    }
+    else if(hot_m[parent].left_m == child){
+        hot_m[parent].left_m = replacement;
+    }
+    else{
+        hot_m[parent].right_m = replacement;
+    }
+    return taskStatus::SUCCESS;
+}
+
+// finds the node a new node with data will hang from (nil for an empty tree), FAILURE if data is already in the tree.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::insertionPoint(const T& data, index_type& parent) const{
+    index_type current = root_m;
+    index_type notGreater = nil; // the last node we passed to its right, the only node that can be equal to data
+    parent = nil;
+    while(current != nil){
+        parent = current;
+        if(compare_m(data, hot_m[current].data_m)){
+            current = hot_m[current].left_m;
+        }
+        else{
+            notGreater = current;
+            current = hot_m[current].right_m;
+        }
+    }
+    if(notGreater != nil && !compare_m(hot_m[notGreater].data_m, data)){
+        return taskStatus::FAILURE;
+    }
+    return taskStatus::SUCCESS;
+}
+
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::linkNode(index_type node, index_type parent){
+    cold_m[node].parent_m = parent;
+    if(parent == nil){
+        root_m = node;
+        return taskStatus::SUCCESS;
+    }
+    if(compare_m(hot_m[node].data_m, hot_m[parent].data_m)){
+        hot_m[parent].left_m = node;
+    }
+    else{
+        hot_m[parent].right_m = node;
+    }
+    return retrace(parent);
+}
+
+// the same as Tree::unlinkNode: a node with two children is replaced by its successor, by relinking.
+template<class T, class Compare>
+taskStatus CompactTree<T, Compare>::unlinkNode(index_type node){
+    index_type parent = cold_m[node].parent_m;
+    index_type left = hot_m[node].left_m;
+    index_type right = hot_m[node].right_m;
+    index_type replacement = nil;
+    index_type retraceFrom = parent;
+    if(left == nil || right == nil){
+        replacement = left == nil ? right : left;
+    }
+    else{
+        replacement = right;
+        while(hot_m[replacement].left_m != nil){
+            replacement = hot_m[replacement].left_m;
+        }
+        if(replacement == right){
+            retraceFrom = replacement;
+        }
+        else{
+            retraceFrom = cold_m[replacement].parent_m;
+            index_type replacementRight = hot_m[replacement].right_m;
+            hot_m[retraceFrom].left_m = replacementRight;
+            if(replacementRight != nil){
+                cold_m[replacementRight].parent_m = retraceFrom;
+            }
+            hot_m[replacement].right_m = right;
+            cold_m[right].parent_m = replacement;
+        }
+        hot_m[replacement].left_m = left;
+        cold_m[left].parent_m = replacement;
+        height_m[replacement] = height_m[node];
+    }
+    if(replacement != nil){
+        cold_m[replacement].parent_m = parent;
+    }
+    replaceChild(parent, node, replacement);
+    hot_m[node].left_m = nil;
+    hot_m[node].right_m = nil;
+    cold_m[node].parent_m = nil;
+    return retrace(retraceFrom);
+}
+
+// the new node is a leaf. a freed node is used again before the arrays grow.
+template<class T, class Compare>
+template<class Data>
+tupleOutput<typename CompactTree<T, Compare>::index_type> CompactTree<T, Compare>::allocateNode(Data&& data){
+    index_type node = freeList_m;
+    if(node != nil){
+        freeList_m = hot_m[node].left_m;
+        hot_m[node].data_m = std::forward<Data>(data);
+    }
+    else{
+        // size_m and the counts of the subtrees are ints.
+        if(size_m == std::numeric_limits<int>::max()){
+            return tupleOutput<index_type>(taskStatus::ALLOCATION_ERROR);
+        }
+        node = static_cast<index_type>(hot_m.size());
+        try{
+            hot_m.pushBack(HotNode{std::forward<Data>(data), nil, nil});
+            cold_m.pushBack(ColdNode{nil, 1});
+            height_m.pushBack(1);
+        }
+        catch(const std::bad_alloc&){
+            hot_m.truncate(node);
+            cold_m.truncate(node);
+            height_m.truncate(node);
+            return tupleOutput<index_type>(taskStatus::ALLOCATION_ERROR);
+        }
+    }
+    hot_m[node].left_m = nil;
+    hot_m[node].right_m = nil;
+    cold_m[node] = ColdNode{nil, 1};
+    height_m[node] = 1;
+    size_m++;
+    return tupleOutput<index_type>(node);
+}
+
+// the slot stays in the arrays and goes to the free list. the key is reset, so it does not hold memory of its own.
+template<class T, class Compare>
+void CompactTree<T, Compare>::deallocateNode(index_type node){
+    if constexpr (!std::is_trivially_destructible<T>::value){
+        hot_m[node].data_m = T();
+    }
+    hot_m[node].left_m = freeList_m;
+    height_m[node] = 0;
+    cold_m[node].nodesInSubtree_m = 0;
+    freeList_m = node;
+    size_m--;
+}
+
+template<class T, class Compare>
+int CompactTree<T, Compare>::countSmaller(const T& data) const{
+    index_type current = root_m;
+    int smaller = 0;
+    while(current != nil){
+        if(compare_m(hot_m[current].data_m, data)){
+            smaller += getNodesInSubtree(hot_m[current].left_m) + 1;
+            current = hot_m[current].right_m;
+        }
+        else{
+            current = hot_m[current].left_m;
+        }
+    }
+    return smaller;
+}
+
+#endif //COMPACT_AVL_H
@@ -0,0 +1,147 @@
+
+/*
+this header file contains a small fork join thread pool, used by the parallel operations on the AVL rank tree.
+
+the pool owns a fixed number of worker threads and a stack of pending tasks.
+a thread that waits for a task it forked does not sleep, it runs other pending tasks while it waits,
+so recursive divide and conquer code can fork as deep as it likes without running out of threads.
+*/
+
+
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class ThreadPool{
+    private:
+    std::vector<std::thread> workers_m;
+    std::vector<std::function<void()>> tasks_m; // used as a stack, the newest task is the hottest in the cache
+    std::mutex mutex_m;
+    std::condition_variable wakeUp_m;
+    bool stop_m = false;
+
+    void workerLoop();
+
+    public:
+    explicit ThreadPool(int threads = static_cast<int>(std::thread::hardware_concurrency()));
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool(); // waits for the workers, the pending tasks must be done by then
+
+    int getThreads() const {return static_cast<int>(workers_m.size()) + 1;} // the workers and the calling thread
+    void submit(std::function<void()> task); // complexity O(1)
+    bool runPendingTask(); // runs one pending task on the calling thread, returns false if there was none
+    template<class F1, class F2>
+    void parallelInvoke(F1&& first, F2&& second); // runs both and returns when both are done
+};
+
+// threads is the number of threads that work together, including the thread that calls parallelInvoke,
+// so ThreadPool(1) has no workers and runs everything on the calling thread.
+inline ThreadPool::ThreadPool(int threads){
+    for(int i = 1; i < threads; i++){
+        workers_m.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+inline ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_m);
+        stop_m = true;
+    }
+    wakeUp_m.notify_all();
+    for(std::thread& worker : workers_m){
+        worker.join();
+    }
+}
+
+inline void ThreadPool::submit(std::function<void()> task){
+    {
+        std::lock_guard<std::mutex> lock(mutex_m);
+        tasks_m.push_back(std::move(task));
+    }
+    wakeUp_m.notify_one();
+}
+
+inline bool ThreadPool::runPendingTask(){
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex_m);
+        if(tasks_m.empty()){
+            return false;
+        }
+        task = std::move(tasks_m.back());
+        tasks_m.pop_back();
+    }
+    task();
+    return true;
+}
+
+inline void ThreadPool::workerLoop(){
+    while(true){
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_m);
+            wakeUp_m.wait(lock, [this]{return stop_m || !tasks_m.empty();});
+            if(tasks_m.empty()){
+                return;
+            }
+            task = std::move(tasks_m.back());
+            tasks_m.pop_back();
+        }
+        task();
+    }
+}
+
+// second is offered to the other threads, and first is run on the calling thread.
+// if no worker took second by the time first is done, the calling thread usually runs it itself,
+// since it is the newest task on the stack.
+// an exception from either one comes out of parallelInvoke on the calling thread, but only after both are done,
+// since the task holds references into this frame (if both throw, the one of first comes out).
+template<class F1, class F2>
+void ThreadPool::parallelInvoke(F1&& first, F2&& second){
+    if(workers_m.empty()){
+        first();
+        second();
+        return;
+    }
+    std::atomic<bool> done(false);
+    std::exception_ptr secondError;
+    submit([&second, &done, &secondError]{
+        try{
+            second();
+        }
+        catch(...){
+            secondError = std::current_exception();
+        }
+        done.store(true, std::memory_order_release);
+    });
+    std::exception_ptr firstError;
+    try{
+        first();
+    }
+    catch(...){
+        firstError = std::current_exception();
+    }
+    while(!done.load(std::memory_order_acquire)){
+        if(!runPendingTask()){
+            std::this_thread::yield();
+        }
+    }
+    if(firstError){
+        std::rethrow_exception(firstError);
+    }
+    if(secondError){
+        std::rethrow_exception(secondError);
+    }
+}
+
+#endif //THREADPOOL_H
@@ -0,0 +1,492 @@
+
+/*
+this file is the benchmark suite of the tree: Tree against std::set and a sorted std::vector, on the same keys.
+
+for every payload (int: 8 byte keys, string: 20 character strings, large: 128 byte structs ordered by a 8 byte key),
+every distribution of the keys and every size from --min-size to --max-size (powers of 10), it times:
+    insert           inserting the keys one by one, in the order of the distribution
+    find             looking up keys that are in the container
+    findKthElement   looking up ranks (not for std::set, which has no rank)
+    traversal        going over all the keys in order, per key
+    remove           removing all the keys one by one
+    teardown         destroying a full container, per key
+the distributions are uniform (random order), sorted, reverse (sorted from the biggest), and zipf: the keys are drawn
+with a zipfian distribution (theta 0.99) over n keys in a random order, so some keys come again and again, and the
+lookups are drawn the same way.
+the sorted vector moves O(n) keys on every insert and remove, so above vectorUpdateLimit keys it is built once with
+a sort instead (the operation is then called build), and remove is skipped.
+every number is the best of --repeat runs, in nanoseconds per operation, written as one json line:
+    {"container": "Tree", "payload": "int", "distribution": "uniform", "size": 1000, "operation": "insert", "ns_per_op": 41.2}
+
+usage:
+    avl_bench [--min-size N] [--max-size N] [--repeat R] [--payload int|string|large] [--distribution uniform|sorted|reverse|zipf]
+              [--container Tree|std::set|sorted_vector] [--output path]
+    avl_bench --compare old.jsonl new.jsonl [threshold]
+the second form prints every result of new that is slower than the same result of old by more than threshold
+(0.10, ten percent, by default) and returns 1 if there is one, so it can gate an upgrade.
+the default sizes go up to 10^6; --max-size 100000000 runs the whole range, which needs tens of GB for the bigger payloads.
+*/
+
+#include "AVL.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static const int vectorUpdateLimit = 100000;
+static const int maxQueries = 1 << 20; // find and findKthElement are timed on at most this many lookups
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// payloads
+struct Large{
+    std::int64_t key_m;
+    char payload_m[120];
+};
+bool operator<(const Large& first, const Large& second) {return first.key_m < second.key_m;}
+
+// the keys of a payload are made from the numbers 0..n-1, in the same order.
+template<class T>
+T makeKey(std::uint64_t number);
+template<>
+std::int64_t makeKey<std::int64_t>(std::uint64_t number) {return static_cast<std::int64_t>(number);}
+template<>
+std::string makeKey<std::string>(std::uint64_t number){
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%020llu", static_cast<unsigned long long>(number));
+    return buffer;
+}
+template<>
+Large makeKey<Large>(std::uint64_t number){
+    Large large;
+    large.key_m = static_cast<std::int64_t>(number);
+    std::memset(large.payload_m, static_cast<int>(number & 0x7f), sizeof(large.payload_m));
+    return large;
+}
+
+// something to read from every key, so the compiler can not drop the walks.
+std::uint64_t touch(std::int64_t key) {return static_cast<std::uint64_t>(key);}
+std::uint64_t touch(const std::string& key) {return static_cast<unsigned char>(key.back());}
+std::uint64_t touch(const Large& key) {return static_cast<std::uint64_t>(key.key_m) + static_cast<unsigned char>(key.payload_m[7]);}
+
+template<class T> const char* payloadName();
+template<> const char* payloadName<std::int64_t>() {return "int";}
+template<> const char* payloadName<std::string>() {return "string";}
+template<> const char* payloadName<Large>() {return "large";}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// containers
+// the three containers behind the same calls. hasKth is false if the container can not find a rank.
+template<class T>
+class TreeContainer{
+    private:
+    Tree<T> tree_m;
+
+    public:
+    static const char* name() {return "Tree";}
+    static const bool hasKth = true;
+    static bool updatesByKey(int) {return true;}
+    void insert(const T& key) {tree_m.insert(key);}
+    bool find(const T& key) {return tree_m.find(key).status() == taskStatus::SUCCESS;}
+    std::uint64_t kth(int k) {return touch(tree_m.findKthElement(k).ans()->getData());}
+    void remove(const T& key) {tree_m.remove(key);}
+    std::uint64_t traverse(){
+        std::uint64_t sum = 0;
+        for(const T& key : tree_m){
+            sum += touch(key);
+        }
+        return sum;
+    }
+};
+
+template<class T>
+class SetContainer{
+    private:
+    std::set<T> set_m;
+
+    public:
+    static const char* name() {return "std::set";}
+    static const bool hasKth = false;
+    static bool updatesByKey(int) {return true;}
+    void insert(const T& key) {set_m.insert(key);}
+    bool find(const T& key) {return set_m.find(key) != set_m.end();}
+    std::uint64_t kth(int) {return 0;}
+    void remove(const T& key) {set_m.erase(key);}
+    std::uint64_t traverse(){
+        std::uint64_t sum = 0;
+        for(const T& key : set_m){
+            sum += touch(key);
+        }
+        return sum;
+    }
+};
+
+template<class T>
+class VectorContainer{
+    private:
+    std::vector<T> vector_m;
+
+    public:
+    static const char* name() {return "sorted_vector";}
+    static const bool hasKth = true;
+    static bool updatesByKey(int size) {return size <= vectorUpdateLimit;}
+    void insert(const T& key){
+        typename std::vector<T>::iterator place = std::lower_bound(vector_m.begin(), vector_m.end(), key);
+        if(place == vector_m.end() || key < *place){
+            vector_m.insert(place, key);
+        }
+    }
+    void build(const std::vector<T>& keys){
+        vector_m = keys;
+        std::sort(vector_m.begin(), vector_m.end());
+        vector_m.erase(std::unique(vector_m.begin(), vector_m.end(), [](const T& first, const T& second){
+            return !(first < second) && !(second < first);
+        }), vector_m.end());
+    }
+    bool find(const T& key) {return std::binary_search(vector_m.begin(), vector_m.end(), key);}
+    std::uint64_t kth(int k) {return touch(vector_m[k]);}
+    void remove(const T& key){
+        typename std::vector<T>::iterator place = std::lower_bound(vector_m.begin(), vector_m.end(), key);
+        if(place != vector_m.end() && !(key < *place)){
+            vector_m.erase(place);
+        }
+    }
+    std::uint64_t traverse(){
+        std::uint64_t sum = 0;
+        for(const T& key : vector_m){
+            sum += touch(key);
+        }
+        return sum;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// workloads
+// zipfian numbers in [0, n), 0 is the most popular, as in "quickly generating billion record synthetic databases" (gray et al).
+class Zipf{
+    private:
+    double n_m;
+    double theta_m;
+    double zetan_m;
+    double eta_m;
+
+    public:
+    Zipf(std::uint64_t n, double theta) : n_m(static_cast<double>(n)), theta_m(theta), zetan_m(0){
+        for(std::uint64_t i = 1; i <= n; i++){
+            zetan_m += 1 / std::pow(static_cast<double>(i), theta);
+        }
+        double zeta2 = 1 + 1 / std::pow(2.0, theta);
+        eta_m = (1 - std::pow(2 / n_m, 1 - theta)) / (1 - zeta2 / zetan_m);
+    }
+    template<class Random>
+    std::uint64_t operator()(Random& random){
+        double u = std::uniform_real_distribution<double>(0, 1)(random);
+        double uz = u * zetan_m;
+        if(uz < 1){
+            return 0;
+        }
+        if(uz < 1 + std::pow(0.5, theta_m)){
+            return 1;
+        }
+        double value = n_m * std::pow(eta_m * u - eta_m + 1, 1 / (1 - theta_m));
+        return std::min(static_cast<std::uint64_t>(value), static_cast<std::uint64_t>(n_m) - 1);
+    }
+};
+
+// the keys of one run, in the order every operation uses them.
+template<class T>
+struct Workload{
+    std::vector<T> inserts; // zipf has repeated keys here, the others have every key once
+    std::vector<T> removes; // every key that is in the container once
+    std::vector<T> queries;
+    std::vector<int> ranks;
+    int size = 0; // the number of different keys
+};
+
+template<class T>
+Workload<T> makeWorkload(const std::string& distribution, int n, std::mt19937_64& random){
+    Workload<T> workload;
+    std::vector<std::uint64_t> order(n);
+    for(int i = 0; i < n; i++){
+        order[i] = static_cast<std::uint64_t>(i);
+    }
+    if(distribution == "reverse"){
+        std::reverse(order.begin(), order.end());
+    }
+    else if(distribution != "sorted"){
+        std::shuffle(order.begin(), order.end(), random);
+    }
+    int queries = std::min(n, maxQueries);
+    if(distribution == "zipf"){
+        // order is the popularity: the key of rank r in the zipf distribution is order[r].
+        Zipf zipf(static_cast<std::uint64_t>(n), 0.99);
+        std::vector<char> seen(n, 0);
+        workload.inserts.reserve(n);
+        for(int i = 0; i < n; i++){
+            std::uint64_t number = order[zipf(random)];
+            workload.inserts.push_back(makeKey<T>(number));
+            if(!seen[number]){
+                seen[number] = 1;
+                workload.removes.push_back(workload.inserts.back());
+            }
+        }
+        workload.size = static_cast<int>(workload.removes.size());
+        for(int i = 0; i < queries; i++){
+            std::uint64_t number = order[zipf(random)];
+            workload.queries.push_back(makeKey<T>(number));
+        }
+        // the popular keys are spread over the ranks, so the ranks are uniform here.
+        for(int i = 0; i < queries; i++){
+            workload.ranks.push_back(static_cast<int>(random() % workload.size));
+        }
+        return workload;
+    }
+    workload.inserts.reserve(n);
+    for(std::uint64_t number : order){
+        workload.inserts.push_back(makeKey<T>(number));
+    }
+    workload.removes = workload.inserts;
+    workload.size = n;
+    for(int i = 0; i < queries; i++){
+        if(distribution == "uniform"){
+            workload.queries.push_back(makeKey<T>(random() % n));
+            workload.ranks.push_back(static_cast<int>(random() % n));
+        }
+        else{
+            // a scan in the order of the distribution.
+            workload.queries.push_back(workload.inserts[i]);
+            workload.ranks.push_back(distribution == "sorted" ? i : n - 1 - i);
+        }
+    }
+    return workload;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// runner
+struct Options{
+    int minSize = 1000;
+    int maxSize = 1000000;
+    int repeat = 3;
+    std::string payload;
+    std::string distribution;
+    std::string container;
+    std::FILE* output = stdout;
+};
+
+static std::uint64_t sink = 0; // everything the walks read ends here
+
+template<class Function>
+double nanoseconds(Function&& run){
+    auto start = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<class Container, class T>
+void runContainer(const Options& options, const Workload<T>& workload, const std::string& distribution, int n){
+    if(!options.container.empty() && options.container != Container::name()){
+        return;
+    }
+    std::map<std::string, double> best;
+    auto record = [&](const std::string& operation, double total, size_t count){
+        double perOperation = total / static_cast<double>(std::max<size_t>(count, 1));
+        if(best.find(operation) == best.end() || perOperation < best[operation]){
+            best[operation] = perOperation;
+        }
+    };
+    bool byKey = Container::updatesByKey(n);
+    for(int run = 0; run < options.repeat; run++){
+        {
+            Container container;
+            if(byKey){
+                record("insert", nanoseconds([&]{
+                    for(const T& key : workload.inserts){
+                        container.insert(key);
+                    }
+                }), workload.inserts.size());
+            }
+            else if constexpr (std::is_same<Container, VectorContainer<T>>::value){
+                record("build", nanoseconds([&]{container.build(workload.inserts);}), workload.inserts.size());
+            }
+            record("find", nanoseconds([&]{
+                for(const T& key : workload.queries){
+                    sink += container.find(key);
+                }
+            }), workload.queries.size());
+            if(Container::hasKth){
+                record("findKthElement", nanoseconds([&]{
+                    for(int k : workload.ranks){
+                        sink += container.kth(k);
+                    }
+                }), workload.ranks.size());
+            }
+            record("traversal", nanoseconds([&]{sink += container.traverse();}), static_cast<size_t>(workload.size));
+            if(byKey){
+                record("remove", nanoseconds([&]{
+                    for(const T& key : workload.removes){
+                        container.remove(key);
+                    }
+                }), workload.removes.size());
+            }
+        }
+        std::unique_ptr<Container> full(new Container());
+        if constexpr (std::is_same<Container, VectorContainer<T>>::value){
+            full->build(workload.inserts);
+        }
+        else{
+            for(const T& key : workload.inserts){
+                full->insert(key);
+            }
+        }
+        record("teardown", nanoseconds([&]{full.reset();}), static_cast<size_t>(workload.size));
+    }
+    for(const std::pair<const std::string, double>& result : best){
+        std::fprintf(options.output,
+                     "{\"container\": \"%s\", \"payload\": \"%s\", \"distribution\": \"%s\", \"size\": %d, \"operation\": \"%s\", \"ns_per_op\": %.2f}\n",
+                     Container::name(), payloadName<T>(), distribution.c_str(), n, result.first.c_str(), result.second);
+    }
+    std::fflush(options.output);
+}
+
+template<class T>
+void runPayload(const Options& options){
+    if(!options.payload.empty() && options.payload != payloadName<T>()){
+        return;
+    }
+    const char* distributions[] = {"uniform", "sorted", "reverse", "zipf"};
+    for(int d = 0; d < 4; d++){
+        const char* distribution = distributions[d];
+        if(!options.distribution.empty() && options.distribution != distribution){
+            continue;
+        }
+        for(long long n = options.minSize; n <= options.maxSize; n *= 10){
+            // the seed depends only on the run, so a run gets the same keys whatever else is run with it.
+            std::mt19937_64 random(static_cast<std::uint64_t>(n) * 4 + static_cast<std::uint64_t>(d));
+            Workload<T> workload = makeWorkload<T>(distribution, static_cast<int>(n), random);
+            runContainer<TreeContainer<T>>(options, workload, distribution, static_cast<int>(n));
+            runContainer<SetContainer<T>>(options, workload, distribution, static_cast<int>(n));
+            runContainer<VectorContainer<T>>(options, workload, distribution, static_cast<int>(n));
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//// comparing two result files
+// the value of a field in one of our own json lines, the lines are simple enough to not need a json parser.
+std::string field(const std::string& line, const std::string& name){
+    std::string key = "\"" + name + "\": ";
+    size_t start = line.find(key);
+    if(start == std::string::npos){
+        return "";
+    }
+    start += key.size();
+    if(line[start] == '"'){
+        return line.substr(start + 1, line.find('"', start + 1) - start - 1);
+    }
+    return line.substr(start, line.find_first_of(",}", start) - start);
+}
+
+bool readResults(const char* path, std::map<std::string, double>& results){
+    std::FILE* file = std::fopen(path, "r");
+    if(file == nullptr){
+        std::fprintf(stderr, "can not read %s\n", path);
+        return false;
+    }
+    char buffer[1024];
+    while(std::fgets(buffer, sizeof(buffer), file) != nullptr){
+        std::string line(buffer);
+        std::string value = field(line, "ns_per_op");
+        if(value.empty()){
+            continue;
+        }
+        std::string key = field(line, "container") + " " + field(line, "payload") + " " + field(line, "distribution") + " "
+                          + field(line, "size") + " " + field(line, "operation");
+        results[key] = std::atof(value.c_str());
+    }
+    std::fclose(file);
+    return true;
+}
+
+int compare(const char* oldPath, const char* newPath, double threshold){
+    std::map<std::string, double> before;
+    std::map<std::string, double> after;
+    if(!readResults(oldPath, before) || !readResults(newPath, after)){
+        return 2;
+    }
+    int regressions = 0;
+    int compared = 0;
+    for(const std::pair<const std::string, double>& result : after){
+        std::map<std::string, double>::const_iterator old = before.find(result.first);
+        if(old == before.end() || old->second <= 0){
+            continue;
+        }
+        compared++;
+        double change = result.second / old->second - 1;
+        if(change > threshold){
+            std::printf("regression: %s %.2f -> %.2f ns (+%.1f%%)\n", result.first.c_str(), old->second, result.second, 100 * change);
+            regressions++;
+        }
+    }
+    std::printf("%d results compared, %d regressions above %.1f%%\n", compared, regressions, 100 * threshold);
+    return regressions == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+    if(argc >= 4 && std::strcmp(argv[1], "--compare") == 0){
+        return compare(argv[2], argv[3], argc >= 5 ? std::atof(argv[4]) : 0.10);
+    }
+    Options options;
+    for(int i = 1; i + 1 < argc; i += 2){
+        std::string name = argv[i];
+        const char* value = argv[i + 1];
+        if(name == "--min-size"){
+            options.minSize = std::max(1, std::atoi(value));
+        }
+        else if(name == "--max-size"){
+            options.maxSize = std::atoi(value);
+        }
+        else if(name == "--repeat"){
+            options.repeat = std::max(1, std::atoi(value));
+        }
+        else if(name == "--payload"){
+            options.payload = value;
+        }
+        else if(name == "--distribution"){
+            options.distribution = value;
+        }
+        else if(name == "--container"){
+            options.container = value;
+        }
+        else if(name == "--output"){
+            options.output = std::fopen(value, "w");
+            if(options.output == nullptr){
+                std::fprintf(stderr, "can not write %s\n", value);
+                return 2;
+            }
+        }
+        else{
+            std::fprintf(stderr, "unknown option %s, see the comment at the top of avl_bench.cpp\n", name.c_str());
+            return 2;
+        }
+    }
+    runPayload<std::int64_t>(options);
+    runPayload<std::string>(options);
+    runPayload<Large>(options);
+    if(sink == 42){
+        std::fprintf(stderr, "\n");
+    }
+    if(options.output != stdout){
+        std::fclose(options.output);
+    }
+    return 0;
+}
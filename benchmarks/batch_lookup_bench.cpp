@@ -0,0 +1,87 @@
+
+/*
+this file compares find and findKthElement one key at a time with findMany and selectMany, on trees from well inside
+the cache to far bigger than it. the lookups come in batches of 256, like a request handler would have them.
+
+build: g++ -O2 -std=c++17 -I.. batch_lookup_bench.cpp -o batch_lookup_bench
+*/
+
+#include "AVL.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static const int batch = 256;
+static const int lookups = 1 << 21;
+
+template<class Function>
+double nanosecondsPerLookup(Function&& run){
+    auto start = std::chrono::steady_clock::now();
+    std::uintptr_t sum = run();
+    auto end = std::chrono::steady_clock::now();
+    if(sum == 0){
+        std::printf("# nothing was found\n");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / lookups;
+}
+
+int main(){
+    std::mt19937_64 random(19);
+    for(int size : {10000, 1000000, 10000000}){
+        std::vector<std::uint64_t> keys(size);
+        for(int i = 0; i < size; i++){
+            keys[i] = static_cast<std::uint64_t>(i) * 2;
+        }
+        std::shuffle(keys.begin(), keys.end(), random);
+        // inserted in random order, so the nodes are spread over the memory like in a long lived tree.
+        Tree<std::uint64_t> tree;
+        for(std::uint64_t key : keys){
+            tree.insert(key);
+        }
+        std::vector<std::uint64_t> queries(lookups);
+        std::vector<int> ranks(lookups);
+        for(int i = 0; i < lookups; i++){
+            queries[i] = keys[random() % size];
+            ranks[i] = static_cast<int>(random() % size);
+        }
+        std::vector<Node<std::uint64_t>*> handles(batch);
+
+        double find = nanosecondsPerLookup([&]{
+            std::uintptr_t sum = 0;
+            for(std::uint64_t key : queries){
+                sum += reinterpret_cast<std::uintptr_t>(tree.find(key).ans());
+            }
+            return sum;
+        });
+        double findMany = nanosecondsPerLookup([&]{
+            std::uintptr_t sum = 0;
+            for(int i = 0; i < lookups; i += batch){
+                tree.findMany(queries.begin() + i, queries.begin() + i + batch, handles.data());
+                sum += reinterpret_cast<std::uintptr_t>(handles[batch - 1]);
+            }
+            return sum;
+        });
+        double select = nanosecondsPerLookup([&]{
+            std::uintptr_t sum = 0;
+            for(int k : ranks){
+                sum += reinterpret_cast<std::uintptr_t>(tree.findKthElement(k).ans());
+            }
+            return sum;
+        });
+        double selectMany = nanosecondsPerLookup([&]{
+            std::uintptr_t sum = 0;
+            for(int i = 0; i < lookups; i += batch){
+                tree.selectMany(ranks.begin() + i, ranks.begin() + i + batch, handles.data());
+                sum += reinterpret_cast<std::uintptr_t>(handles[batch - 1]);
+            }
+            return sum;
+        });
+        std::printf("{\"size\": %d, \"find_ns\": %.1f, \"findMany_ns\": %.1f, \"findKthElement_ns\": %.1f, \"selectMany_ns\": %.1f}\n",
+                    size, find, findMany, select, selectMany);
+    }
+    return 0;
+}
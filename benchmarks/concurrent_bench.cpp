@@ -0,0 +1,123 @@
+
+/*
+this file measures the read throughput of ConcurrentTree against a Tree behind one mutex, with a 95/5 read/write mix.
+
+one writer thread inserts and removes keys, so 5% of all the operations are writes, and the reader threads run
+find, rank and findKthElement. the number of readers goes from 1 to the number of hardware threads;
+with the sequence lock the reads should scale with the readers, with the mutex they do not.
+
+build: g++ -O2 -std=c++17 -pthread -I.. concurrent_bench.cpp -o concurrent_bench
+*/
+
+#include "AVL.h"
+#include "AVLConcurrent.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const int keys = 1000000;
+static const std::chrono::milliseconds duration(500);
+
+// the same calls for both versions, so the benchmark below does not care which one it runs.
+// read returns a sum of what it found, so the compiler cannot drop the walks.
+class LockedTree{
+    private:
+    Tree<std::int64_t> tree_m;
+    std::mutex mutex_m;
+
+    public:
+    void insert(std::int64_t key) {std::lock_guard<std::mutex> lock(mutex_m); tree_m.insert(key);}
+    void remove(std::int64_t key) {std::lock_guard<std::mutex> lock(mutex_m); tree_m.remove(key);}
+    std::int64_t read(std::int64_t key, int k){
+        std::lock_guard<std::mutex> lock(mutex_m);
+        std::int64_t sum = tree_m.find(key).status() == taskStatus::SUCCESS;
+        tupleOutput<int> rank = tree_m.rank(key);
+        sum += rank.status() == taskStatus::SUCCESS ? rank.ans() : 0;
+        tupleOutput<Node<std::int64_t>*> kth = tree_m.findKthElement(k);
+        return sum + (kth.status() == taskStatus::SUCCESS ? kth.ans()->getData() : 0);
+    }
+};
+
+class SeqlockTree{
+    private:
+    ConcurrentTree<std::int64_t> tree_m;
+
+    public:
+    void insert(std::int64_t key) {tree_m.insert(key);}
+    void remove(std::int64_t key) {tree_m.remove(key);}
+    std::int64_t read(std::int64_t key, int k){
+        std::int64_t sum = tree_m.find(key).status() == taskStatus::SUCCESS;
+        tupleOutput<int> rank = tree_m.rank(key);
+        sum += rank.status() == taskStatus::SUCCESS ? rank.ans() : 0;
+        tupleOutput<std::int64_t> kth = tree_m.findKthElement(k);
+        return sum + (kth.status() == taskStatus::SUCCESS ? kth.ans() : 0);
+    }
+};
+
+template<class TreeType>
+double readsPerSecond(int readers){
+    TreeType tree;
+    for(int i = 0; i < keys; i++){
+        tree.insert(2 * static_cast<std::int64_t>(i));
+    }
+    std::atomic<bool> stop(false);
+    std::atomic<std::int64_t> reads(0);
+    std::atomic<std::int64_t> checksum(0);
+    std::vector<std::thread> threads;
+    for(int r = 0; r < readers; r++){
+        threads.emplace_back([&, r]{
+            std::mt19937 random(r);
+            std::int64_t sum = 0;
+            while(!stop.load(std::memory_order_relaxed)){
+                for(int i = 0; i < 64; i++){
+                    sum += tree.read(2 * static_cast<std::int64_t>(random() % keys), static_cast<int>(random() % keys));
+                }
+                reads += 64;
+            }
+            checksum += sum;
+        });
+    }
+    // the writer keeps writes at 5% of the operations: 1 write for every 19 reads done so far.
+    threads.emplace_back([&]{
+        std::mt19937 random(1000);
+        std::int64_t writes = 0;
+        while(!stop.load(std::memory_order_relaxed)){
+            if(writes * 19 > reads.load(std::memory_order_relaxed) + 19){
+                std::this_thread::yield();
+                continue;
+            }
+            std::int64_t key = 2 * static_cast<std::int64_t>(random() % keys) + 1;
+            tree.insert(key);
+            tree.remove(key);
+            writes += 2;
+        }
+    });
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(checksum.load() == 0){
+        std::printf("# nothing was read\n");
+    }
+    return reads.load() / seconds;
+}
+
+int main(){
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    for(int readers = 1; readers <= (hardware > 1 ? hardware : 1); readers *= 2){
+        double locked = readsPerSecond<LockedTree>(readers);
+        double seqlock = readsPerSecond<SeqlockTree>(readers);
+        std::printf("{\"readers\": %d, \"mutex_reads_per_s\": %.0f, \"seqlock_reads_per_s\": %.0f, \"speedup\": %.2f}\n",
+                    readers, locked, seqlock, seqlock / locked);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+
+/*
+this file compares the memory per node of Tree, CompactTree and WideTree, and the cost of a find in each.
+
+every size is filled twice: once by inserting the keys in random order (the pool of Tree and the arrays of CompactTree
+grow by chunks, so up to a chunk is unused), and once with assign from the sorted keys (everything reserved up front).
+WideTree has no assign, so it is only filled by inserting, once without handles and once with them. its search inside
+a node uses simd compares for 64 bit keys only with -mavx2 (or -march=native).
+a find reads the key it found, through the node or the handle, as a caller would.
+
+build: g++ -O2 -std=c++17 -I.. memory_report.cpp -o memory_report
+*/
+
+#include "AVL.h"
+#include "AVLWide.h"
+#include "CompactAVL.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+template<class TreeType, class KeyOf>
+double findNanoseconds(const TreeType& tree, const std::vector<std::uint64_t>& queries, KeyOf keyOf){
+    std::uint64_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(std::uint64_t key : queries){
+        auto answer = const_cast<TreeType&>(tree).find(key);
+        if(answer.status() == taskStatus::SUCCESS){
+            found += keyOf(answer.ans()) == key;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    if(found == 0){
+        std::printf("# no key was found\n");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / queries.size();
+}
+
+template<class TreeType, class KeyOf>
+void report(const char* name, const char* fill, const TreeType& tree, const std::vector<std::uint64_t>& queries, KeyOf keyOf){
+    std::printf("{\"tree\": \"%s\", \"fill\": \"%s\", \"size\": %d, \"bytes_per_node\": %.1f, \"find_ns\": %.1f}\n",
+                name, fill, tree.getSize(), tree.memoryPerNode(), findNanoseconds(tree, queries, keyOf));
+}
+
+int main(){
+    std::mt19937_64 random(14);
+    for(int size : {1000, 100000, 1000000, 10000000}){
+        std::vector<std::uint64_t> keys(size);
+        for(int i = 0; i < size; i++){
+            keys[i] = static_cast<std::uint64_t>(i) * 2;
+        }
+        std::vector<std::uint64_t> shuffled = keys;
+        std::shuffle(shuffled.begin(), shuffled.end(), random);
+        std::vector<std::uint64_t> queries(1000000);
+        for(std::uint64_t& query : queries){
+            query = keys[random() % size];
+        }
+        {
+            Tree<std::uint64_t> tree;
+            auto keyOf = [](const Node<std::uint64_t>* node){return node->getData();};
+            for(std::uint64_t key : shuffled){
+                tree.insert(key);
+            }
+            report("Tree", "insert", tree, queries, keyOf);
+            tree.assign(keys.begin(), keys.end());
+            report("Tree", "assign", tree, queries, keyOf);
+        }
+        {
+            CompactTree<std::uint64_t> tree;
+            auto keyOf = [&](CompactTree<std::uint64_t>::index_type node){return tree.getData(node);};
+            for(std::uint64_t key : shuffled){
+                tree.insert(key);
+            }
+            report("CompactTree", "insert", tree, queries, keyOf);
+            tree.assign(keys.begin(), keys.end());
+            report("CompactTree", "assign", tree, queries, keyOf);
+        }
+        {
+            WideTree<std::uint64_t> tree;
+            for(std::uint64_t key : shuffled){
+                tree.insert(key);
+            }
+            report("WideTree", "insert", tree, queries, [](std::uint64_t key){return key;});
+        }
+        {
+            WideTree<std::uint64_t, 16, true> tree;
+            for(std::uint64_t key : shuffled){
+                tree.insert(key);
+            }
+            report("WideTree handles", "insert", tree, queries, [](const WideEntry<std::uint64_t>* entry){return entry->getData();});
+        }
+    }
+    return 0;
+}
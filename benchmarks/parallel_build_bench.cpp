@@ -0,0 +1,62 @@
+/*
+this file measures the parallel build (assignParallel) and the parallel export (toArrayParallel) of AVLParallel.h
+against assign and inOrder on a single thread, for 1, 2, 4... threads up to the number of cores.
+the size is the first argument, 10^7 by default. 10^8 keys of 8 bytes take about 5GB for the tree and the arrays.
+
+build: g++ -O2 -std=c++17 -pthread -I.. parallel_build_bench.cpp -o parallel_build_bench
+*/
+
+#include "AVLParallel.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+template<class Function>
+double milliseconds(Function&& run){
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv){
+    int size = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    std::vector<std::uint64_t> keys(size);
+    for(int i = 0; i < size; i++){
+        keys[i] = static_cast<std::uint64_t>(i) * 2;
+    }
+    std::vector<std::uint64_t> out(size);
+    std::uint64_t check = 0;
+
+    Tree<std::uint64_t> tree;
+    double assign = milliseconds([&]{tree.assign(keys.begin(), keys.end());});
+    double inOrder = milliseconds([&]{
+        std::uint64_t* next = out.data();
+        tree.inOrder([&](std::uint64_t key){*next++ = key;});
+    });
+    check += out[size / 2];
+    std::printf("{\"size\": %d, \"threads\": 0, \"assign_ms\": %.1f, \"inOrder_ms\": %.1f}\n", size, assign, inOrder);
+
+    for(int threads = 1; ; threads *= 2){
+        threads = threads > cores ? cores : threads;
+        ThreadPool pool(threads);
+        double build = milliseconds([&]{assignParallel(tree, keys.begin(), keys.end(), &pool);});
+        double copy = milliseconds([&]{toArrayParallel(tree, out.data(), &pool);});
+        check += out[size / 2];
+        std::printf("{\"size\": %d, \"threads\": %d, \"assignParallel_ms\": %.1f, \"toArrayParallel_ms\": %.1f, "
+                    "\"build_speedup\": %.2f, \"export_speedup\": %.2f}\n",
+                    size, threads, build, copy, assign / build, inOrder / copy);
+        if(threads == cores){
+            break;
+        }
+    }
+    if(check == 0 && size > 2){
+        std::printf("# the arrays were not written\n");
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+
+/*
+this file measures the cost of the update path of insert and remove.
+
+the tree used to fix the tree after an insert with two walks from the new node to the root:
+one that added 1 to every count, and a full rebalance that went on to the root even after a rotation.
+remove did the same full rebalance. today insert and remove use retrace, one pass that stops rebalancing
+as soon as a height does not change and only updates the counts from there.
+
+legacyInsert and legacyRemove below are the old algorithms, written with the public helpers of the tree,
+so both versions run on the same tree and the same keys.
+
+build: g++ -O2 -std=c++17 -I.. rebalance_bench.cpp -o rebalance_bench
+*/
+
+#include "AVL.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+template<class T>
+tupleOutput<Node<T>*> legacyInsert(Tree<T>& tree, const T& data){
+    Node<T>* parent = nullptr;
+    Node<T>* current = tree.getRoot();
+    while(current != nullptr){
+        parent = current;
+        if(data < current->data_m){
+            current = current->getLeft();
+        }
+        else if(current->data_m < data){
+            current = current->getRight();
+        }
+        else{
+            return tupleOutput<Node<T>*>(taskStatus::FAILURE);
+        }
+    }
+    Node<T>* newNode = tree.allocateNode(data);
+    if(parent == nullptr){
+        tree.setRoot(newNode);
+        return tupleOutput<Node<T>*>(newNode);
+    }
+    newNode->setParent(parent);
+    if(data < parent->data_m){
+        parent->setLeft(newNode);
+    }
+    else{
+        parent->setRight(newNode);
+    }
+    for(Node<T>* node = parent; node != nullptr; node = node->getParent()){
+        node->setNodesInSubtree(node->getNodesInSubtree() + 1);
+    }
+    tree.updateNodesInSubTree(tree.getRoot());
+    tree.rebalance(newNode);
+    return tupleOutput<Node<T>*>(newNode);
+}
+
+template<class T>
+taskStatus legacyRemove(Tree<T>& tree, const T& data){
+    tupleOutput<Node<T>*> output = tree.find(data);
+    if(output.status() != taskStatus::SUCCESS){
+        return output.status();
+    }
+    Node<T>* node = output.ans();
+    if(node->getLeft() != nullptr && node->getRight() != nullptr){
+        Node<T>* successor = tree.findMin(node->getRight());
+        T temp = successor->data_m;
+        tree.switchNodesLocation(node, successor);
+        legacyRemove(tree, temp);
+        successor->data_m = temp;
+        return taskStatus::SUCCESS;
+    }
+    Node<T>* parent = node->getParent();
+    Node<T>* child = node->getLeft() == nullptr ? node->getRight() : node->getLeft();
+    if(parent == nullptr){
+        tree.setRoot(child);
+    }
+    else{
+        if(parent->getLeft() == node){
+            parent->setLeft(child);
+        }
+        else{
+            parent->setRight(child);
+        }
+        parent->setNodesInSubtree(parent->getNodesInSubtree() - 1);
+    }
+    if(child != nullptr){
+        child->setParent(parent);
+    }
+    tree.deallocateNode(node);
+    return tree.rebalance(parent);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(int size, int operations){
+    std::mt19937_64 random(size);
+    std::vector<long long> keys(size);
+    for(long long& key : keys){
+        key = static_cast<long long>(random() >> 1);
+    }
+    std::vector<long long> churn(operations);
+    for(long long& key : churn){
+        key = static_cast<long long>(random() >> 1);
+    }
+
+    double legacySeconds = 0;
+    double currentSeconds = 0;
+    for(int variant = 0; variant < 2; variant++){
+        // every step removes the oldest key and inserts a new one, so the size of the tree stays the same.
+        std::vector<long long> live = keys;
+        Tree<long long> tree;
+        for(long long key : live){
+            tree.insert(key);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < operations; i++){
+            long long& oldest = live[i % size];
+            if(variant == 0){
+                legacyRemove(tree, oldest);
+                legacyInsert(tree, churn[i]);
+            }
+            else{
+                tree.remove(oldest);
+                tree.insert(churn[i]);
+            }
+            oldest = churn[i];
+        }
+        (variant == 0 ? legacySeconds : currentSeconds) = secondsSince(start);
+    }
+    double legacyNs = legacySeconds * 1e9 / (2.0 * operations);
+    double currentNs = currentSeconds * 1e9 / (2.0 * operations);
+    std::printf("{\"size\": %d, \"legacy_ns_per_op\": %.1f, \"retrace_ns_per_op\": %.1f, \"speedup\": %.2f}\n",
+                size, legacyNs, currentNs, legacyNs / currentNs);
+}
+
+int main(){
+    for(int size : {1000, 100000, 1000000}){
+        run(size, 1000000);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+
+/*
+this file compares three ways to get a big tree back after a restart: inserting every key again, Tree::load
+from a snapshot, and MappedTree::open on the same snapshot (timed together with the first 1000 lookups, since the
+pages of the file are only read when a lookup touches them).
+
+build: g++ -O2 -std=c++17 -I.. snapshot_bench.cpp -o snapshot_bench
+run:   ./snapshot_bench [path of the snapshot file, snapshot.bin by default]
+*/
+
+#include "AVL.h"
+#include "AVLMapped.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+template<class Function>
+double milliseconds(Function&& run){
+    auto start = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv){
+    const char* path = argc > 1 ? argv[1] : "snapshot.bin";
+    std::mt19937_64 random(20);
+    for(int size : {100000, 1000000, 10000000}){
+        std::vector<std::uint64_t> keys(size);
+        for(int i = 0; i < size; i++){
+            keys[i] = static_cast<std::uint64_t>(i) * 2;
+        }
+        std::shuffle(keys.begin(), keys.end(), random);
+        Tree<std::uint64_t> tree;
+        double insert = milliseconds([&]{
+            for(std::uint64_t key : keys){
+                tree.insert(key);
+            }
+        });
+        double save = milliseconds([&]{
+            if(tree.save(path) != taskStatus::SUCCESS){
+                std::printf("# could not write %s\n", path);
+            }
+        });
+        Tree<std::uint64_t> loaded;
+        double load = milliseconds([&]{
+            if(loaded.load(path) != taskStatus::SUCCESS){
+                std::printf("# could not load %s\n", path);
+            }
+        });
+        MappedTree<std::uint64_t> mapped;
+        int found = 0;
+        double open = milliseconds([&]{
+            mapped.open(path);
+            for(int i = 0; i < 1000; i++){
+                found += mapped.find(keys[i]).status() == taskStatus::SUCCESS;
+            }
+        });
+        if(found != 1000 || loaded.getSize() != size){
+            std::printf("# the snapshot does not match the tree\n");
+        }
+        std::printf("{\"size\": %d, \"insert_ms\": %.1f, \"save_ms\": %.1f, \"load_ms\": %.1f, \"mapped_open_1000_finds_ms\": %.2f}\n",
+                    size, insert, save, load, open);
+    }
+    std::remove(path);
+    return 0;
+}
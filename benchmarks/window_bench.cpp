@@ -0,0 +1,62 @@
+
+/*
+this file measures how many samples per second SlidingWindow takes, with p50, p99 and p999 read every tick
+(every 1000 samples), for a few window sizes, pushing the samples one by one and in batches of 256.
+
+build: g++ -O2 -std=c++17 -I.. window_bench.cpp -o window_bench
+*/
+
+#include "AVL.h"
+#include "AVLWindow.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static const int samples = 10000000;
+static const int tick = 1000;
+static const int batch = 256;
+
+double samplesPerSecond(int capacity, bool batched, const std::vector<std::uint32_t>& stream){
+    SlidingWindow<std::uint32_t> window(capacity);
+    const double levels[] = {0.5, 0.99, 0.999};
+    std::uint32_t values[3];
+    std::uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < samples; i += tick){
+        if(batched){
+            for(int j = i; j < i + tick; j += batch){
+                int end = j + batch < i + tick ? j + batch : i + tick;
+                window.push(stream.begin() + j, stream.begin() + end);
+            }
+        }
+        else{
+            for(int j = i; j < i + tick; j++){
+                window.push(stream[j]);
+            }
+        }
+        window.quantiles(levels, levels + 3, values);
+        sum += values[0] + values[1] + values[2];
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(sum == 0){
+        std::printf("# all the quantiles were 0\n");
+    }
+    return samples / seconds;
+}
+
+int main(){
+    std::mt19937 random(21);
+    std::lognormal_distribution<double> latency(5, 1); // something like request latencies
+    std::vector<std::uint32_t> stream(samples);
+    for(std::uint32_t& sample : stream){
+        sample = static_cast<std::uint32_t>(latency(random));
+    }
+    for(int capacity : {1000, 100000, 1000000}){
+        std::printf("{\"window\": %d, \"push_samples_per_s\": %.0f, \"batched_push_samples_per_s\": %.0f}\n",
+                    capacity, samplesPerSecond(capacity, false, stream), samplesPerSecond(capacity, true, stream));
+    }
+    return 0;
+}
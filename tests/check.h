@@ -0,0 +1,201 @@
+/*
+this header file contains what the tests in tests/ share: CHECK, which counts and prints the mismatches, and the
+checks that compare a container with a std::set, by its answers, by its content and by the shape of its nodes.
+
+a test runs long random sequences of operations with fixed seeds on a container and on its reference from the
+standard library, and returns report(), 1 if there was any mismatch. the asserts of the headers stay on in the tests.
+*/
+
+
+
+#ifndef AVL_TESTS_CHECK_H
+#define AVL_TESTS_CHECK_H
+
+#undef NDEBUG
+
+#include "AVL.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+inline int failures = 0;
+
+// counts a mismatch, and prints the first ones with the line of the check. a test names what it checks in name.
+#define CHECK(condition) check((condition), name, #condition, __LINE__)
+
+inline void check(bool passed, const char* name, const char* condition, int line){
+    if(passed){
+        return;
+    }
+    if(failures < 20){
+        std::printf("%s: line %d: %s\n", name, line, condition);
+    }
+    failures++;
+}
+
+inline int report(){
+    if(failures > 0){
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
+
+template<class Container, class = void>
+struct hasCountRange : std::false_type{};
+template<class Container>
+struct hasCountRange<Container, decltype(void(std::declval<Container&>().countRange(0, 0)))> : std::true_type{};
+
+inline taskStatus statusOf(taskStatus status) {return status;}
+template<class X>
+taskStatus statusOf(const tupleOutput<X>& output) {return output.status();}
+
+// compares the whole content of tree with reference, rank by rank, through keyOf that turns an answer into a key.
+template<class Container, class KeyOf>
+void checkContent(const char* name, Container& tree, const std::set<int>& reference, KeyOf keyOf){
+    CHECK(tree.getSize() == static_cast<int>(reference.size()));
+    int k = 0;
+    for(int key : reference){
+        auto kth = tree.findKthElement(k);
+        CHECK(kth.status() == taskStatus::SUCCESS && keyOf(kth.ans()) == key);
+        k++;
+    }
+    CHECK(tree.findKthElement(k).status() != taskStatus::SUCCESS);
+    CHECK(tree.findKthElement(-1).status() != taskStatus::SUCCESS);
+}
+
+// runs operations random inserts, removes and queries of keys in [0, range) on tree and on a std::set.
+// every container of the repository has insert, remove, find, rank, findKthElement, getSize and clear,
+// and countRange is checked for those that have it.
+template<class Container, class KeyOf>
+void checkOrderedSet(const char* name, Container& tree, KeyOf keyOf, int operations, int range, std::mt19937& random){
+    std::set<int> reference;
+    std::uniform_int_distribution<int> keys(0, range - 1);
+    for(int i = 0; i < operations; i++){
+        int key = keys(random);
+        int kind = static_cast<int>(random() % 20);
+        if(kind < 9){
+            bool added = reference.insert(key).second;
+            CHECK((statusOf(tree.insert(key)) == taskStatus::SUCCESS) == added);
+        }
+        else if(kind < 16){
+            bool removed = reference.erase(key) == 1;
+            CHECK((tree.remove(key) == taskStatus::SUCCESS) == removed);
+        }
+        else{
+            auto found = tree.find(key);
+            bool present = reference.count(key) == 1;
+            CHECK((found.status() == taskStatus::SUCCESS) == present);
+            if(present){
+                CHECK(keyOf(found.ans()) == key);
+                auto rank = tree.rank(key);
+                CHECK(rank.status() == taskStatus::SUCCESS
+                      && rank.ans() == static_cast<int>(std::distance(reference.begin(), reference.find(key))));
+            }
+            if constexpr (hasCountRange<Container>::value){
+                int high = keys(random);
+                int expected = key < high ? static_cast<int>(std::distance(reference.lower_bound(key), reference.lower_bound(high))) : 0;
+                CHECK(tree.countRange(key, high) == expected);
+            }
+        }
+        if(i % 500 == 0){
+            checkContent(name, tree, reference, keyOf);
+        }
+    }
+    checkContent(name, tree, reference, keyOf);
+    tree.clear();
+    CHECK(tree.getSize() == 0);
+}
+
+// checks the links, heights and counts of every node of a subtree, and that the keys are in order.
+// returns the height of node.
+template<class T, class Aggregate>
+int checkShape(const char* name, const Node<T, Aggregate>* node, const Node<T, Aggregate>* parent = nullptr){
+    if(node == nullptr){
+        return 0;
+    }
+    CHECK(node->getParent() == parent);
+    CHECK(node->getLeft() == nullptr || node->getLeft()->getData() < node->getData());
+    CHECK(node->getRight() == nullptr || node->getData() < node->getRight()->getData());
+    int left = checkShape(name, node->getLeft(), node);
+    int right = checkShape(name, node->getRight(), node);
+    int leftNodes = node->getLeft() == nullptr ? 0 : node->getLeft()->getNodesInSubtree();
+    int rightNodes = node->getRight() == nullptr ? 0 : node->getRight()->getNodesInSubtree();
+    CHECK(std::abs(left - right) <= 1);
+    CHECK(node->getHeight() == std::max(left, right) + 1);
+    CHECK(node->getNodesInSubtree() == leftNodes + rightNodes + 1);
+    return std::max(left, right) + 1;
+}
+
+// checks the shape of tree, and that it goes over the keys of reference in order.
+template<class Container>
+void checkTree(const char* name, Container& tree, const std::set<int>& reference){
+    checkShape(name, tree.getRoot());
+    CHECK(std::equal(tree.begin(), tree.end(), reference.begin(), reference.end()));
+}
+
+// writers threads insert and remove the odd keys of [0, 20000) of a container that is safe for threads, while two
+// readers look for the even keys, which stay in it all along: they are always found, and their ranks are between
+// the number of even keys before them and the number of all keys before them.
+template<class Container>
+void checkReaders(const char* name, Container& tree, int writers){
+    const int range = 20000;
+    for(int key = 0; key < range; key += 2){
+        tree.insert(key);
+    }
+    std::atomic<int> running(writers);
+    std::atomic<int> missed(0);
+    std::vector<std::thread> threads;
+    for(int writer = 0; writer < writers; writer++){
+        threads.emplace_back([&, writer]{
+            std::mt19937 random(writer);
+            for(int i = 0; i < 20000; i++){
+                int key = 2 * static_cast<int>(random() % (range / 2)) + 1;
+                if(random() % 2 == 0){
+                    tree.insert(key);
+                }
+                else{
+                    tree.remove(key);
+                }
+            }
+            running--;
+        });
+    }
+    for(int reader = 0; reader < 2; reader++){
+        threads.emplace_back([&, reader]{
+            std::mt19937 random(100 + reader);
+            while(running.load() > 0){
+                int key = 2 * static_cast<int>(random() % (range / 2));
+                auto found = tree.find(key);
+                auto rank = tree.rank(key);
+                if(found.status() != taskStatus::SUCCESS || found.ans() != key
+                   || rank.status() != taskStatus::SUCCESS || rank.ans() < key / 2 || rank.ans() > key){
+                    missed++;
+                }
+            }
+        });
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    CHECK(missed.load() == 0);
+    std::set<int> reference;
+    for(int key = 0; key < range; key++){
+        if(tree.find(key).status() == taskStatus::SUCCESS){
+            reference.insert(key);
+        }
+    }
+    checkContent(name, tree, reference, [](int key){return key;});
+}
+
+#endif //AVL_TESTS_CHECK_H
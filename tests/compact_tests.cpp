@@ -0,0 +1,126 @@
+/*
+this file checks CompactTree against std::set, and the shape of its nodes, which are named by indices.
+
+build: g++ -O2 -std=c++17 -I.. compact_tests.cpp -o compact_tests
+*/
+
+#include "check.h"
+
+#include "CompactAVL.h"
+
+#include <vector>
+
+typedef CompactTree<int> IntTree;
+
+// the same checks as checkShape, through the indices of the tree. returns the height of node.
+int checkCompactShape(const char* name, const IntTree& tree, IntTree::index_type node, IntTree::index_type parent){
+    if(node == IntTree::nil){
+        return 0;
+    }
+    IntTree::index_type left = tree.getLeft(node);
+    IntTree::index_type right = tree.getRight(node);
+    CHECK(tree.getParent(node) == parent);
+    CHECK(left == IntTree::nil || tree.getData(left) < tree.getData(node));
+    CHECK(right == IntTree::nil || tree.getData(node) < tree.getData(right));
+    int leftHeight = checkCompactShape(name, tree, left, node);
+    int rightHeight = checkCompactShape(name, tree, right, node);
+    CHECK(std::abs(leftHeight - rightHeight) <= 1);
+    CHECK(tree.getHeight(node) == std::max(leftHeight, rightHeight) + 1);
+    CHECK(tree.getNodesInSubtree(node) == tree.getNodesInSubtree(left) + tree.getNodesInSubtree(right) + 1);
+    return std::max(leftHeight, rightHeight) + 1;
+}
+
+// random inserts and removes against std::set, then the indices: an index stays the same node while other nodes
+// come and go, erase of a freed index fails, rankNode, the bounds, and assign.
+void checkCompact(std::mt19937& random){
+    const char* name = "CompactTree";
+    IntTree tree;
+    checkOrderedSet(name, tree, [&](IntTree::index_type node){return tree.getData(node);}, 30000, 1000, random);
+
+    std::set<int> reference;
+    for(int round = 0; round < 50; round++){
+        for(int i = 0; i < 400; i++){
+            int key = static_cast<int>(random() % 5000);
+            if(random() % 3 == 0){
+                CHECK((tree.remove(key) == taskStatus::SUCCESS) == (reference.erase(key) == 1));
+            }
+            else{
+                CHECK((tree.insert(key).status() == taskStatus::SUCCESS) == reference.insert(key).second);
+            }
+        }
+        checkCompactShape(name, tree, tree.getRoot(), IntTree::nil);
+        std::vector<IntTree::index_type> indices;
+        for(int key : reference){
+            indices.push_back(tree.find(key).ans());
+        }
+        int rank = 0;
+        for(int key : reference){
+            CHECK(tree.rankNode(indices[rank]).ans() == rank && tree.getData(indices[rank]) == key);
+            rank++;
+        }
+        for(int i = 0; i < 50; i++){
+            int key = static_cast<int>(random() % 5000);
+            auto lower = tree.lowerBound(key);
+            auto upper = tree.upperBound(key);
+            CHECK((lower.status() == taskStatus::SUCCESS) == (reference.lower_bound(key) != reference.end()));
+            CHECK(lower.status() != taskStatus::SUCCESS || tree.getData(lower.ans()) == *reference.lower_bound(key));
+            CHECK((upper.status() == taskStatus::SUCCESS) == (reference.upper_bound(key) != reference.end()));
+            CHECK(upper.status() != taskStatus::SUCCESS || tree.getData(upper.ans()) == *reference.upper_bound(key));
+        }
+        if(!reference.empty()){
+            size_t erased = random() % indices.size();
+            int key = tree.getData(indices[erased]);
+            CHECK(tree.erase(indices[erased]) == taskStatus::SUCCESS);
+            CHECK(tree.erase(indices[erased]) == taskStatus::INVALID_INPUT);
+            CHECK(tree.rankNode(indices[erased]).status() == taskStatus::INVALID_INPUT);
+            reference.erase(key);
+        }
+    }
+    CHECK(tree.erase(IntTree::nil) == taskStatus::INVALID_INPUT);
+
+    std::vector<int> keys(reference.begin(), reference.end());
+    CHECK(tree.assign(keys.begin(), keys.end()) == taskStatus::SUCCESS);
+    checkCompactShape(name, tree, tree.getRoot(), IntTree::nil);
+    checkContent(name, tree, reference, [&](IntTree::index_type node){return tree.getData(node);});
+    if(keys.size() > 1){
+        std::swap(keys.front(), keys.back());
+        CHECK(tree.assign(keys.begin(), keys.end()) == taskStatus::INVALID_INPUT && tree.getSize() == 0);
+    }
+    CHECK(tree.reserve(-1) == taskStatus::INVALID_INPUT);
+}
+
+// the arrays grow by chunks: past the first chunk, a tree filled by inserts has less than a chunk of capacity
+// that is not used, so it takes about as much memory as a tree filled by assign, which reserves everything at once.
+void checkCompactMemory(std::mt19937& random){
+    const char* name = "CompactTree memory";
+    const int size = 200000;
+    std::vector<int> keys(size);
+    for(int i = 0; i < size; i++){
+        keys[i] = 2 * i;
+    }
+    IntTree assigned;
+    assigned.assign(keys.begin(), keys.end());
+    std::shuffle(keys.begin(), keys.end(), random);
+    IntTree inserted;
+    for(int key : keys){
+        inserted.insert(key);
+    }
+    CHECK(inserted.getSize() == size);
+    CHECK(inserted.memoryUsage() <= assigned.memoryUsage() + assigned.memoryUsage() / 10);
+    for(int key : keys){
+        inserted.remove(key);
+    }
+    size_t empty = inserted.memoryUsage();
+    for(int key : keys){
+        inserted.insert(key);
+    }
+    CHECK(inserted.memoryUsage() == empty);
+    checkCompactShape(name, inserted, inserted.getRoot(), IntTree::nil);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkCompact(random);
+    checkCompactMemory(random);
+    return report();
+}
@@ -0,0 +1,30 @@
+/*
+this file checks ConcurrentTree against std::set from one thread, then with a writer and readers that run at the same
+time, and that only its tree stores the links atomically: a plain Tree keeps plain stores.
+
+build: g++ -O2 -std=c++17 -pthread -I.. concurrent_tests.cpp -o concurrent_tests
+*/
+
+#include "check.h"
+
+#include "AVLConcurrent.h"
+
+static_assert(hasSharedLinks<SharedLinks<NoAggregate<int>>>::value && !hasSharedLinks<NoAggregate<int>>::value
+              && !hasSharedLinks<SumAggregate<int>>::value, "only the tree of ConcurrentTree shares its links");
+static_assert(std::is_same<SharedLinks<SumAggregate<int>>::value_type, int>::value, "SharedLinks keeps the aggregate");
+
+void checkConcurrent(std::mt19937& random){
+    const char* name = "ConcurrentTree";
+    ConcurrentTree<int> tree;
+    checkOrderedSet(name, tree, [](int key){return key;}, 30000, 1000, random);
+    // the nodes that were removed are spare nodes now, and the inserts below take them again.
+    checkReaders(name, tree, 1);
+    ConcurrentTree<int, std::less<int>, SumAggregate<int>> sums;
+    checkOrderedSet("ConcurrentTree sums", sums, [](int key){return key;}, 10000, 1000, random);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkConcurrent(random);
+    return report();
+}
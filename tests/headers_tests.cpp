@@ -0,0 +1,53 @@
+/*
+this file includes every header of the repository, so each of them is built with the warnings of the tests, and
+runs a few operations on every container, so their templates are built too. the other tests check the behaviour.
+
+build: g++ -O2 -std=c++17 -pthread -I.. headers_tests.cpp -o headers_tests
+*/
+
+#include "check.h"
+
+#include "AVL.h"
+#include "AVLConcurrent.h"
+#include "AVLMultiset.h"
+#include "AVLParallel.h"
+#include "AVLSequence.h"
+#include "AVLSetOperations.h"
+#include "AVLSharded.h"
+#include "AVLWide.h"
+#include "AVLWindow.h"
+#include "CompactAVL.h"
+#include "ThreadPool.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include "AVLMapped.h"
+#endif
+
+int main(){
+    const char* name = "headers";
+    Tree<int> tree;
+    CHECK(tree.insert(1).status() == taskStatus::SUCCESS);
+    CompactTree<int> compact;
+    CHECK(compact.insert(1).status() == taskStatus::SUCCESS);
+    WideTree<int> wide;
+    CHECK(wide.insert(1).status() == taskStatus::SUCCESS);
+    ConcurrentTree<int> concurrent;
+    CHECK(concurrent.insert(1) == taskStatus::SUCCESS);
+    ShardedTree<int> sharded(4, 64);
+    CHECK(sharded.insert(1) == taskStatus::SUCCESS);
+    Multiset<int> multiset;
+    CHECK(multiset.insert(1, 2).status() == taskStatus::SUCCESS);
+    Sequence<int> sequence;
+    CHECK(sequence.pushBack(1).status() == taskStatus::SUCCESS);
+    SlidingWindow<int> window(8);
+    CHECK(window.push(1) == taskStatus::SUCCESS);
+    ThreadPool pool(2);
+    const int keys[] = {1, 2};
+    Tree<int> other;
+    CHECK(assignParallel(other, keys, keys + 2, &pool) == taskStatus::SUCCESS);
+    CHECK(treeUnion(tree, other, &pool) == taskStatus::SUCCESS && tree.getSize() == 2);
+#if defined(__unix__) || defined(__APPLE__)
+    MappedTree<int> mapped;
+    CHECK(mapped.getSize() == 0);
+#endif
+    return report();
+}
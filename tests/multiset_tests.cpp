@@ -0,0 +1,104 @@
+/*
+this file checks Multiset against std::multiset: random inserts and removes of many copies, and the counts, ranks and
+kth copies after them, then the limit of INT_MAX copies in all.
+
+build: g++ -O2 -std=c++17 -I.. multiset_tests.cpp -o multiset_tests
+*/
+
+#include "check.h"
+
+#include "AVLMultiset.h"
+
+#include <limits>
+
+// a comparator with state, that counts its calls.
+struct CountingLess{
+    int* calls_m;
+    bool operator()(int left, int right) const {(*calls_m)++; return left < right;}
+};
+
+void checkMultiset(std::mt19937& random){
+    const char* name = "Multiset";
+    Multiset<int> multiset;
+    std::multiset<int> reference;
+    std::uniform_int_distribution<int> keys(0, 300);
+    for(int i = 0; i < 30000; i++){
+        int key = keys(random);
+        int copies = 1 + static_cast<int>(random() % 3);
+        int kind = static_cast<int>(random() % 10);
+        if(kind < 4){
+            CHECK(multiset.insert(key, copies).status() == taskStatus::SUCCESS);
+            for(int j = 0; j < copies; j++){
+                reference.insert(key);
+            }
+        }
+        else if(kind < 7){
+            int count = static_cast<int>(reference.count(key));
+            CHECK((multiset.remove(key, copies) == taskStatus::SUCCESS) == (count > 0));
+            for(int j = 0; j < copies && reference.count(key) > 0; j++){
+                reference.erase(reference.find(key));
+            }
+        }
+        else if(kind < 8 && !reference.empty()){
+            int k = static_cast<int>(random() % reference.size());
+            auto kth = multiset.findKthElement(k);
+            CHECK(kth.status() == taskStatus::SUCCESS && kth.ans()->getData().key_m == *std::next(reference.begin(), k));
+        }
+        else{
+            int high = keys(random);
+            int smaller = static_cast<int>(std::distance(reference.begin(), reference.lower_bound(key)));
+            CHECK(multiset.count(key) == static_cast<int>(reference.count(key)));
+            CHECK(multiset.countSmaller(key) == smaller);
+            auto rank = multiset.rank(key);
+            CHECK((rank.status() == taskStatus::SUCCESS) == (reference.count(key) > 0));
+            CHECK(rank.status() != taskStatus::SUCCESS || rank.ans() == smaller);
+            int expected = key < high ? static_cast<int>(std::distance(reference.lower_bound(key), reference.lower_bound(high))) : 0;
+            CHECK(multiset.countRange(key, high) == expected);
+        }
+        CHECK(multiset.getSize() == static_cast<int>(reference.size()));
+    }
+    std::set<int> distinct(reference.begin(), reference.end());
+    CHECK(multiset.getDistinct() == static_cast<int>(distinct.size()));
+    CHECK(std::equal(multiset.begin(), multiset.end(), distinct.begin(), distinct.end(),
+                     [&](const MultisetEntry<int>& entry, int key){return entry.key_m == key && entry.copies_m == static_cast<int>(reference.count(key));}));
+    CHECK(multiset.insert(1, 0).status() == taskStatus::INVALID_INPUT);
+    CHECK(multiset.remove(1, 0) == taskStatus::INVALID_INPUT);
+
+    // rank is a single descent: one comparison per node and one more at the bottom.
+    int calls = 0;
+    Multiset<int, CountingLess> counting(CountingLess{&calls});
+    for(int i = 0; i < 10000; i++){
+        counting.insert(static_cast<int>(random() % 5000), 1 + static_cast<int>(random() % 3));
+    }
+    const int height = counting.getRoot()->getHeight();
+    for(int i = 0; i < 1000; i++){
+        calls = 0;
+        counting.rank(static_cast<int>(random() % 5000));
+        CHECK(calls <= height + 1);
+    }
+}
+
+// the copies of the whole set stop at INT_MAX, whether they go to a new key or to a key that is already there.
+void checkCopiesLimit(){
+    const char* name = "Multiset limit";
+    const int most = std::numeric_limits<int>::max();
+    Multiset<int> multiset;
+    CHECK(multiset.insert(1, most - 10).status() == taskStatus::SUCCESS);
+    CHECK(multiset.insert(2, 10).status() == taskStatus::SUCCESS);
+    CHECK(multiset.getSize() == most);
+    CHECK(multiset.insert(1, 1).status() == taskStatus::ALLOCATION_ERROR);
+    CHECK(multiset.insert(3, 1).status() == taskStatus::ALLOCATION_ERROR);
+    CHECK(multiset.insert(2, most).status() == taskStatus::ALLOCATION_ERROR);
+    CHECK(multiset.getSize() == most && multiset.getDistinct() == 2 && multiset.count(2) == 10);
+    CHECK(multiset.rank(2).ans() == most - 10 && multiset.findKthElement(most - 1).ans()->getData().key_m == 2);
+    CHECK(multiset.remove(1, 5) == taskStatus::SUCCESS);
+    CHECK(multiset.insert(3, 5).status() == taskStatus::SUCCESS && multiset.getSize() == most);
+    CHECK(multiset.countRange(2, 4) == 15);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkMultiset(random);
+    checkCopiesLimit();
+    return report();
+}
@@ -0,0 +1,111 @@
+/*
+this file checks assignParallel and toArrayParallel against assign and std::set: the same shape as assign, the
+aggregates, the ranges that are not sorted, the keys that fall back to the calling thread, and a tree that goes on
+with inserts and removes after a parallel build.
+
+build: g++ -O2 -std=c++17 -pthread -I.. parallel_tests.cpp -o parallel_tests
+*/
+
+#include "check.h"
+
+#include "AVLParallel.h"
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+typedef Tree<int, std::less<int>, SumAggregate<long long>> SumTree; // the sums of 300000 keys do not fit in an int
+
+// the same keys give the same shape as assign, node by node.
+template<class X, class Aggregate>
+void checkSameShape(const char* name, const Node<X, Aggregate>* node, const Node<X, Aggregate>* other){
+    CHECK((node == nullptr) == (other == nullptr));
+    if(node == nullptr || other == nullptr){
+        return;
+    }
+    CHECK(node->getData() == other->getData() && node->getHeight() == other->getHeight());
+    checkSameShape(name, node->getLeft(), other->getLeft());
+    checkSameShape(name, node->getRight(), other->getRight());
+}
+
+void checkParallel(std::mt19937& random, ThreadPool& pool){
+    const char* name = "parallel";
+    for(int size : {0, 1, 1000, 100000, 300000}){
+        std::vector<int> keys(size);
+        int key = 0;
+        for(int& next : keys){
+            key += 1 + static_cast<int>(random() % 3);
+            next = key;
+        }
+        SumTree tree;
+        tree.insert(-1); // assignParallel replaces what was there
+        CHECK(assignParallel(tree, keys.begin(), keys.end(), &pool) == taskStatus::SUCCESS);
+        std::set<int> reference(keys.begin(), keys.end());
+        checkTree(name, tree, reference);
+        CHECK(tree.aggregateRank(0, tree.getSize()).ans() == std::accumulate(keys.begin(), keys.end(), 0LL));
+        SumTree assigned(keys.begin(), keys.end());
+        checkSameShape(name, tree.getRoot(), assigned.getRoot());
+
+        std::vector<int> out(keys.size() + 1, -7);
+        CHECK(toArrayParallel(tree, out.data(), &pool) == taskStatus::SUCCESS);
+        CHECK(std::equal(keys.begin(), keys.end(), out.begin()) && out.back() == -7);
+        std::fill(out.begin(), out.end(), -7);
+        CHECK(toArrayParallel(tree, out.data()) == taskStatus::SUCCESS);
+        CHECK(std::equal(keys.begin(), keys.end(), out.begin()) && out.back() == -7);
+
+        // the tree is a tree like any other after the build.
+        for(int i = 0; i < 2000; i++){
+            int changed = static_cast<int>(random() % (key + 10));
+            if(random() % 2 == 0){
+                CHECK((tree.insert(changed).status() == taskStatus::SUCCESS) == reference.insert(changed).second);
+            }
+            else{
+                CHECK((tree.remove(changed) == taskStatus::SUCCESS) == (reference.erase(changed) == 1));
+            }
+        }
+        checkTree(name, tree, reference);
+        CHECK(tree.aggregateRank(0, tree.getSize()).ans() == std::accumulate(reference.begin(), reference.end(), 0LL));
+
+        if(size > 1){
+            // two keys out of order far apart, and two equal keys, are not a strictly increasing range.
+            std::vector<int> swapped = keys;
+            std::swap(swapped[size / 100], swapped[size / 2]);
+            CHECK(assignParallel(tree, swapped.begin(), swapped.end(), &pool) == taskStatus::INVALID_INPUT);
+            CHECK(tree.getSize() == 0 && tree.getRoot() == nullptr);
+            std::vector<int> repeated = keys;
+            repeated[size - 1] = repeated[size - 2];
+            CHECK(assignParallel(tree, repeated.begin(), repeated.end(), &pool) == taskStatus::INVALID_INPUT);
+            CHECK(tree.getSize() == 0);
+            CHECK(assignParallel(tree, keys.begin(), keys.end(), &pool) == taskStatus::SUCCESS && tree.getSize() == size);
+        }
+    }
+    SumTree empty;
+    CHECK(toArrayParallel(empty, static_cast<int*>(nullptr), &pool) == taskStatus::SUCCESS);
+    empty.insert(1);
+    CHECK(toArrayParallel(empty, static_cast<int*>(nullptr), &pool) == taskStatus::INVALID_INPUT);
+}
+
+// std::string may throw when it is copied, so both run on the calling thread, with the same answers.
+void checkParallelFallback(std::mt19937& random, ThreadPool& pool){
+    const char* name = "parallel fallback";
+    std::set<std::string> reference;
+    for(int i = 0; i < 30000; i++){
+        reference.insert("key " + std::to_string(random() % 1000000));
+    }
+    std::vector<std::string> keys(reference.begin(), reference.end());
+    Tree<std::string> tree;
+    CHECK(assignParallel(tree, keys.begin(), keys.end(), &pool) == taskStatus::SUCCESS);
+    CHECK(tree.getSize() == static_cast<int>(keys.size()) && std::equal(tree.begin(), tree.end(), keys.begin(), keys.end()));
+    std::vector<std::string> out(keys.size());
+    CHECK(toArrayParallel(tree, out.data(), &pool) == taskStatus::SUCCESS && out == keys);
+    std::swap(keys.front(), keys.back());
+    CHECK(assignParallel(tree, keys.begin(), keys.end(), &pool) == taskStatus::INVALID_INPUT && tree.getSize() == 0);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    ThreadPool pool(4);
+    checkParallel(random, pool);
+    checkParallelFallback(random, pool);
+    return report();
+}
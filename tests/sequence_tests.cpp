@@ -0,0 +1,105 @@
+/*
+this file checks Sequence against std::vector: random inserts, erases, sets and moves at random indices, and the sums
+of random ranges. the order of the nodes comes from their positions, so the shape is checked by the counts only.
+
+build: g++ -O2 -std=c++17 -I.. sequence_tests.cpp -o sequence_tests
+*/
+
+#include "check.h"
+
+#include "AVLSequence.h"
+
+#include <numeric>
+#include <vector>
+
+typedef Node<int, SumAggregate<int>> SumNode;
+
+// the links, heights and counts of every node. returns the height of node.
+int checkSequenceShape(const char* name, const SumNode* node, const SumNode* parent){
+    if(node == nullptr){
+        return 0;
+    }
+    CHECK(node->getParent() == parent);
+    int left = checkSequenceShape(name, node->getLeft(), node);
+    int right = checkSequenceShape(name, node->getRight(), node);
+    int leftNodes = node->getLeft() == nullptr ? 0 : node->getLeft()->getNodesInSubtree();
+    int rightNodes = node->getRight() == nullptr ? 0 : node->getRight()->getNodesInSubtree();
+    CHECK(std::abs(left - right) <= 1);
+    CHECK(node->getHeight() == std::max(left, right) + 1);
+    CHECK(node->getNodesInSubtree() == leftNodes + rightNodes + 1);
+    return std::max(left, right) + 1;
+}
+
+void checkSequence(std::mt19937& random){
+    const char* name = "Sequence";
+    Sequence<int, SumAggregate<int>> sequence;
+    std::vector<int> reference;
+    for(int i = 0; i < 30000; i++){
+        int size = static_cast<int>(reference.size());
+        int index = static_cast<int>(random() % (size + 1));
+        int value = static_cast<int>(random() % 1000);
+        int kind = static_cast<int>(random() % 12);
+        if(kind < 4){
+            CHECK(sequence.insertAt(index, value).status() == taskStatus::SUCCESS);
+            reference.insert(reference.begin() + index, value);
+        }
+        else if(kind < 5){
+            bool front = random() % 2 == 0;
+            CHECK((front ? sequence.pushFront(value) : sequence.pushBack(value)).status() == taskStatus::SUCCESS);
+            reference.insert(front ? reference.begin() : reference.end(), value);
+        }
+        else if(kind < 8){
+            CHECK((sequence.eraseAt(index) == taskStatus::SUCCESS) == (index < size));
+            if(index < size){
+                reference.erase(reference.begin() + index);
+            }
+        }
+        else if(kind < 9){
+            CHECK((sequence.setAt(index, value) == taskStatus::SUCCESS) == (index < size));
+            if(index < size){
+                reference[index] = value;
+            }
+        }
+        else if(kind < 10 && size > 0){
+            // moveTo keeps the node, so the handle has the new index right after.
+            int from = static_cast<int>(random() % size);
+            int to = static_cast<int>(random() % size);
+            SumNode* node = sequence.at(from).ans();
+            CHECK(sequence.moveTo(node, to) == taskStatus::SUCCESS);
+            CHECK(sequence.indexOf(node).ans() == to && sequence.at(to).ans() == node);
+            int moved = reference[from];
+            reference.erase(reference.begin() + from);
+            reference.insert(reference.begin() + to, moved);
+        }
+        else{
+            int last = index + static_cast<int>(random() % (size - index + 1));
+            auto sum = sequence.aggregate(index, last);
+            CHECK(sum.status() == taskStatus::SUCCESS && sum.ans() == std::accumulate(reference.begin() + index, reference.begin() + last, 0));
+            CHECK(sequence.at(size).status() != taskStatus::SUCCESS);
+        }
+        CHECK(sequence.getSize() == static_cast<int>(reference.size()));
+        if(i % 500 == 0){
+            CHECK(std::equal(sequence.begin(), sequence.end(), reference.begin(), reference.end()));
+            checkSequenceShape(name, sequence.getRoot(), nullptr);
+        }
+    }
+    CHECK(std::equal(sequence.begin(), sequence.end(), reference.begin(), reference.end()));
+    CHECK(std::equal(sequence.rbegin(), sequence.rend(), reference.rbegin(), reference.rend()));
+    CHECK(sequence.insertAt(-1, 0).status() == taskStatus::INVALID_INPUT);
+    CHECK(sequence.insertAt(sequence.getSize() + 1, 0).status() == taskStatus::INVALID_INPUT);
+
+    // assign keeps the order of the range, which does not have to be sorted.
+    std::vector<int> values(5000);
+    for(int& value : values){
+        value = static_cast<int>(random() % 100);
+    }
+    CHECK(sequence.assign(values.begin(), values.end()) == taskStatus::SUCCESS);
+    CHECK(std::equal(sequence.begin(), sequence.end(), values.begin(), values.end()));
+    checkSequenceShape(name, sequence.getRoot(), nullptr);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkSequence(random);
+    return report();
+}
@@ -0,0 +1,80 @@
+/*
+this file checks union, intersection and difference against std::set_union, std::set_intersection and
+std::set_difference, on trees big enough to fork on a ThreadPool and on small ones without it.
+
+build: g++ -O2 -std=c++17 -pthread -I.. set_operations_tests.cpp -o set_operations_tests
+*/
+
+#include "check.h"
+
+#include "AVLSetOperations.h"
+#include "ThreadPool.h"
+
+#include <numeric>
+#include <vector>
+
+typedef Tree<int, std::less<int>, SumAggregate<int>> SumTree;
+
+// the result is in target, with the right shape and sums, source is empty, and the nodes of target that are in the
+// result are the same nodes as before.
+void checkSetOperations(std::mt19937& random, ThreadPool& pool){
+    const char* name = "set operations";
+    for(int round = 0; round < 24; round++){
+        int size = round % 2 == 0 ? 30000 : 300;
+        std::uniform_int_distribution<int> keys(0, round % 8 < 4 ? 3 * size : size / 2);
+        std::set<int> first;
+        std::set<int> second;
+        for(int i = 0; i < size; i++){
+            first.insert(keys(random));
+            second.insert(keys(random));
+        }
+        std::vector<int> expected;
+        int kind = round % 3;
+        if(kind == 0){
+            std::set_union(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(expected));
+        }
+        else if(kind == 1){
+            std::set_intersection(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(expected));
+        }
+        else{
+            std::set_difference(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(expected));
+        }
+        SumTree target(first.begin(), first.end());
+        SumTree source(second.begin(), second.end());
+        std::vector<Node<int, SumAggregate<int>>*> handles;
+        for(int key : first){
+            handles.push_back(target.find(key).ans());
+        }
+        ThreadPool* threads = round % 4 < 2 ? &pool : nullptr;
+        taskStatus status = kind == 0 ? treeUnion(target, source, threads)
+                          : kind == 1 ? treeIntersection(target, source, threads)
+                          : treeDifference(target, source, threads);
+        CHECK(status == taskStatus::SUCCESS);
+        CHECK(source.getSize() == 0 && source.getRoot() == nullptr);
+        std::set<int> result(expected.begin(), expected.end());
+        checkTree(name, target, result);
+        auto sum = target.aggregateRank(0, target.getSize());
+        CHECK(sum.status() == taskStatus::SUCCESS && sum.ans() == std::accumulate(expected.begin(), expected.end(), 0));
+        size_t i = 0;
+        for(int key : first){
+            CHECK(result.count(key) == 0 || target.find(key).ans() == handles[i]);
+            i++;
+        }
+        // the nodes of source that were kept still come from its pool, which target keeps alive.
+        source.insert(-1);
+        CHECK(treeUnion(target, source, threads) == taskStatus::SUCCESS);
+        result.insert(-1);
+        checkTree(name, target, result);
+    }
+    SumTree tree;
+    tree.insert(1);
+    CHECK(treeUnion(tree, tree, &pool) == taskStatus::INVALID_INPUT);
+    CHECK(tree.getSize() == 1);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    ThreadPool pool(4);
+    checkSetOperations(random, pool);
+    return report();
+}
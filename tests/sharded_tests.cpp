@@ -0,0 +1,48 @@
+/*
+this file checks ShardedTree against std::set from one thread with few shards, so that the hot shards are cut and
+the cold ones merged again and again, then with four writers and two readers at the same time, and that no shard
+keeps more than poolLimit pools alive after all the cuts and merges.
+
+build: g++ -O2 -std=c++17 -pthread -I.. sharded_tests.cpp -o sharded_tests
+*/
+
+#include "check.h"
+
+#include "AVLSharded.h"
+
+void checkSharded(std::mt19937& random){
+    const char* name = "ShardedTree";
+    ShardedTree<int> tree(16, 64);
+    checkOrderedSet(name, tree, [](int key){return key;}, 30000, 3000, random);
+    CHECK(tree.getShardCount() > 1);
+    CHECK(tree.countPools() <= 8);
+
+    // 4 shards at most and a moving hot range: the shards are merged to make room for the cuts.
+    ShardedTree<int> few(4, 64);
+    std::set<int> reference;
+    for(int round = 0; round < 40; round++){
+        int base = (round % 10) * 1000;
+        for(int i = 0; i < 2000; i++){
+            int key = base + static_cast<int>(random() % 1000);
+            if(random() % 3 == 0){
+                CHECK((few.remove(key) == taskStatus::SUCCESS) == (reference.erase(key) == 1));
+            }
+            else{
+                CHECK((few.insert(key) == taskStatus::SUCCESS) == reference.insert(key).second);
+            }
+        }
+        CHECK(few.getShardCount() <= 4);
+        CHECK(few.countPools() <= 8);
+    }
+    checkContent(name, few, reference, [](int key){return key;});
+
+    ShardedTree<int> threads(16, 64);
+    checkReaders(name, threads, 4);
+    CHECK(threads.countPools() <= 8);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkSharded(random);
+    return report();
+}
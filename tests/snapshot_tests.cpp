@@ -0,0 +1,159 @@
+/*
+this file checks save and load against std::set: a tree comes back with the same keys, shape and aggregates, and a
+file that was cut short or changed by hand is turned down with INVALID_INPUT and leaves the tree empty. then the same
+files through MappedTree, where mmap is there.
+
+build: g++ -O2 -std=c++17 -I.. snapshot_tests.cpp -o snapshot_tests
+*/
+
+#include "check.h"
+
+#include "AVLMapped.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+typedef Tree<int, std::less<int>, SumAggregate<int>> SumTree;
+
+static const char* path = "snapshot_tests.avl";
+static const char* brokenPath = "snapshot_tests_broken.avl";
+
+static std::vector<char> readFile(const char* file){
+    std::ifstream stream(file, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const char* file, const std::vector<char>& bytes){
+    std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+    stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// the file with the 32 bit field at field of node changed to value (the fields of a node are 4 bytes each here).
+static void writeChanged(const std::vector<char>& bytes, int node, int field, std::uint32_t value){
+    std::vector<char> changed = bytes;
+    std::memcpy(changed.data() + sizeof(SnapshotHeader) + node * sizeof(SnapshotNode<int>) + field * 4, &value, 4);
+    writeFile(brokenPath, changed);
+}
+
+void checkSnapshot(std::mt19937& random){
+    const char* name = "snapshot";
+    SumTree tree;
+    std::set<int> reference;
+    for(int i = 0; i < 20000; i++){
+        int key = static_cast<int>(random() % 100000);
+        tree.insert(key);
+        reference.insert(key);
+    }
+    CHECK(tree.save(path) == taskStatus::SUCCESS);
+    SumTree loaded;
+    loaded.insert(-5); // load replaces what was there
+    CHECK(loaded.load(path) == taskStatus::SUCCESS);
+    checkTree(name, loaded, reference);
+    CHECK(loaded.aggregateRank(0, loaded.getSize()).ans() == std::accumulate(reference.begin(), reference.end(), 0));
+    // the loaded tree is a tree like any other.
+    loaded.insert(-5);
+    loaded.remove(*reference.begin());
+    reference.insert(-5);
+    reference.erase(std::next(reference.begin()));
+    checkTree(name, loaded, reference);
+    CHECK(loaded.save(path) == taskStatus::SUCCESS);
+    Tree<int> plain;
+    CHECK(plain.load(path) == taskStatus::SUCCESS);
+    checkTree(name, plain, reference);
+
+    // a snapshot of another key type, a missing file, and an empty tree.
+    Tree<long long> wider;
+    CHECK(wider.load(path) == taskStatus::INVALID_INPUT && wider.getSize() == 0);
+    CHECK(plain.load("snapshot_tests_missing.avl") == taskStatus::FAILURE);
+    Tree<int> empty;
+    CHECK(empty.save(brokenPath) == taskStatus::SUCCESS);
+    CHECK(plain.load(brokenPath) == taskStatus::SUCCESS && plain.getSize() == 0 && plain.getRoot() == nullptr);
+
+    // broken files: the magic, a cut, a child out of order, a height and a count that do not fit the children.
+    const std::vector<char> bytes = readFile(path);
+    const int count = static_cast<int>(reference.size());
+    std::vector<char> changed = bytes;
+    changed[0] = 'X';
+    writeFile(brokenPath, changed);
+    CHECK(plain.load(path) == taskStatus::SUCCESS);
+    CHECK(plain.load(brokenPath) == taskStatus::INVALID_INPUT && plain.getSize() == 0);
+    writeFile(brokenPath, std::vector<char>(bytes.begin(), bytes.end() - sizeof(SnapshotNode<int>)));
+    CHECK(plain.load(brokenPath) == taskStatus::INVALID_INPUT && plain.getSize() == 0);
+    writeChanged(bytes, 0, 1, 0); // the root is its own left child
+    CHECK(plain.load(brokenPath) == taskStatus::INVALID_INPUT && plain.getSize() == 0);
+    writeChanged(bytes, 0, 2, static_cast<std::uint32_t>(count)); // a right child past the end
+    CHECK(plain.load(brokenPath) == taskStatus::INVALID_INPUT && plain.getSize() == 0);
+    writeChanged(bytes, 1, 3, 40);
+    CHECK(plain.load(brokenPath) == taskStatus::INVALID_INPUT && plain.getSize() == 0);
+    writeChanged(bytes, 2, 4, 3);
+    CHECK(plain.load(brokenPath) == taskStatus::INVALID_INPUT && plain.getSize() == 0);
+    CHECK(plain.insert(7).status() == taskStatus::SUCCESS && plain.getSize() == 1);
+}
+
+// MappedTree answers from the file like the tree that saved it, and a child index that points back stops a walk
+// with INVALID_INPUT. without mmap, open fails.
+void checkMapped(std::mt19937& random){
+    const char* name = "MappedTree";
+    Tree<int> tree;
+    std::set<int> reference;
+    for(int i = 0; i < 20000; i++){
+        int key = static_cast<int>(random() % 100000);
+        tree.insert(key);
+        reference.insert(key);
+    }
+    CHECK(tree.save(path) == taskStatus::SUCCESS);
+    MappedTree<int> mapped;
+#if AVL_HAS_MMAP
+    CHECK(mapped.open(path) == taskStatus::SUCCESS);
+    CHECK(mapped.getSize() == static_cast<int>(reference.size()));
+    int rank = 0;
+    for(int key : reference){
+        auto kth = mapped.findKthElement(rank);
+        CHECK(kth.status() == taskStatus::SUCCESS && *kth.ans() == key);
+        CHECK(mapped.rank(key).ans() == rank);
+        rank++;
+    }
+    for(int i = 0; i < 2000; i++){
+        int key = static_cast<int>(random() % 100000);
+        auto found = mapped.find(key);
+        CHECK((found.status() == taskStatus::SUCCESS) == (reference.count(key) == 1));
+        CHECK(found.status() != taskStatus::SUCCESS || *found.ans() == key);
+    }
+    CHECK(mapped.findKthElement(rank).status() == taskStatus::INVALID_INPUT);
+    CHECK(mapped.findKthElement(-1).status() == taskStatus::INVALID_INPUT);
+
+    const std::vector<char> bytes = readFile(path);
+    writeChanged(bytes, 1, 1, 0); // the left child of node 1 is the root
+    MappedTree<int> broken;
+    CHECK(broken.open(brokenPath) == taskStatus::SUCCESS);
+    const int leftOfRoot = tree.getRoot()->getLeft()->getData();
+    int below = *std::prev(reference.find(leftOfRoot));
+    CHECK(broken.find(below).status() == taskStatus::INVALID_INPUT);
+    CHECK(broken.rank(leftOfRoot).status() == taskStatus::INVALID_INPUT);
+    CHECK(broken.findKthElement(0).status() == taskStatus::INVALID_INPUT);
+    broken.close();
+    CHECK(broken.getSize() == 0 && broken.find(1).status() == taskStatus::FAILURE);
+
+    writeFile(brokenPath, std::vector<char>(bytes.begin(), bytes.end() - 1));
+    CHECK(broken.open(brokenPath) == taskStatus::INVALID_INPUT);
+    writeFile(brokenPath, std::vector<char>(bytes.begin(), bytes.begin() + 10));
+    CHECK(broken.open(brokenPath) == taskStatus::INVALID_INPUT);
+    CHECK(broken.open("snapshot_tests_missing.avl") == taskStatus::FAILURE);
+    MappedTree<long long> wider;
+    CHECK(wider.open(path) == taskStatus::INVALID_INPUT);
+#else
+    CHECK(mapped.open(path) == taskStatus::FAILURE);
+#endif
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkSnapshot(random);
+    checkMapped(random);
+    std::remove(path);
+    std::remove(brokenPath);
+    return report();
+}
@@ -0,0 +1,162 @@
+/*
+this file checks stats and CountingInstrumentation on trees of a known shape: the rotation of each of the four
+cases, the histograms of a perfect tree, the depths of the searches, the nodes taken from and given back to the pool,
+and that every call to the comparator is counted, in the batches and in a set operation on a ThreadPool too.
+
+build: g++ -O2 -std=c++17 -pthread -I.. stats_tests.cpp -o stats_tests
+*/
+
+#include "check.h"
+
+#include "AVLSetOperations.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+// a comparator that counts its calls, from any thread.
+struct AtomicLess{
+    std::atomic<long>* calls_m;
+    bool operator()(int left, int right) const {calls_m->fetch_add(1, std::memory_order_relaxed); return left < right;}
+};
+
+typedef Tree<int, AtomicLess, NoAggregate<int>, CountingInstrumentation> CountingTree;
+
+static std::uint64_t rotations(const TreeStats& stats){
+    return stats.llRotations_m + stats.rrRotations_m + stats.lrRotations_m + stats.rlRotations_m;
+}
+
+// three keys in each of the four orders that need a rotation, each makes exactly that rotation.
+void checkRotations(){
+    const char* name = "stats rotations";
+    const int orders[4][3] = {{3, 2, 1}, {1, 2, 3}, {3, 1, 2}, {1, 3, 2}};
+    for(int kind = 0; kind < 4; kind++){
+        std::atomic<long> calls(0);
+        CountingTree tree(AtomicLess{&calls});
+        for(int key : orders[kind]){
+            tree.insert(key);
+        }
+        TreeStats stats = tree.stats();
+        const std::uint64_t expected[4] = {stats.llRotations_m, stats.rrRotations_m, stats.lrRotations_m, stats.rlRotations_m};
+        CHECK(expected[kind] == 1 && rotations(stats) == 1);
+        CHECK(stats.size_m == 3 && stats.height_m == 2 && stats.allocations_m == 3 && stats.deallocations_m == 0);
+        CHECK(stats.descents_m == 3 && stats.maxDescent_m == 2);
+        CHECK(stats.comparisons_m == static_cast<std::uint64_t>(calls.load()));
+    }
+}
+
+// assign of 1..7 builds the perfect tree of height 3, so every depth and every subtree size is known.
+void checkPerfectTree(){
+    const char* name = "stats perfect tree";
+    std::atomic<long> calls(0);
+    CountingTree tree(AtomicLess{&calls});
+    std::vector<int> keys(7);
+    std::iota(keys.begin(), keys.end(), 1);
+    CHECK(tree.assign(keys.begin(), keys.end()) == taskStatus::SUCCESS);
+    TreeStats stats = tree.stats(true);
+    CHECK(stats.size_m == 7 && stats.height_m == 3 && stats.allocations_m == 7 && rotations(stats) == 0 && stats.descents_m == 0);
+    CHECK(stats.depthHistogram_m == std::vector<int>({1, 2, 4}));
+    CHECK(stats.sizeHistogram_m == std::vector<int>({4, 2, 1})); // 4 leaves, 2 subtrees of 3, the whole tree of 7
+    CHECK(tree.stats().depthHistogram_m.empty() && tree.stats().sizeHistogram_m.empty());
+
+    // a search goes to the bottom of the tree with one comparison per node, and one more for the last node that was
+    // not smaller than the key. 8 is bigger than every node, so it has no such node and takes 3.
+    tree.resetStats();
+    calls = 0;
+    for(int key = 0; key <= 8; key++){
+        CHECK((tree.find(key).status() == taskStatus::SUCCESS) == (key >= 1 && key <= 7));
+    }
+    stats = tree.stats();
+    CHECK(stats.descents_m == 9 && stats.descentSteps_m == 27 && stats.maxDescent_m == 3);
+    CHECK(stats.comparisons_m == 35 && calls.load() == 35);
+    CHECK(stats.allocations_m == 0 && stats.rebalanceWalks_m == 0);
+
+    // the comparisons of the batches, which split the batch with a binary search, are counted too.
+    tree.resetStats();
+    calls = 0;
+    std::vector<int> batch = {0, 4, 8, 9};
+    CHECK(tree.insertBatch(batch.begin(), batch.end()) == taskStatus::SUCCESS);
+    stats = tree.stats();
+    CHECK(stats.allocations_m == 3 && stats.size_m == 10 && stats.comparisons_m > 0);
+    CHECK(stats.comparisons_m == static_cast<std::uint64_t>(calls.load()));
+    tree.resetStats();
+    calls = 0;
+    CHECK(tree.eraseBatch(batch.begin(), batch.end()) == taskStatus::SUCCESS);
+    stats = tree.stats();
+    CHECK(stats.deallocations_m == 4 && stats.size_m == 6 && stats.comparisons_m > 0);
+    CHECK(stats.comparisons_m == static_cast<std::uint64_t>(calls.load()));
+
+    tree.resetStats();
+    CHECK(tree.remove(1) == taskStatus::SUCCESS);
+    stats = tree.stats();
+    CHECK(stats.deallocations_m == 1 && stats.descents_m == 1 && stats.rebalanceWalks_m >= 1 && stats.maxRebalanceWalk_m >= 1);
+    tree.resetStats();
+    tree.clear();
+    stats = tree.stats(true);
+    CHECK(stats.deallocations_m == 5 && stats.size_m == 0 && stats.height_m == 0 && stats.depthHistogram_m.empty());
+}
+
+// the histograms of a big random tree add up to its size, and a tree without instrumentation has the shape but no counters.
+void checkHistograms(std::mt19937& random){
+    const char* name = "stats histograms";
+    Tree<int> tree;
+    std::atomic<long> calls(0);
+    CountingTree counted(AtomicLess{&calls});
+    for(int i = 0; i < 50000; i++){
+        int key = static_cast<int>(random() % 100000);
+        tree.insert(key);
+        counted.insert(key);
+        if(i % 3 == 0){
+            tree.remove(key / 2);
+            counted.remove(key / 2);
+        }
+    }
+    TreeStats stats = tree.stats(true);
+    TreeStats countedStats = counted.stats(true);
+    CHECK(stats.size_m == tree.getSize() && stats.height_m == tree.getRoot()->getHeight());
+    CHECK(static_cast<int>(stats.depthHistogram_m.size()) == stats.height_m);
+    CHECK(std::accumulate(stats.depthHistogram_m.begin(), stats.depthHistogram_m.end(), 0) == stats.size_m);
+    CHECK(std::accumulate(stats.sizeHistogram_m.begin(), stats.sizeHistogram_m.end(), 0) == stats.size_m);
+    CHECK(stats.sizeHistogram_m.back() == 1 && stats.depthHistogram_m.front() == 1);
+    CHECK(stats.comparisons_m == 0 && rotations(stats) == 0 && stats.allocations_m == 0 && stats.descents_m == 0);
+    // the same keys in the same order give the same shape with or without the counters.
+    CHECK(countedStats.depthHistogram_m == stats.depthHistogram_m && countedStats.sizeHistogram_m == stats.sizeHistogram_m);
+    CHECK(countedStats.allocations_m - countedStats.deallocations_m == static_cast<std::uint64_t>(counted.getSize()));
+    CHECK(countedStats.comparisons_m == static_cast<std::uint64_t>(calls.load()));
+}
+
+// a union on a ThreadPool makes the same comparisons and rotations as without it, and counts all of them.
+void checkThreads(std::mt19937& random, ThreadPool& pool){
+    const char* name = "stats threads";
+    TreeStats results[2];
+    const std::mt19937::result_type seed = random();
+    for(int withPool = 0; withPool < 2; withPool++){
+        std::atomic<long> calls(0);
+        CountingTree target(AtomicLess{&calls});
+        CountingTree source(AtomicLess{&calls});
+        std::mt19937 keys(seed);
+        for(int i = 0; i < 40000; i++){
+            target.insert(static_cast<int>(keys() % 100000));
+            source.insert(static_cast<int>(keys() % 100000));
+        }
+        target.resetStats();
+        calls = 0;
+        CHECK(treeUnion(target, source, withPool == 1 ? &pool : nullptr) == taskStatus::SUCCESS);
+        results[withPool] = target.stats();
+        CHECK(results[withPool].comparisons_m == static_cast<std::uint64_t>(calls.load()));
+        checkShape(name, target.getRoot());
+    }
+    CHECK(results[0].comparisons_m == results[1].comparisons_m && results[0].comparisons_m > 0);
+    CHECK(rotations(results[0]) == rotations(results[1]) && results[0].deallocations_m == results[1].deallocations_m);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    ThreadPool pool(4);
+    checkRotations();
+    checkPerfectTree();
+    checkHistograms(random);
+    checkThreads(random, pool);
+    return report();
+}
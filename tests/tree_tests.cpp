@@ -0,0 +1,851 @@
+/*
+this file checks Tree against std::set: random inserts, removes and queries, the shape of the nodes after them,
+and the methods of the tree one by one, each in its own function.
+
+build: g++ -O2 -std=c++17 -I.. tree_tests.cpp -o tree_tests
+*/
+
+#include "check.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+typedef Node<int, NoAggregate<int>> IntNode;
+
+static int keyOf(const IntNode* node) {return node->getData();}
+
+// counts the objects that are alive, so we see that clear and the destructor of the tree run every destructor.
+struct Counted{
+    static int alive;
+    static int copies;
+    int key_m;
+    Counted(int key) : key_m(key) {alive++;}
+    Counted(const Counted& other) : key_m(other.key_m) {alive++; copies++;}
+    ~Counted() {alive--;}
+    bool operator<(const Counted& other) const {return key_m < other.key_m;}
+};
+int Counted::alive = 0;
+int Counted::copies = 0;
+
+// the nodes come from the pool: a node keeps its address while other nodes come and go, the slots of removed nodes
+// are reused instead of growing the pool, and clear gives every chunk back.
+void checkPool(std::mt19937& random){
+    const char* name = "pool";
+    Tree<int> tree;
+    checkOrderedSet(name, tree, keyOf, 30000, 1000, random);
+
+    const size_t empty = tree.memoryUsage();
+    std::vector<IntNode*> handles;
+    for(int key = 0; key < 1000; key++){
+        handles.push_back(tree.insert(2 * key).ans());
+    }
+    for(int i = 0; i < 20000; i++){
+        int key = 2 * static_cast<int>(random() % 1000) + 1;
+        if(random() % 2 == 0){
+            tree.insert(key);
+        }
+        else{
+            tree.remove(key);
+        }
+    }
+    for(int key = 0; key < 1000; key++){
+        CHECK(handles[key]->getData() == 2 * key && tree.find(2 * key).ans() == handles[key]);
+    }
+
+    for(int key = 1; key < 2000; key += 2){
+        tree.remove(key);
+    }
+    const size_t full = tree.memoryUsage();
+    for(int round = 0; round < 10; round++){
+        for(int key = 1; key < 2000; key += 2){
+            tree.insert(key);
+        }
+        for(int key = 1; key < 2000; key += 2){
+            tree.remove(key);
+        }
+        for(int key = 0; key < 2000; key += 2){
+            tree.remove(key);
+        }
+        for(int key = 0; key < 2000; key += 2){
+            tree.insert(key);
+        }
+    }
+    CHECK(tree.memoryUsage() == full);
+    tree.clear();
+    CHECK(tree.memoryUsage() == empty);
+
+    {
+        Tree<Counted> counted;
+        for(int i = 0; i < 5000; i++){
+            counted.insert(Counted(static_cast<int>(random() % 3000)));
+        }
+        counted.clear();
+        CHECK(Counted::alive == 0);
+        for(int i = 0; i < 5000; i++){
+            counted.insert(Counted(static_cast<int>(random() % 3000)));
+            counted.remove(Counted(static_cast<int>(random() % 3000)));
+        }
+    }
+    CHECK(Counted::alive == 0);
+}
+
+// assign builds a balanced tree of the smallest height, with the nodes in order in memory, and rejects a range that is
+// not strictly increasing.
+void checkAssign(std::mt19937& random){
+    const char* name = "assign";
+    for(int size = 0; size < 300; size++){
+        std::set<int> reference;
+        while(static_cast<int>(reference.size()) < size){
+            reference.insert(static_cast<int>(random() % 100000));
+        }
+        std::vector<int> keys(reference.begin(), reference.end());
+        Tree<int> tree(keys.begin(), keys.end());
+        checkTree(name, tree, reference);
+        checkContent(name, tree, reference, keyOf);
+        int height = 0;
+        while((1 << height) <= size){
+            height++;
+        }
+        CHECK((size == 0 ? 0 : tree.getRoot()->getHeight()) == height);
+        for(int k = 0; k < size; k++){
+            CHECK(tree.findKthElement(k).ans() == tree.findKthElement(0).ans() + k);
+        }
+        if(size > 1){
+            std::vector<int> unsorted = keys;
+            std::swap(unsorted[random() % size], unsorted.back());
+            unsorted.back() = unsorted.front();
+            CHECK(tree.assign(unsorted.begin(), unsorted.end()) == taskStatus::INVALID_INPUT);
+            CHECK(tree.getSize() == 0 && tree.getRoot() == nullptr);
+            CHECK(tree.assign(keys.begin(), keys.end()) == taskStatus::SUCCESS);
+            checkTree(name, tree, reference);
+        }
+    }
+}
+
+// sorted batches of new and old keys, inserted or erased, with a status and a handle for each key.
+// the pool must not grow when the batches are small and the tree keeps its size.
+void checkBatches(std::mt19937& random){
+    const char* name = "batches";
+    Tree<int> tree;
+    std::set<int> reference;
+    std::uniform_int_distribution<int> keys(0, 3999);
+    for(int round = 0; round < 500; round++){
+        std::set<int> batch;
+        for(int i = static_cast<int>(random() % 200); i > 0; i--){
+            batch.insert(keys(random));
+        }
+        std::vector<int> sorted(batch.begin(), batch.end());
+        std::vector<IntNode*> handles(sorted.size());
+        std::vector<taskStatus> statuses(sorted.size());
+        if(random() % 2 == 0){
+            CHECK(tree.insertBatch(sorted.begin(), sorted.end(), handles.data(), statuses.data()) == taskStatus::SUCCESS);
+            for(size_t i = 0; i < sorted.size(); i++){
+                bool added = reference.insert(sorted[i]).second;
+                CHECK((statuses[i] == taskStatus::SUCCESS) == added);
+                CHECK(handles[i] != nullptr && handles[i]->getData() == sorted[i] && tree.find(sorted[i]).ans() == handles[i]);
+            }
+        }
+        else{
+            CHECK(tree.eraseBatch(sorted.begin(), sorted.end(), statuses.data()) == taskStatus::SUCCESS);
+            for(size_t i = 0; i < sorted.size(); i++){
+                bool removed = reference.erase(sorted[i]) == 1;
+                CHECK((statuses[i] == taskStatus::SUCCESS) == removed);
+            }
+        }
+        checkTree(name, tree, reference);
+    }
+    std::vector<int> unsorted = {1, 3, 2};
+    CHECK(tree.insertBatch(unsorted.begin(), unsorted.end()) == taskStatus::INVALID_INPUT);
+    CHECK(tree.eraseBatch(unsorted.begin(), unsorted.end()) == taskStatus::INVALID_INPUT);
+    checkTree(name, tree, reference);
+
+    // thousands of small batches, of new keys that are erased right after and of keys that are already there.
+    tree.clear();
+    for(int key = 0; key < 10000; key++){
+        tree.insert(2 * key);
+    }
+    const size_t before = tree.memoryUsage();
+    for(int round = 0; round < 9000; round++){
+        std::vector<int> batch;
+        for(int key = 2 * static_cast<int>(random() % 9900) + 1; batch.size() < 50; key += 2){
+            batch.push_back(key);
+        }
+        tree.insertBatch(batch.begin(), batch.end());
+        tree.eraseBatch(batch.begin(), batch.end());
+        for(int& key : batch){
+            key--;
+        }
+        tree.insertBatch(batch.begin(), batch.end());
+    }
+    CHECK(tree.getSize() == 10000);
+    CHECK(tree.memoryUsage() <= before + before / 10);
+
+    // batches bigger than a chunk, half of their keys are already in the tree. a plain insert of the same keys
+    // takes about as much memory.
+    tree.clear();
+    Tree<int> plain;
+    for(int round = 0; round < 20; round++){
+        std::vector<int> batch;
+        for(int key = 0; key < 40000; key++){
+            batch.push_back(20000 * round + key);
+        }
+        tree.insertBatch(batch.begin(), batch.end());
+    }
+    for(int key = 0; key < tree.getSize(); key++){
+        plain.insert(key);
+    }
+    CHECK(tree.getSize() == 20000 * 21);
+    CHECK(tree.memoryUsage() <= plain.memoryUsage() + plain.memoryUsage() / 10);
+}
+
+// split at random keys and join back, the handles stay valid through both. a tree joined from another one keeps its
+// nodes alive after the other tree is gone, and keys that overlap are not joined.
+void checkSplitJoin(std::mt19937& random){
+    const char* name = "split and join";
+    Tree<int> tree;
+    std::set<int> reference;
+    std::uniform_int_distribution<int> keys(0, 3999);
+    for(int round = 0; round < 300; round++){
+        for(int i = 0; i < 30; i++){
+            int key = keys(random);
+            CHECK((tree.insert(key).status() == taskStatus::SUCCESS) == reference.insert(key).second);
+        }
+        int key = round % 10 == 0 ? -1 : round % 10 == 1 ? 4000 : keys(random);
+        std::vector<IntNode*> handles;
+        for(int k : reference){
+            handles.push_back(tree.find(k).ans());
+        }
+        Tree<int> right;
+        CHECK(tree.split(key, right) == taskStatus::SUCCESS);
+        std::set<int> lower(reference.begin(), reference.lower_bound(key));
+        std::set<int> upper(reference.lower_bound(key), reference.end());
+        checkTree(name, tree, lower);
+        checkTree(name, right, upper);
+        checkContent(name, right, upper, keyOf);
+        if(!lower.empty() && !upper.empty()){
+            CHECK(right.join(tree) == taskStatus::INVALID_INPUT);
+            CHECK(tree.getSize() == static_cast<int>(lower.size()) && right.getSize() == static_cast<int>(upper.size()));
+        }
+        CHECK(tree.join(right) == taskStatus::SUCCESS);
+        CHECK(right.getSize() == 0 && right.getRoot() == nullptr);
+        checkTree(name, tree, reference);
+        size_t i = 0;
+        for(int k : reference){
+            CHECK(handles[i] == tree.find(k).ans() && handles[i]->getData() == k);
+            i++;
+        }
+    }
+    CHECK(tree.join(tree) == taskStatus::INVALID_INPUT);
+
+    // the nodes of other come from the pool of other, that lives on in tree.
+    std::vector<IntNode*> handles;
+    {
+        Tree<int> other;
+        for(int key = 5000; key < 6000; key++){
+            handles.push_back(other.insert(key).ans());
+            reference.insert(key);
+        }
+        CHECK(tree.join(other) == taskStatus::SUCCESS);
+    }
+    checkTree(name, tree, reference);
+    for(int key = 5000; key < 6000; key++){
+        CHECK(tree.find(key).ans() == handles[key - 5000]);
+        CHECK(tree.rank(handles[key - 5000]).ans() == static_cast<int>(std::distance(reference.begin(), reference.find(key))));
+    }
+
+    // expiring the oldest keys: split off a prefix and drop it.
+    while(tree.getSize() > 0){
+        int key = *reference.begin() + 500;
+        Tree<int> rest;
+        CHECK(tree.split(key, rest) == taskStatus::SUCCESS);
+        tree.clear();
+        CHECK(tree.join(rest) == taskStatus::SUCCESS);
+        reference.erase(reference.begin(), reference.lower_bound(key));
+        checkTree(name, tree, reference);
+    }
+}
+
+// rank of every key in and out of the tree, and of every handle, is the index of the key in the std::set.
+// Counted has no operator<=>, so it takes the path of the descent with two comparisons.
+template<class Key>
+void checkRankOf(const char* name, std::mt19937& random){
+    Tree<Key> tree;
+    std::set<int> reference;
+    for(int round = 0; round < 20; round++){
+        for(int i = 0; i < 200; i++){
+            int key = static_cast<int>(random() % 1000);
+            if(random() % 3 == 0){
+                tree.remove(Key(key));
+                reference.erase(key);
+            }
+            else{
+                tree.insert(Key(key));
+                reference.insert(key);
+            }
+        }
+        for(int key = -1; key <= 1000; key++){
+            auto rank = tree.rank(Key(key));
+            auto found = reference.find(key);
+            CHECK((rank.status() == taskStatus::SUCCESS) == (found != reference.end()));
+            if(found != reference.end()){
+                int index = static_cast<int>(std::distance(reference.begin(), found));
+                Node<Key, NoAggregate<Key>>* node = tree.find(Key(key)).ans();
+                CHECK(rank.ans() == index && tree.rank(node).ans() == index);
+                CHECK(tree.findKthElement(index).ans() == node);
+            }
+        }
+    }
+    CHECK(tree.rank(nullptr).status() == taskStatus::INVALID_INPUT);
+}
+
+void checkRank(std::mt19937& random){
+    checkRankOf<int>("rank", random);
+    checkRankOf<Counted>("rank of Counted", random);
+}
+
+// lowerBound, upperBound, countRange and visitRange of random ranges, against the bounds of std::set.
+void checkBounds(std::mt19937& random){
+    const char* name = "bounds";
+    Tree<int> tree;
+    std::set<int> reference;
+    std::uniform_int_distribution<int> keys(-10, 2010);
+    for(int round = 0; round < 50; round++){
+        for(int i = 0; i < 100; i++){
+            int key = 2 * static_cast<int>(random() % 1000);
+            if(random() % 3 == 0){
+                tree.remove(key);
+                reference.erase(key);
+            }
+            else{
+                tree.insert(key);
+                reference.insert(key);
+            }
+        }
+        for(int i = 0; i < 200; i++){
+            int low = keys(random);
+            int high = i % 10 == 0 ? low : keys(random);
+            auto lower = tree.lowerBound(low);
+            auto upper = tree.upperBound(low);
+            auto expectedLower = reference.lower_bound(low);
+            auto expectedUpper = reference.upper_bound(low);
+            CHECK((lower.status() == taskStatus::SUCCESS) == (expectedLower != reference.end()));
+            CHECK(lower.status() != taskStatus::SUCCESS || lower.ans()->getData() == *expectedLower);
+            CHECK((upper.status() == taskStatus::SUCCESS) == (expectedUpper != reference.end()));
+            CHECK(upper.status() != taskStatus::SUCCESS || upper.ans()->getData() == *expectedUpper);
+            std::vector<int> expected;
+            if(low < high){
+                expected.assign(reference.lower_bound(low), reference.lower_bound(high));
+            }
+            CHECK(tree.countRange(low, high) == static_cast<int>(expected.size()));
+            std::vector<int> visited;
+            CHECK(tree.visitRange(low, high, [&](int key){visited.push_back(key);}) == taskStatus::SUCCESS);
+            CHECK(visited == expected);
+        }
+    }
+}
+
+static void appendKey(int key, int* counter, void* array){
+    static_cast<int*>(array)[*counter] = key; // inOrder counts the keys itself
+}
+
+// the iterators both ways, with range for and <algorithm>, an iterator that stays valid while other keys come and go,
+// and the visitors: a lambda that stops early, and the function pointer of inOrderArray.
+void checkIterators(std::mt19937& random){
+    const char* name = "iterators";
+    Tree<int> tree;
+    std::set<int> reference;
+    CHECK(tree.begin() == tree.end() && tree.rbegin() == tree.rend());
+    for(int round = 0; round < 50; round++){
+        for(int i = 0; i < 100; i++){
+            int key = static_cast<int>(random() % 1000);
+            if(random() % 3 == 0){
+                tree.remove(key);
+                reference.erase(key);
+            }
+            else{
+                tree.insert(key);
+                reference.insert(key);
+            }
+        }
+        std::vector<int> forward;
+        for(int key : tree){
+            forward.push_back(key);
+        }
+        CHECK(std::equal(forward.begin(), forward.end(), reference.begin(), reference.end()));
+        CHECK(std::equal(tree.rbegin(), tree.rend(), reference.rbegin(), reference.rend()));
+        CHECK(std::distance(tree.begin(), tree.end()) == static_cast<std::ptrdiff_t>(reference.size()));
+        std::vector<int> backward;
+        for(auto it = tree.end(); it != tree.begin();){
+            --it;
+            backward.push_back(*it);
+        }
+        CHECK(std::equal(backward.begin(), backward.end(), reference.rbegin(), reference.rend()));
+        if(reference.empty()){
+            continue;
+        }
+
+        int key = *std::next(reference.begin(), random() % reference.size());
+        auto it = std::find(tree.begin(), tree.end(), key);
+        CHECK(it != tree.end() && it.getNode() == tree.find(key).ans());
+        for(int i = 0; i < 100; i++){
+            int other = static_cast<int>(random() % 1000);
+            if(other != key){
+                tree.remove(other);
+                reference.erase(other);
+            }
+        }
+        auto next = reference.upper_bound(key);
+        auto after = it;
+        ++after;
+        CHECK(*it == key && (next == reference.end() ? after == tree.end() : *after == *next));
+
+        std::vector<int> visited;
+        int limit = static_cast<int>(random() % (reference.size() + 1));
+        CHECK(tree.inOrder([&](const int& visit){
+            if(static_cast<int>(visited.size()) == limit){
+                return false;
+            }
+            visited.push_back(visit);
+            return true;
+        }) == taskStatus::SUCCESS);
+        CHECK(std::equal(visited.begin(), visited.end(), reference.begin(), std::next(reference.begin(), limit)));
+        std::vector<int> array(reference.size());
+        CHECK(tree.inOrderArray(appendKey, array.data()) == taskStatus::SUCCESS);
+        CHECK(std::equal(array.begin(), array.end(), reference.begin(), reference.end()));
+    }
+}
+
+// a hash of the keys in order, so an aggregate that combines two ranges the wrong way around is caught.
+struct OrderAggregate{
+    struct value_type{
+        unsigned long long hash_m;
+        unsigned long long power_m;
+        bool operator==(const value_type& other) const {return hash_m == other.hash_m && power_m == other.power_m;}
+    };
+    static value_type identity() {return value_type{0, 1};}
+    static value_type fromData(const int& data) {return value_type{static_cast<unsigned long long>(data), 1000003};}
+    static value_type combine(const value_type& left, const value_type& right){
+        return value_type{left.hash_m * right.power_m + right.hash_m, left.power_m * right.power_m};
+    }
+};
+
+// aggregate and aggregateRank of random ranges against a fold over the std::set, while the tree changes
+// by inserts, removes, erase, updateKey, batches, split and join, which all have to keep the aggregates.
+template<class Aggregate>
+void checkAggregateOf(const char* name, std::mt19937& random){
+    typedef Tree<int, std::less<int>, Aggregate> AggregateTree;
+    auto fold = [](auto first, auto last){
+        typename Aggregate::value_type value = Aggregate::identity();
+        for(; first != last; ++first){
+            value = Aggregate::combine(value, Aggregate::fromData(*first));
+        }
+        return value;
+    };
+    AggregateTree tree;
+    std::set<int> reference;
+    std::uniform_int_distribution<int> keys(0, 1999);
+    for(int round = 0; round < 200; round++){
+        int kind = round % 5;
+        if(kind == 0){
+            std::set<int> batch;
+            for(int i = 0; i < 50; i++){
+                batch.insert(keys(random));
+            }
+            std::vector<int> sorted(batch.begin(), batch.end());
+            if(random() % 2 == 0){
+                tree.insertBatch(sorted.begin(), sorted.end());
+                reference.insert(sorted.begin(), sorted.end());
+            }
+            else{
+                tree.eraseBatch(sorted.begin(), sorted.end());
+                for(int key : sorted){
+                    reference.erase(key);
+                }
+            }
+        }
+        else if(kind == 1 && !reference.empty()){
+            for(int i = 0; i < 20 && !reference.empty(); i++){
+                int key = *std::next(reference.begin(), random() % reference.size());
+                int to = keys(random);
+                if(reference.count(to) == 0){
+                    tree.updateKey(tree.find(key).ans(), to);
+                    reference.erase(key);
+                    reference.insert(to);
+                }
+                else{
+                    tree.erase(tree.find(key).ans());
+                    reference.erase(key);
+                }
+            }
+        }
+        else if(kind == 2){
+            AggregateTree right;
+            tree.split(keys(random), right);
+            tree.join(right);
+        }
+        else{
+            for(int i = 0; i < 50; i++){
+                int key = keys(random);
+                if(random() % 3 == 0){
+                    tree.remove(key);
+                    reference.erase(key);
+                }
+                else{
+                    tree.insert(key);
+                    reference.insert(key);
+                }
+            }
+        }
+        for(int i = 0; i < 20; i++){
+            int low = keys(random);
+            int high = keys(random);
+            auto range = tree.aggregate(low, high);
+            CHECK(range.status() == taskStatus::SUCCESS
+                  && range.ans() == (low < high ? fold(reference.lower_bound(low), reference.lower_bound(high)) : Aggregate::identity()));
+            int first = static_cast<int>(random() % (reference.size() + 1));
+            int last = first + static_cast<int>(random() % (reference.size() - first + 1));
+            auto ranks = tree.aggregateRank(first, last);
+            CHECK(ranks.status() == taskStatus::SUCCESS
+                  && ranks.ans() == fold(std::next(reference.begin(), first), std::next(reference.begin(), last)));
+        }
+        auto whole = tree.aggregateRank(0, tree.getSize());
+        CHECK(whole.ans() == fold(reference.begin(), reference.end()));
+        CHECK(tree.aggregateRank(1, 0).status() == taskStatus::INVALID_INPUT);
+        CHECK(tree.aggregateRank(0, tree.getSize() + 1).status() == taskStatus::INVALID_INPUT);
+    }
+}
+
+void checkAggregates(std::mt19937& random){
+    checkAggregateOf<SumAggregate<int>>("sum", random);
+    checkAggregateOf<MinAggregate<int>>("min", random);
+    checkAggregateOf<MaxAggregate<int>>("max", random);
+    checkAggregateOf<OrderAggregate>("order", random);
+}
+
+// the shape after every kind of insert and remove: random keys, and keys in increasing and decreasing order,
+// which rotate at every level. the height stays within the bound of an AVL tree, 1.44 log2(n + 2).
+void checkChurn(std::mt19937& random){
+    const char* name = "churn";
+    Tree<int> tree;
+    std::set<int> reference;
+    auto checkHeight = [&](){
+        int height = tree.getRoot() == nullptr ? 0 : tree.getRoot()->getHeight();
+        CHECK(height <= 1.4405 * std::log2(reference.size() + 2.0));
+    };
+    for(int i = 0; i < 40000; i++){
+        int key = static_cast<int>(random() % 3000);
+        if(random() % 2 == 0){
+            CHECK((tree.insert(key).status() == taskStatus::SUCCESS) == reference.insert(key).second);
+        }
+        else{
+            CHECK((tree.remove(key) == taskStatus::SUCCESS) == (reference.erase(key) == 1));
+        }
+        if(i % 100 == 0){
+            checkTree(name, tree, reference);
+            checkHeight();
+        }
+    }
+    checkTree(name, tree, reference);
+    tree.clear();
+    reference.clear();
+    for(int key = 0; key < 5000; key++){
+        tree.insert(key);
+        reference.insert(key);
+    }
+    checkTree(name, tree, reference);
+    checkHeight();
+    for(int key = -1; key >= -5000; key--){
+        tree.insert(key);
+        reference.insert(key);
+    }
+    checkTree(name, tree, reference);
+    checkHeight();
+    for(int key = -5000; key < 2500; key++){
+        CHECK(tree.remove(key) == taskStatus::SUCCESS);
+        reference.erase(key);
+        if(key % 250 == 0){
+            checkTree(name, tree, reference);
+            checkHeight();
+        }
+    }
+    for(int key = 4999; key >= 2500; key--){
+        CHECK(tree.remove(key) == taskStatus::SUCCESS);
+    }
+    CHECK(tree.getSize() == 0 && tree.getRoot() == nullptr);
+}
+
+// erase of held handles and updateKey to free and to taken keys, the other handles stay valid,
+// the node keeps its address when its key changes, and erase and remove copy no key.
+void checkErase(std::mt19937& random){
+    const char* name = "erase and updateKey";
+    Tree<int> tree;
+    std::set<int> reference;
+    std::uniform_int_distribution<int> keys(0, 2999);
+    for(int round = 0; round < 100; round++){
+        for(int i = 0; i < 50; i++){
+            int key = keys(random);
+            tree.insert(key);
+            reference.insert(key);
+        }
+        std::vector<IntNode*> handles;
+        for(int key : reference){
+            handles.push_back(tree.find(key).ans());
+        }
+        for(int i = 0; i < 20 && !reference.empty(); i++){
+            size_t index = random() % handles.size();
+            IntNode* node = handles[index];
+            if(node == nullptr){
+                continue;
+            }
+            int from = node->getData();
+            int to = i % 4 == 0 ? from + 1 : keys(random);
+            if(i % 2 == 0){
+                CHECK(tree.erase(node) == taskStatus::SUCCESS);
+                reference.erase(from);
+                handles[index] = nullptr;
+            }
+            else if(to == from || reference.count(to) == 0){
+                CHECK(tree.updateKey(node, to) == taskStatus::SUCCESS);
+                reference.erase(from);
+                reference.insert(to);
+                CHECK(node->getData() == to && tree.find(to).ans() == node);
+            }
+            else{
+                CHECK(tree.updateKey(node, to) == taskStatus::FAILURE);
+                CHECK(node->getData() == from && tree.find(from).ans() == node);
+            }
+        }
+        checkTree(name, tree, reference);
+        for(IntNode* node : handles){
+            CHECK(node == nullptr || tree.find(node->getData()).ans() == node);
+        }
+    }
+    CHECK(tree.erase(nullptr) == taskStatus::INVALID_INPUT);
+    CHECK(tree.updateKey(nullptr, 1) == taskStatus::INVALID_INPUT);
+
+    Tree<Counted> counted;
+    for(int key = 0; key < 1000; key++){
+        counted.emplace(key);
+    }
+    Counted::copies = 0;
+    for(int key = 0; key < 1000; key += 2){
+        CHECK(counted.erase(counted.find(Counted(key)).ans()) == taskStatus::SUCCESS);
+        CHECK(counted.remove(Counted(key + 1)) == taskStatus::SUCCESS);
+    }
+    CHECK(Counted::copies == 0 && counted.getSize() == 0);
+}
+
+// a comparator with state, that counts its calls.
+struct CountingLess{
+    int* calls_m;
+    bool operator()(int left, int right) const {(*calls_m)++; return left < right;}
+};
+
+// a tree in decreasing order, a tree of strings searched by std::string_view and by const char* through std::less<>,
+// and the number of comparisons of a search: one per node on the way down and one more at the end.
+void checkComparators(std::mt19937& random){
+    const char* name = "comparators";
+    Tree<int, std::greater<int>> decreasing;
+    std::set<int, std::greater<int>> reference;
+    for(int i = 0; i < 20000; i++){
+        int key = static_cast<int>(random() % 2000);
+        if(random() % 3 == 0){
+            CHECK((decreasing.remove(key) == taskStatus::SUCCESS) == (reference.erase(key) == 1));
+        }
+        else{
+            CHECK((decreasing.insert(key).status() == taskStatus::SUCCESS) == reference.insert(key).second);
+        }
+    }
+    CHECK(std::equal(decreasing.begin(), decreasing.end(), reference.begin(), reference.end()));
+    int rank = 0;
+    for(int key : reference){
+        CHECK(decreasing.rank(key).ans() == rank && decreasing.findKthElement(rank).ans()->getData() == key);
+        rank++;
+    }
+    auto bound = decreasing.lowerBound(1000);
+    CHECK(bound.status() != taskStatus::SUCCESS || bound.ans()->getData() == *reference.lower_bound(1000));
+
+    Tree<std::string, std::less<>> strings;
+    for(int i = 0; i < 1000; i++){
+        strings.insert("key " + std::to_string(i));
+    }
+    std::string_view view = "key 500";
+    CHECK(strings.find(view).status() == taskStatus::SUCCESS && strings.find(view).ans()->getData() == view);
+    CHECK(strings.find("key 999").status() == taskStatus::SUCCESS);
+    CHECK(strings.find("key 1000").status() == taskStatus::FAILURE);
+    CHECK(strings.rank(std::string_view("key 0")).ans() == 0);
+    CHECK(strings.lowerBound(std::string_view("key 995a")).ans()->getData() == "key 996");
+    CHECK(strings.lowerBound(std::string_view("key 9999")).status() == taskStatus::FAILURE);
+
+    int calls = 0;
+    Tree<int, CountingLess> counting(CountingLess{&calls});
+    for(int key = 0; key < 10000; key++){
+        counting.insert(static_cast<int>(random() % 100000));
+    }
+    const int height = counting.getRoot()->getHeight();
+    for(int i = 0; i < 1000; i++){
+        calls = 0;
+        counting.find(static_cast<int>(random() % 100000));
+        CHECK(calls <= height + 1);
+    }
+}
+
+// a key that can only be moved, with a payload on the heap.
+struct MoveOnly{
+    int key_m;
+    std::unique_ptr<int> payload_m;
+    explicit MoveOnly(int key) : key_m(key), payload_m(new int(key)) {}
+    MoveOnly(int key, int payload) : key_m(key), payload_m(new int(payload)) {}
+    MoveOnly(MoveOnly&&) = default;
+    MoveOnly& operator=(MoveOnly&&) = default;
+    bool operator<(const MoveOnly& other) const {return key_m < other.key_m;}
+};
+
+// counts the times it is made, so we see that a failed output makes no answer.
+struct Made{
+    static int made;
+    Made() {made++;}
+};
+int Made::made = 0;
+
+// move only keys through insert, emplace, assign, remove and updateKey, answers that are moved out of an output,
+// and outputs of failures that hold no answer at all.
+void checkMoveOnly(std::mt19937& random){
+    const char* name = "move only";
+    Tree<MoveOnly> tree;
+    std::set<int> reference;
+    for(int i = 0; i < 5000; i++){
+        int key = static_cast<int>(random() % 1000);
+        int kind = static_cast<int>(random() % 3);
+        if(kind == 0){
+            CHECK((tree.insert(MoveOnly(key)).status() == taskStatus::SUCCESS) == reference.insert(key).second);
+        }
+        else if(kind == 1){
+            auto node = tree.emplace(key, key);
+            CHECK((node.status() == taskStatus::SUCCESS) == reference.insert(key).second);
+            CHECK(node.status() != taskStatus::SUCCESS || *node.ans()->getData().payload_m == key);
+        }
+        else{
+            CHECK((tree.remove(MoveOnly(key)) == taskStatus::SUCCESS) == (reference.erase(key) == 1));
+        }
+    }
+    CHECK(std::equal(tree.begin(), tree.end(), reference.begin(), reference.end(),
+                     [](const MoveOnly& entry, int key){return entry.key_m == key && *entry.payload_m == key;}));
+    if(!reference.empty()){
+        int to = *reference.rbegin() + 1;
+        Node<MoveOnly, NoAggregate<MoveOnly>>* node = tree.findKthElement(0).ans();
+        CHECK(tree.updateKey(node, MoveOnly(to, -1)) == taskStatus::SUCCESS);
+        CHECK(node->getData().key_m == to && *node->getData().payload_m == -1 && tree.rank(node).ans() == tree.getSize() - 1);
+    }
+
+    std::vector<MoveOnly> sorted;
+    for(int key = 0; key < 1000; key++){
+        sorted.emplace_back(key);
+    }
+    CHECK(tree.assign(std::make_move_iterator(sorted.begin()), std::make_move_iterator(sorted.end())) == taskStatus::SUCCESS);
+    CHECK(tree.getSize() == 1000 && sorted[0].payload_m == nullptr);
+    CHECK(*tree.findKthElement(999).ans()->getData().payload_m == 999);
+
+    tupleOutput<MoveOnly> moved(MoveOnly(7));
+    MoveOnly answer = std::move(moved).ans();
+    CHECK(answer.key_m == 7 && *answer.payload_m == 7);
+    tupleOutput<MoveOnly> failed(taskStatus::FAILURE);
+    CHECK(failed.status() == taskStatus::FAILURE);
+    tupleOutput<Made> nothing(taskStatus::INVALID_INPUT);
+    CHECK(nothing.status() == taskStatus::INVALID_INPUT && Made::made == 0);
+    tupleOutput<Made> something;
+    CHECK(something.status() == taskStatus::SUCCESS && Made::made == 1);
+
+    Tree<Counted> counted;
+    Counted::copies = 0;
+    for(int key = 0; key < 1000; key++){
+        counted.emplace(key);
+    }
+    CHECK(Counted::copies == 0 && counted.getSize() == 1000);
+}
+
+// findMany and selectMany against find and findKthElement: keys in any order, with repeats and keys that are not in
+// the tree, more keys than lanes and fewer, ranks out of the tree (some only out of the range of an int), and one
+// comparison per node with a comparator that is not three way.
+void checkLookups(std::mt19937& random){
+    const char* name = "lookups";
+    Tree<int> tree;
+    std::set<int> reference;
+    for(int i = 0; i < 20000; i++){
+        int key = static_cast<int>(random() % 60000);
+        tree.insert(key);
+        reference.insert(key);
+    }
+    for(int count : {0, 1, 5, 16, 17, 1000}){
+        std::vector<int> keys(count);
+        for(int& key : keys){
+            key = static_cast<int>(random() % 61000) - 500;
+        }
+        std::vector<IntNode*> handles(count, nullptr);
+        CHECK(tree.findMany(keys.begin(), keys.end(), handles.data()) == taskStatus::SUCCESS);
+        for(int i = 0; i < count; i++){
+            CHECK(handles[i] == (reference.count(keys[i]) == 1 ? tree.find(keys[i]).ans() : nullptr));
+        }
+        std::vector<long long> ranks(count);
+        for(long long& rank : ranks){
+            rank = static_cast<long long>(random() % (reference.size() + 100)) - 50;
+        }
+        CHECK(tree.selectMany(ranks.begin(), ranks.end(), handles.data()) == taskStatus::SUCCESS);
+        for(int i = 0; i < count; i++){
+            bool inside = ranks[i] >= 0 && ranks[i] < static_cast<long long>(reference.size());
+            CHECK(handles[i] == (inside ? tree.findKthElement(static_cast<int>(ranks[i])).ans() : nullptr));
+        }
+    }
+    // 1 << 32 would be rank 0 if it were cast to an int first.
+    std::vector<long long> far = {1LL << 40, 1LL << 32, -(1LL << 32), static_cast<long long>(reference.size()), 0};
+    std::vector<IntNode*> handles(far.size(), nullptr);
+    CHECK(tree.selectMany(far.begin(), far.end(), handles.data()) == taskStatus::SUCCESS);
+    CHECK(handles[0] == nullptr && handles[1] == nullptr && handles[2] == nullptr && handles[3] == nullptr);
+    CHECK(handles[4] != nullptr && handles[4]->getData() == *reference.begin());
+    std::vector<int> some = {1, 2};
+    CHECK(tree.findMany(some.begin(), some.end(), nullptr) == taskStatus::INVALID_INPUT);
+    CHECK(tree.selectMany(some.begin(), some.end(), nullptr) == taskStatus::INVALID_INPUT);
+    Tree<int> empty;
+    handles.assign(some.size(), tree.getRoot());
+    CHECK(empty.findMany(some.begin(), some.end(), handles.data()) == taskStatus::SUCCESS);
+    CHECK(empty.selectMany(some.begin(), some.end(), handles.data()) == taskStatus::SUCCESS);
+    CHECK(handles[0] == nullptr && handles[1] == nullptr);
+
+    int calls = 0;
+    Tree<int, CountingLess> counting(CountingLess{&calls});
+    for(int key : reference){
+        counting.insert(key);
+    }
+    std::vector<int> keys(500);
+    for(int& key : keys){
+        key = static_cast<int>(random() % 60000);
+    }
+    std::vector<IntNode*> found(keys.size());
+    calls = 0;
+    CHECK(counting.findMany(keys.begin(), keys.end(), found.data()) == taskStatus::SUCCESS);
+    CHECK(calls <= static_cast<int>(keys.size()) * (counting.getRoot()->getHeight() + 1));
+    for(size_t i = 0; i < keys.size(); i++){
+        CHECK((found[i] != nullptr) == (reference.count(keys[i]) == 1) && (found[i] == nullptr || found[i]->getData() == keys[i]));
+    }
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkPool(random);
+    checkAssign(random);
+    checkBatches(random);
+    checkSplitJoin(random);
+    checkRank(random);
+    checkBounds(random);
+    checkIterators(random);
+    checkAggregates(random);
+    checkChurn(random);
+    checkErase(random);
+    checkComparators(random);
+    checkMoveOnly(random);
+    checkLookups(random);
+    return report();
+}
@@ -0,0 +1,159 @@
+/*
+this file checks WideTree against std::set, with and without handles, for nodes of 8 and 16 keys: random churn, then
+trees that grow to a few levels and shrink back to nothing, which go through the splits, the merges and the sharing
+of keys between neighbours at every level, and the root giving its place to its only child.
+
+build: g++ -O2 -std=c++17 -I.. wide_tests.cpp -o wide_tests
+*/
+
+#include "check.h"
+
+#include "AVLWide.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// the height of a tree of size keys is between the height of full nodes and the height of half full nodes.
+template<class WideType>
+void checkHeight(const char* name, const WideType& tree, int width){
+    int size = tree.getSize();
+    int lowest = 1;
+    for(long long full = width; full < size; full *= width){
+        lowest++;
+    }
+    int highest = 1;
+    for(long long half = 2; half * (width / 2) <= size; half *= width / 2){
+        highest++;
+    }
+    CHECK(size == 0 ? tree.getHeight() == 0 : tree.getHeight() >= lowest && tree.getHeight() <= highest);
+}
+
+// keys come in sorted, backwards or shuffled, and leave in another of these orders, with the content checked on the
+// way. removing in order empties the leftmost leaves first, so they merge with and borrow from their right neighbour,
+// and backwards the other way around.
+template<class WideType, class KeyOf>
+void checkGrowAndShrink(const char* name, WideType& tree, KeyOf keyOf, int width, std::mt19937& random){
+    const int size = 20000;
+    std::vector<int> keys(size);
+    for(int i = 0; i < size; i++){
+        keys[i] = 3 * i;
+    }
+    for(int round = 0; round < 9; round++){
+        std::vector<int> in = keys;
+        std::vector<int> out = keys;
+        if(round % 3 == 1){
+            std::reverse(in.begin(), in.end());
+        }
+        else if(round % 3 == 2){
+            std::shuffle(in.begin(), in.end(), random);
+        }
+        if(round / 3 == 1){
+            std::reverse(out.begin(), out.end());
+        }
+        else if(round / 3 == 2){
+            std::shuffle(out.begin(), out.end(), random);
+        }
+        std::set<int> reference;
+        for(int key : in){
+            CHECK(tree.insert(key).status() == taskStatus::SUCCESS);
+            reference.insert(key);
+            if(reference.size() % 2500 == 0){
+                checkHeight(name, tree, width);
+            }
+        }
+        CHECK(tree.getHeight() >= 4);
+        checkContent(name, tree, reference, keyOf);
+        for(int key : out){
+            CHECK(tree.remove(key) == taskStatus::SUCCESS);
+            reference.erase(key);
+            if(reference.size() % 2500 == 0 || reference.size() < 40){
+                checkHeight(name, tree, width);
+                checkContent(name, tree, reference, keyOf);
+            }
+        }
+        CHECK(tree.getSize() == 0 && tree.getHeight() == 0);
+        CHECK(tree.find(0).status() == taskStatus::FAILURE && tree.remove(0) == taskStatus::FAILURE);
+    }
+}
+
+template<class WideType, class KeyOf>
+void checkWide(const char* name, int width, KeyOf keyOf, std::mt19937& random){
+    WideType tree;
+    checkOrderedSet(name, tree, keyOf, 30000, 1000, random);
+    checkOrderedSet(name, tree, keyOf, 60000, 20000, random);
+    checkGrowAndShrink(name, tree, keyOf, width, random);
+}
+
+// a handle stays on its key while the other keys come and go and the leaves split, merge and share their keys.
+template<int Width>
+void checkHandles(std::mt19937& random){
+    const char* name = "WideTree handles";
+    WideTree<int, Width, true> tree;
+    std::vector<int> keys(20000);
+    for(int i = 0; i < static_cast<int>(keys.size()); i++){
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), random);
+    std::vector<const WideEntry<int>*> handles;
+    for(int key : keys){
+        handles.push_back(tree.insert(key).ans());
+    }
+    for(int round = 0; round < 10; round++){
+        for(size_t i = round % 2; i < keys.size(); i += 2){
+            CHECK(tree.remove(keys[i]) == taskStatus::SUCCESS);
+        }
+        for(size_t i = round % 2; i < keys.size(); i += 2){
+            handles[i] = tree.insert(keys[i]).ans();
+        }
+        for(size_t i = 0; i < keys.size(); i++){
+            CHECK(handles[i]->getData() == keys[i] && tree.find(keys[i]).ans() == handles[i]);
+        }
+    }
+}
+
+// NaN is not a key, and the padding, the biggest value, is a key like the others.
+void checkSpecialKeys(){
+    const char* name = "WideTree special keys";
+    WideTree<double> tree;
+    CHECK(tree.insert(std::nan("")).status() == taskStatus::INVALID_INPUT && tree.getSize() == 0);
+    WideTree<std::int64_t, 8> ints;
+    const std::int64_t biggest = std::numeric_limits<std::int64_t>::max();
+    for(std::int64_t key = 0; key < 100; key++){
+        CHECK(ints.insert(biggest - key).status() == taskStatus::SUCCESS);
+    }
+    CHECK(ints.find(biggest).ans() == biggest && ints.rank(biggest).ans() == 99);
+    CHECK(ints.insert(biggest).status() == taskStatus::FAILURE);
+    CHECK(ints.remove(biggest) == taskStatus::SUCCESS && ints.find(biggest).status() == taskStatus::FAILURE);
+}
+
+// without handles a key costs less than in Tree, with them more than without.
+void checkWideMemory(){
+    const char* name = "WideTree memory";
+    Tree<std::uint64_t> tree;
+    WideTree<std::uint64_t> wide;
+    WideTree<std::uint64_t, 16, true> handles;
+    for(std::uint64_t key = 0; key < 100000; key++){
+        std::uint64_t scrambled = key * 0x9E3779B97F4A7C15ull;
+        tree.insert(scrambled);
+        wide.insert(scrambled);
+        handles.insert(scrambled);
+    }
+    CHECK(wide.memoryPerNode() < tree.memoryPerNode());
+    CHECK(wide.memoryPerNode() < handles.memoryPerNode());
+}
+
+int main(){
+    std::mt19937 random(12345);
+    auto key = [](int key){return key;};
+    auto entryKey = [](const WideEntry<int>* entry){return entry->getData();};
+    checkWide<WideTree<int, 8>>("WideTree 8", 8, key, random);
+    checkWide<WideTree<int, 16>>("WideTree 16", 16, key, random);
+    checkWide<WideTree<int, 8, true>>("WideTree 8 handles", 8, entryKey, random);
+    checkWide<WideTree<int, 16, true>>("WideTree 16 handles", 16, entryKey, random);
+    checkHandles<8>(random);
+    checkHandles<16>(random);
+    checkSpecialKeys();
+    checkWideMemory();
+    return report();
+}
@@ -0,0 +1,114 @@
+/*
+this file checks SlidingWindow against a std::deque of the samples in the window: single samples and batches, a
+bound on the count and on the age, the quantiles after every push, and the clock at the ends of int64_t.
+
+build: g++ -O2 -std=c++17 -I.. window_tests.cpp -o window_tests
+*/
+
+#include "check.h"
+
+#include "AVLWindow.h"
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+// a sample with no default constructor, quantile must not need one.
+struct Reading{
+    int value_m;
+    explicit Reading(int value) : value_m(value){}
+    bool operator<(const Reading& other) const {return value_m < other.value_m;}
+};
+
+// the order of the window, for checkShape.
+bool operator<(const WindowSample<int>& first, const WindowSample<int>& second){
+    return WindowCompare<int, std::less<int>>()(first, second);
+}
+
+// the windows of a std::deque of samples, with a bound on the count and on the age, and batches bigger than the
+// window, that push out the whole window at once.
+void checkWindow(std::mt19937& random){
+    const char* name = "SlidingWindow";
+    const int capacity = 200;
+    const std::int64_t span = 50;
+    SlidingWindow<int> window(capacity, span);
+    std::deque<std::pair<int, std::int64_t>> reference;
+    std::int64_t now = 0;
+    const double levels[] = {0, 0.25, 0.5, 0.9, 0.99, 1};
+    for(int i = 0; i < 20000; i++){
+        now += static_cast<std::int64_t>(random() % 3 == 0) + (random() % 500 == 0 ? span : 0);
+        std::vector<int> values(random() % 4 == 0 ? random() % 300 : 1);
+        for(int& value : values){
+            value = static_cast<int>(random() % 1000);
+        }
+        while(!reference.empty() && now - reference.front().second >= span){
+            reference.pop_front();
+        }
+        size_t skip = values.size() > static_cast<size_t>(capacity) ? values.size() - capacity : 0;
+        while(!reference.empty() && reference.size() + values.size() - skip > static_cast<size_t>(capacity)){
+            reference.pop_front();
+        }
+        for(size_t j = skip; j < values.size(); j++){
+            reference.emplace_back(values[j], now);
+        }
+        taskStatus status = values.size() == 1 ? window.push(values[0], now) : window.push(values.begin(), values.end(), now);
+        CHECK(status == taskStatus::SUCCESS);
+        CHECK(window.getSize() == static_cast<int>(reference.size()));
+        std::vector<int> sorted;
+        for(const auto& sample : reference){
+            sorted.push_back(sample.first);
+        }
+        std::sort(sorted.begin(), sorted.end());
+        int answers[6];
+        CHECK((window.quantiles(std::begin(levels), std::end(levels), answers) == taskStatus::SUCCESS) == !sorted.empty());
+        for(int j = 0; j < 6 && !sorted.empty(); j++){
+            int size = static_cast<int>(sorted.size());
+            int rank = std::min(std::max(static_cast<int>(std::ceil(levels[j] * size)) - 1, 0), size - 1);
+            CHECK(answers[j] == sorted[rank]);
+            CHECK(window.quantile(levels[j]).ans() == sorted[rank]);
+        }
+        if(i % 1000 == 0){
+            checkShape(name, window.getTree().getRoot());
+        }
+    }
+    CHECK(window.push(0, now - 1) == taskStatus::INVALID_INPUT);
+    CHECK(window.quantile(-0.5).status() == taskStatus::INVALID_INPUT);
+    CHECK(window.quantile(std::nan("")).status() == taskStatus::INVALID_INPUT);
+    CHECK(window.expire(now + span) == taskStatus::SUCCESS && window.getSize() == 0);
+    CHECK(window.quantile(0.5).status() == taskStatus::INVALID_INPUT);
+}
+
+// the clock may start at the lowest int64_t and go to the highest, with no overflow in the age of a sample, and
+// quantile works for a T that has no default constructor.
+void checkWindowLimits(){
+    const char* name = "SlidingWindow limits";
+    const std::int64_t lowest = std::numeric_limits<std::int64_t>::min();
+    const std::int64_t highest = std::numeric_limits<std::int64_t>::max();
+    SlidingWindow<int> window(0, 10);
+    CHECK(window.push(1, lowest) == taskStatus::SUCCESS);
+    CHECK(window.push(2, lowest + 9) == taskStatus::SUCCESS && window.getSize() == 2);
+    CHECK(window.expire(lowest + 10) == taskStatus::SUCCESS && window.getSize() == 1);
+    CHECK(window.push(3, highest - 5) == taskStatus::SUCCESS && window.getSize() == 1);
+    CHECK(window.push(4, highest) == taskStatus::SUCCESS && window.getSize() == 2);
+    CHECK(window.quantile(0).ans() == 3 && window.quantile(1).ans() == 4);
+
+    SlidingWindow<Reading> readings(3);
+    for(int value : {5, 1, 4, 2}){
+        CHECK(readings.push(Reading(value)) == taskStatus::SUCCESS);
+    }
+    CHECK(readings.getSize() == 3 && readings.quantile(0.5).ans().value_m == 2);
+    CHECK(readings.findKthElement(0).ans().value_m == 1 && readings.findKthElement(3).status() != taskStatus::SUCCESS);
+    std::vector<Reading> batch = {Reading(9), Reading(8), Reading(7), Reading(6)};
+    CHECK(readings.push(batch.begin(), batch.end()) == taskStatus::SUCCESS);
+    CHECK(readings.getSize() == 3 && readings.quantile(0).ans().value_m == 6 && readings.quantile(1).ans().value_m == 8);
+}
+
+int main(){
+    std::mt19937 random(12345);
+    checkWindow(random);
+    checkWindowLimits();
+    return report();
+}